@@ -0,0 +1,470 @@
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <random>
+using namespace std;
+
+#define PI 3.14159265358979
+#define METERS_PER_DEGREE 111320.0		//length of a degree of latitude (in meters)
+#define CENTER_LAT 41.16884				//the generated networks are centred on Porto
+#define CENTER_LON -8.58329
+#define BLOCK_LENGTH 80					//distance between neighbouring intersections (in meters)
+#define ARTERIAL_SPACING 8				//blocks between arterial roads in hierarchical networks
+#define MOTORWAY_SPACING 4				//arterial roads between motorways in hierarchical networks
+#define GEOMETRIC_NEIGHBOURS 3			//nodes each node is connected to in random geometric networks
+#define SEGMENTS_PER_NAME 5				//segments sharing a street name in random geometric networks
+#define IMAGE_WIDTH 1131				//x resolution written to map.txt
+
+/**
+ * Kinds of networks that can be generated
+ */
+enum network_type_t
+{
+	GRID,			/// Square grid of local streets, each row and column being a street
+	GEOMETRIC,		/// Random points, each one connected to its nearest neighbours
+	HIERARCHICAL	/// Grid of motorways and arterial avenues, with blocks of (irregular) local streets between them
+};
+
+/**
+ * A road of the generated network, made of one or more segments
+ */
+struct generated_road_t
+{
+	string name;		/// name of the road
+	bool twoWay;		/// true if the road is a two-way street
+};
+
+/**
+ * The generated network, with coordinates in meters from the top left corner of its area
+ */
+struct network_t
+{
+	vector<double> x;					/// distance of each node to the west border (in meters)
+	vector<double> y;					/// distance of each node to the north border (in meters)
+	double width;						/// width of the area (in meters)
+	double height;						/// height of the area (in meters)
+	vector<generated_road_t> roads;		/// all roads
+	vector<int> segmentRoad;			/// road of each segment
+	vector<pair<int, int> > segments;	/// nodes of each segment, in the direction of travel if the road is one-way
+	vector<int> firstRoad;				/// for each node, the first road through it (-1 if none)
+	vector<int> secondRoad;				/// for each node, another road through it (-1 if none)
+};
+
+/**
+ * Pseudo-random numbers that are the same on every platform for the same seed
+ */
+class Random
+{
+private:
+	mt19937 engine;		/// the generator (its output is fully specified by the standard, unlike rand())
+
+public:
+	/**
+	 * Creates a generator
+	 * @param seed the seed
+	 */
+	Random(unsigned int seed): engine(seed){}
+
+	/**
+	 * Gets a number in [0, 1)
+	 * @return the number
+	 */
+	double real()
+	{
+		return engine() / 4294967296.0;
+	}
+
+	/**
+	 * Gets an integer in [0, n)
+	 * @param n amount of possible values
+	 * @return the integer
+	 */
+	long long integer(long long n)
+	{
+		return static_cast<long long>(real() * n);
+	}
+};
+
+const char* givenNames[] = { "Antonio", "Maria", "Jose", "Ana", "Manuel", "Joana", "Francisco", "Teresa",
+							"Joaquim", "Beatriz", "Fernando", "Ines", "Alberto", "Carolina", "Henrique", "Luisa" };
+const char* familyNames[] = { "Silva", "Santos", "Ferreira", "Pereira", "Oliveira", "Costa", "Rodrigues", "Martins",
+							"Sousa", "Fernandes", "Goncalves", "Gomes", "Lopes", "Marques", "Almeida", "Ribeiro",
+							"Pinto", "Carvalho", "Teixeira", "Moreira" };
+
+/**
+ * Builds a street name, different for every index (with a number once all names are taken)
+ * @param prefix kind of street (e.g. "Rua"), which determines the road class in proj2
+ * @param index index of the name
+ * @return the name
+ */
+string streetName(const string &prefix, long long index)
+{
+	const long long given = sizeof(givenNames) / sizeof(givenNames[0]);
+	const long long family = sizeof(familyNames) / sizeof(familyNames[0]);
+	ostringstream ss;
+	ss << prefix << " " << givenNames[index % given] << " " << familyNames[(index / given) % family];
+	if (index >= given * family)
+		ss << " " << index / (given * family) + 1;
+	return ss.str();
+}
+
+/**
+ * Adds a road to the network, choosing whether it is one-way
+ * @param net the network
+ * @param name name of the road
+ * @param oneWayRatio probability of the road being one-way
+ * @param rnd random numbers
+ * @return index of the road
+ */
+int addRoad(network_t &net, const string &name, double oneWayRatio, Random &rnd)
+{
+	generated_road_t r;
+	r.name = name;
+	r.twoWay = (rnd.real() >= oneWayRatio);
+	net.roads.push_back(r);
+	return net.roads.size() - 1;
+}
+
+/**
+ * Adds a segment to a road
+ * @param net the network
+ * @param road index of the road
+ * @param from first node
+ * @param to second node
+ */
+void addSegment(network_t &net, int road, int from, int to)
+{
+	net.segments.push_back(pair<int, int>(from, to));
+	net.segmentRoad.push_back(road);
+	int ends[] = { from, to };
+	for (int i = 0; i < 2; i++)
+	{
+		if (net.firstRoad.at(ends[i]) == -1)
+			net.firstRoad.at(ends[i]) = road;
+		else if (net.secondRoad.at(ends[i]) == -1 && net.firstRoad.at(ends[i]) != road)
+			net.secondRoad.at(ends[i]) = road;
+	}
+}
+
+/**
+ * Adds the nodes of a grid of intersections
+ * @param net the network
+ * @param width amount of columns
+ * @param height amount of rows
+ * @param jitter largest displacement of each node, as a fraction of BLOCK_LENGTH
+ * @param rnd random numbers
+ */
+void addGridNodes(network_t &net, int width, int height, double jitter, Random &rnd)
+{
+	net.width = width * BLOCK_LENGTH;
+	net.height = height * BLOCK_LENGTH;
+	for (int r = 0; r < height; r++)
+		for (int c = 0; c < width; c++)
+		{
+			net.x.push_back((c + 0.5 + jitter * (2 * rnd.real() - 1)) * BLOCK_LENGTH);
+			net.y.push_back((r + 0.5 + jitter * (2 * rnd.real() - 1)) * BLOCK_LENGTH);
+		}
+	net.firstRoad.assign(net.x.size(), -1);
+	net.secondRoad.assign(net.x.size(), -1);
+}
+
+/**
+ * Adds a straight road along a row or column of a grid, with its direction (if one-way) chosen at random
+ * @param net the network
+ * @param road index of the road
+ * @param nodes the nodes of the road, in order
+ * @param rnd random numbers
+ */
+void addGridRoad(network_t &net, int road, const vector<int> &nodes, Random &rnd)
+{
+	bool reverse = (!net.roads.at(road).twoWay && rnd.real() < 0.5);
+	for (int i = 0; i + 1 < nodes.size(); i++)
+	{
+		if (reverse)
+			addSegment(net, road, nodes.at(nodes.size() - 1 - i), nodes.at(nodes.size() - 2 - i));
+		else
+			addSegment(net, road, nodes.at(i), nodes.at(i + 1));
+	}
+}
+
+/**
+ * Generates a square grid where every row and column is a street
+ * @param net the (empty) network
+ * @param n amount of nodes (rounded up to fill the last row)
+ * @param oneWayRatio probability of each street being one-way
+ * @param rnd random numbers
+ */
+void generateGrid(network_t &net, long long n, double oneWayRatio, Random &rnd)
+{
+	int width = max(2, static_cast<int>(ceil(sqrt(static_cast<double>(n)))));
+	int height = max(2, static_cast<int>((n + width - 1) / width));
+	addGridNodes(net, width, height, 0, rnd);
+
+	long long names = 0;
+	for (int r = 0; r < height; r++)
+	{
+		vector<int> nodes;
+		for (int c = 0; c < width; c++)
+			nodes.push_back(r * width + c);
+		addGridRoad(net, addRoad(net, streetName("Rua", names++), oneWayRatio, rnd), nodes, rnd);
+	}
+	for (int c = 0; c < width; c++)
+	{
+		vector<int> nodes;
+		for (int r = 0; r < height; r++)
+			nodes.push_back(r * width + c);
+		addGridRoad(net, addRoad(net, streetName("Rua", names++), oneWayRatio, rnd), nodes, rnd);
+	}
+}
+
+/**
+ * Generates a grid of motorways and avenues crossing the whole area, with short local streets between them
+ * @param net the (empty) network
+ * @param n amount of nodes (rounded up to fill the last row)
+ * @param oneWayRatio probability of each road being one-way
+ * @param rnd random numbers
+ */
+void generateHierarchical(network_t &net, long long n, double oneWayRatio, Random &rnd)
+{
+	int width = max(2, static_cast<int>(ceil(sqrt(static_cast<double>(n)))));
+	int height = max(2, static_cast<int>((n + width - 1) / width));
+	addGridNodes(net, width, height, 0.2, rnd);
+
+	long long localNames = 0, mainNames = 0;
+	for (int dir = 0; dir < 2; dir++)
+	{
+		//dir 0 builds the rows and dir 1 the columns
+		int lines = (dir == 0 ? height : width), length = (dir == 0 ? width : height);
+		for (int l = 0; l < lines; l++)
+		{
+			vector<int> nodes;
+			for (int i = 0; i < length; i++)
+				nodes.push_back(dir == 0 ? l * width + i : i * width + l);
+
+			if (l % ARTERIAL_SPACING == 0)
+			{
+				//main roads cross the whole area
+				string prefix = (l % (ARTERIAL_SPACING * MOTORWAY_SPACING) == 0 ? "Via" : "Avenida");
+				addGridRoad(net, addRoad(net, streetName(prefix, mainNames++), oneWayRatio, rnd), nodes, rnd);
+				continue;
+			}
+
+			//local streets only go from one main road to the next one
+			for (int i = 0; i + 1 < length; i += ARTERIAL_SPACING)
+			{
+				vector<int> stretch(nodes.begin() + i, nodes.begin() + min(length, i + ARTERIAL_SPACING + 1));
+				addGridRoad(net, addRoad(net, streetName("Rua", localNames++), oneWayRatio, rnd), stretch, rnd);
+			}
+		}
+	}
+}
+
+/**
+ * Generates random points, each one connected to its nearest neighbours by a separate road
+ * @param net the (empty) network
+ * @param n amount of nodes
+ * @param oneWayRatio probability of each road being one-way
+ * @param rnd random numbers
+ */
+void generateGeometric(network_t &net, long long n, double oneWayRatio, Random &rnd)
+{
+	//same density as a grid with the same amount of nodes
+	double side = ceil(sqrt(static_cast<double>(n))) * BLOCK_LENGTH;
+	net.width = net.height = side;
+	for (long long i = 0; i < n; i++)
+	{
+		net.x.push_back(rnd.real() * side);
+		net.y.push_back(rnd.real() * side);
+	}
+	net.firstRoad.assign(n, -1);
+	net.secondRoad.assign(n, -1);
+
+	//bucket the nodes in cells of BLOCK_LENGTH, so the neighbours of a node are found in the cells around it
+	int cells = max(1, static_cast<int>(side / BLOCK_LENGTH));
+	vector<int> cellStart(cells * cells + 1, 0), cellNodes(n);
+	vector<int> cellOf(n);
+	for (long long i = 0; i < n; i++)
+	{
+		int cx = min(cells - 1, static_cast<int>(net.x.at(i) / BLOCK_LENGTH));
+		int cy = min(cells - 1, static_cast<int>(net.y.at(i) / BLOCK_LENGTH));
+		cellOf.at(i) = cy * cells + cx;
+		cellStart.at(cellOf.at(i) + 1)++;
+	}
+	for (int c = 0; c < cells * cells; c++)
+		cellStart.at(c + 1) += cellStart.at(c);
+	vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+	for (long long i = 0; i < n; i++)
+		cellNodes.at(fill.at(cellOf.at(i))++) = i;
+
+	vector<pair<int, int> > edges;
+	for (long long i = 0; i < n; i++)
+	{
+		int cx = cellOf.at(i) % cells, cy = cellOf.at(i) / cells;
+		vector<pair<double, int> > nearest;
+		//grow the ring of cells searched until it is farther than the neighbours already found
+		for (int ring = 1; ring <= cells; ring++)
+		{
+			nearest.clear();
+			for (int y = max(0, cy - ring); y <= min(cells - 1, cy + ring); y++)
+				for (int x = max(0, cx - ring); x <= min(cells - 1, cx + ring); x++)
+					for (int k = cellStart.at(y * cells + x); k < cellStart.at(y * cells + x + 1); k++)
+					{
+						int j = cellNodes.at(k);
+						if (j == i)
+							continue;
+						double dx = net.x.at(i) - net.x.at(j), dy = net.y.at(i) - net.y.at(j);
+						nearest.push_back(pair<double, int>(dx * dx + dy * dy, j));
+					}
+			int found = min(GEOMETRIC_NEIGHBOURS, static_cast<int>(nearest.size()));
+			partial_sort(nearest.begin(), nearest.begin() + found, nearest.end());
+			nearest.resize(found);
+			double reach = ring * BLOCK_LENGTH;
+			if (found == GEOMETRIC_NEIGHBOURS && nearest.back().first <= reach * reach)
+				break;
+		}
+		for (int k = 0; k < nearest.size(); k++)
+			edges.push_back(pair<int, int>(min<int>(i, nearest.at(k).second), max<int>(i, nearest.at(k).second)));
+	}
+	sort(edges.begin(), edges.end());
+	edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+	//every segment is a road, and consecutive roads share a name
+	for (int i = 0; i < edges.size(); i++)
+	{
+		int road = addRoad(net, streetName("Rua", i / SEGMENTS_PER_NAME), oneWayRatio, rnd);
+		if (!net.roads.at(road).twoWay && rnd.real() < 0.5)
+			addSegment(net, road, edges.at(i).second, edges.at(i).first);
+		else
+			addSegment(net, road, edges.at(i).first, edges.at(i).second);
+	}
+}
+
+/**
+ * Writes the network in the formats read by proj2
+ * @param net the network
+ * @param markets amount of markets to place, on random nodes crossed by at least one road
+ * @param dir directory of the files (ending in a separator, or empty)
+ * @param rnd random numbers
+ * @return true if all files were written, false otherwise
+ */
+bool writeNetwork(const network_t &net, int markets, const string &dir, Random &rnd)
+{
+	double lonScale = METERS_PER_DEGREE * cos(CENTER_LAT * PI / 180);
+	double top = CENTER_LAT + net.height / 2 / METERS_PER_DEGREE;
+	double bottom = CENTER_LAT - net.height / 2 / METERS_PER_DEGREE;
+	double left = CENTER_LON - net.width / 2 / lonScale;
+	double right = CENTER_LON + net.width / 2 / lonScale;
+
+	ofstream nodes((dir + "nodes.txt").c_str());
+	ofstream roadInfo((dir + "road_info.txt").c_str());
+	ofstream roads((dir + "roads.txt").c_str());
+	ofstream market((dir + "markets.txt").c_str());
+	ofstream map((dir + "map.txt").c_str());
+	if (!nodes.is_open() || !roadInfo.is_open() || !roads.is_open() || !market.is_open() || !map.is_open())
+		return false;
+
+	//same layout as the OpenStreetMaps extracts: id;lat;long;long (radians);lat (radians)
+	nodes.precision(9);
+	for (int i = 0; i < net.x.size(); i++)
+	{
+		double lat = top - net.y.at(i) / METERS_PER_DEGREE;
+		double lon = left + net.x.at(i) / lonScale;
+		nodes << i + 1 << ";" << lat << ";" << lon << ";" << lon * PI / 180 << ";" << lat * PI / 180 << "\n";
+	}
+
+	for (int i = 0; i < net.roads.size(); i++)
+		roadInfo << i + 1 << ";" << net.roads.at(i).name << ";" << (net.roads.at(i).twoWay ? "True" : "False") << "\n";
+
+	for (int i = 0; i < net.segments.size(); i++)
+		roads << net.segmentRoad.at(i) + 1 << ";" << net.segments.at(i).first + 1 << ";" << net.segments.at(i).second + 1 << ";\n";
+
+	vector<int> candidates;
+	for (int i = 0; i < net.x.size(); i++)
+		if (net.firstRoad.at(i) != -1)
+			candidates.push_back(i);
+	for (int i = 0; i < markets && !candidates.empty(); i++)
+	{
+		int k = rnd.integer(candidates.size());
+		int v = candidates.at(k);
+		candidates.at(k) = candidates.back();
+		candidates.pop_back();
+
+		int second = (net.secondRoad.at(v) != -1 ? net.secondRoad.at(v) : net.firstRoad.at(v));
+		market << v + 1 << " " << streetName("Mercado", i) << " ; " << net.roads.at(net.firstRoad.at(v)).name;
+		market << " ; " << net.roads.at(second).name << "\n";
+	}
+
+	//there is no background picture for a generated network, its size only keeps the aspect ratio
+	int yRes = max(1, static_cast<int>(IMAGE_WIDTH * net.height / net.width));
+	map.precision(9);
+	map << dir << "mapArea.png\n";
+	map << top << "," << left << "\t//top left corner\n";
+	map << bottom << "," << left << "\t//bottom left corner\n";
+	map << top << "," << right << "\t//top right corner\n";
+	map << IMAGE_WIDTH << " " << yRes << "\t\t\t//image resolution\n";
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	network_type_t type = GRID;
+	long long n = 10000;
+	double oneWayRatio = 0.2;
+	int markets = 3;
+	unsigned int seed = 1;
+	string dir = "";
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		string value = hasValue ? argv[i + 1] : "";
+		if (arg == "--type" && (value == "grid" || value == "geometric" || value == "hierarchical"))
+			type = (value == "grid" ? GRID : value == "geometric" ? GEOMETRIC : HIERARCHICAL);
+		else if (arg == "--nodes" && hasValue)
+			n = atoll(value.c_str());
+		else if (arg == "--one-way" && hasValue)
+			oneWayRatio = atof(value.c_str());
+		else if (arg == "--markets" && hasValue)
+			markets = atoi(value.c_str());
+		else if (arg == "--seed" && hasValue)
+			seed = atoi(value.c_str());
+		else if (arg == "--out" && hasValue)
+			dir = value;
+		else
+		{
+			cout << "Usage: Generator [--type grid|geometric|hierarchical] [--nodes n] [--one-way ratio]\n";
+			cout << "                 [--markets n] [--seed n] [--out dir]\n";
+			cout << "Writes nodes.txt, road_info.txt, roads.txt, markets.txt and map.txt to an existing directory\n";
+			return 1;
+		}
+		i++;
+	}
+	if (n < 4)
+		n = 4;
+	if (!dir.empty() && dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+		dir += '/';
+
+	Random rnd(seed);
+	network_t net;
+	if (type == GRID)
+		generateGrid(net, n, oneWayRatio, rnd);
+	else if (type == GEOMETRIC)
+		generateGeometric(net, n, oneWayRatio, rnd);
+	else
+		generateHierarchical(net, n, oneWayRatio, rnd);
+
+	if (!writeNetwork(net, markets, dir, rnd))
+	{
+		cout << "Could not write the files to \"" << dir << "\", does the directory exist?\n";
+		return 1;
+	}
+	cout << net.x.size() << " nodes, " << net.segments.size() << " segments and " << net.roads.size() << " roads written to \"";
+	cout << dir << "\"\n";
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include "Benchmark.h"
+#include "StringFunctions.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static atomic<long long> allocationCount(0);		//calls to operator new so far
+
+//the global allocation functions are replaced so that benchmarks can tell how much they allocate
+void* operator new(size_t size)
+{
+	allocationCount++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t &) noexcept
+{
+	allocationCount++;
+	return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const nothrow_t &) noexcept
+{
+	return operator new(size, nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+long long getAllocationCount()
+{
+	return allocationCount.load();
+}
+
+Benchmark::Benchmark(int warmup, int repetitions): warmup(warmup), repetitions(repetitions), suite(""){}
+
+void Benchmark::setSuite(const string &suite)
+{
+	this->suite = suite;
+}
+
+const benchmark_result_t &Benchmark::run(const string &name, long long size, function<void()> f, int repetitions)
+{
+	if (repetitions < 1)
+		repetitions = this->repetitions;
+
+	for (int i = 0; i < warmup; i++)
+		f();
+
+	vector<double> times;
+	times.reserve(repetitions);
+	long long allocations = 0;
+	for (int i = 0; i < repetitions; i++)
+	{
+		long long before = getAllocationCount();
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		f();
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		allocations += getAllocationCount() - before;
+		times.push_back(chrono::duration<double, micro>(end - start).count());
+	}
+	sort(times.begin(), times.end());
+
+	benchmark_result_t r;
+	r.suite = suite;
+	r.name = name;
+	r.size = size;
+	r.repetitions = repetitions;
+	r.min = times.front();
+	r.max = times.back();
+	r.median = (times.size() % 2 == 1 ? times.at(times.size() / 2) :
+				(times.at(times.size() / 2 - 1) + times.at(times.size() / 2)) / 2);
+	r.mean = 0;
+	for (int i = 0; i < times.size(); i++)
+		r.mean += times.at(i);
+	r.mean /= times.size();
+	r.stddev = 0;
+	for (int i = 0; i < times.size(); i++)
+		r.stddev += (times.at(i) - r.mean) * (times.at(i) - r.mean);
+	r.stddev = sqrt(r.stddev / times.size());
+	r.allocations = (double)allocations / repetitions;
+	results.push_back(r);
+
+	//the formatting of cerr is put back afterwards, so that other messages are not printed with it
+	ios_base::fmtflags flags = cerr.flags();
+	streamsize precision = cerr.precision();
+	cerr << left << setw(10) << suite << setw(40) << name << right << setw(12) << size;
+	cerr << fixed << setprecision(1) << setw(14) << r.median << " us (+/- " << r.stddev << ")";
+	cerr << setw(12) << r.allocations << " allocs\n";
+	cerr.flags(flags);
+	cerr.precision(precision);
+	return results.back();
+}
+
+const vector<benchmark_result_t> &Benchmark::getResults() const
+{
+	return results;
+}
+
+string Benchmark::escapeCSV(const string &s)
+{
+	string res;
+	for (int i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '"')
+			res += '"';
+		res += s[i];
+	}
+	return res;
+}
+
+void Benchmark::writeCSV(ostream &out) const
+{
+	out << "suite,name,size,repetitions,min_us,median_us,mean_us,stddev_us,max_us,allocations\n";
+	out << fixed << setprecision(3);
+	for (int i = 0; i < results.size(); i++)
+	{
+		const benchmark_result_t &r = results.at(i);
+		out << "\"" << escapeCSV(r.suite) << "\",\"" << escapeCSV(r.name) << "\"," << r.size << "," << r.repetitions << ",";
+		out << r.min << "," << r.median << "," << r.mean << "," << r.stddev << "," << r.max << "," << r.allocations << "\n";
+	}
+}
+
+void Benchmark::writeJSON(ostream &out) const
+{
+	out << "[\n";
+	out << fixed << setprecision(3);
+	for (int i = 0; i < results.size(); i++)
+	{
+		const benchmark_result_t &r = results.at(i);
+		out << "  {\"suite\": \"" << escapeJSON(r.suite) << "\", \"name\": \"" << escapeJSON(r.name) << "\", ";
+		out << "\"size\": " << r.size << ", \"repetitions\": " << r.repetitions << ", ";
+		out << "\"min_us\": " << r.min << ", \"median_us\": " << r.median << ", \"mean_us\": " << r.mean << ", ";
+		out << "\"stddev_us\": " << r.stddev << ", \"max_us\": " << r.max << ", \"allocations\": " << r.allocations << "}";
+		out << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "]\n";
+}
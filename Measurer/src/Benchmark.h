@@ -0,0 +1,115 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+using namespace std;
+
+/**
+ * Statistics of the repetitions of a benchmark case (all times in microseconds)
+ */
+struct benchmark_result_t
+{
+	string suite;		/// group of the case (e.g. "strings" or "graph")
+	string name;		/// name of the case
+	long long size;		/// size of the input of the case (its meaning depends on the case)
+	int repetitions;	/// amount of timed repetitions
+	double min;			/// fastest repetition
+	double median;		/// median of the repetitions
+	double mean;		/// average of the repetitions
+	double stddev;		/// standard deviation of the repetitions
+	double max;			/// slowest repetition
+	double allocations;	/// average amount of memory allocations (operator new) per repetition
+};
+
+/**
+ * Runs benchmark cases and keeps their results.
+ * Each case is run a few times without being timed (to warm up caches and the allocator) and then
+ * timed on each repetition with std::chrono::steady_clock, so the results are portable and have
+ * sub-microsecond resolution. The memory allocations made by each repetition are counted too, by the
+ * global operator new replaced in Benchmark.cpp
+ */
+class Benchmark
+{
+private:
+	int warmup;								/// untimed runs of each case
+	int repetitions;						/// timed runs of each case
+	string suite;							/// suite of the cases being run
+	vector<benchmark_result_t> results;		/// results of all cases run so far
+
+	/**
+	 * Escapes a string to be written inside quotes in CSV (quotes are doubled)
+	 * @param s the string
+	 * @return the escaped string
+	 */
+	static string escapeCSV(const string &s);
+
+public:
+	/**
+	 * Creates a benchmark
+	 * @param warmup untimed runs of each case
+	 * @param repetitions timed runs of each case
+	 */
+	Benchmark(int warmup, int repetitions);
+
+	/**
+	 * Sets the suite of the cases run from now on
+	 * @param suite name of the suite
+	 */
+	void setSuite(const string &suite);
+
+	/**
+	 * Runs a case, printing and keeping its statistics
+	 * @param name name of the case
+	 * @param size size of the input of the case
+	 * @param f function that runs the case once
+	 * @param repetitions timed runs, or -1 to use the value given to the constructor (for slow cases)
+	 * @return the statistics of the case
+	 */
+	const benchmark_result_t &run(const string &name, long long size, function<void()> f, int repetitions = -1);
+
+	/**
+	 * Gets the results of all cases run so far
+	 * @return reference to Benchmark::results
+	 */
+	const vector<benchmark_result_t> &getResults() const;
+
+	/**
+	 * Writes the results as CSV, with a header line
+	 * @param out stream to write to
+	 */
+	void writeCSV(ostream &out) const;
+
+	/**
+	 * Writes the results as a JSON array of objects
+	 * @param out stream to write to
+	 */
+	void writeJSON(ostream &out) const;
+};
+
+/**
+ * Gets the amount of memory allocations (calls to operator new, from any thread) since the program started
+ * @return the amount of allocations
+ */
+long long getAllocationCount();
+
+/**
+ * Keeps the compiler from optimising away a value computed by a benchmark case: the value is handed to an
+ * empty inline assembly statement that may read it and any memory, so it must be computed and stored before it
+ * @param value the value
+ */
+template <class T>
+void doNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(value) : "memory");
+#else
+	//compilers without GNU inline assembly (MSVC) must still read the value, through a volatile access
+	volatile char sink = *reinterpret_cast<const volatile char*>(&value);
+	(void)sink;
+#endif
+}
+
+#endif /* BENCHMARK_H_ */
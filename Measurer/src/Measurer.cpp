@@ -1,13 +1,23 @@
 #include <cstdlib>
 #include <climits>
-#include <Windows.h>
+#include <cstring>
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <vector>
 #include <ctime>
+#include <cstdio>
+#include "Benchmark.h"
 #include "StringFunctions.h"
+#include "Program.h"
+#include "Exceptions.h"
 using namespace std;
 
+#define DEFAULT_WARMUP 2
+#define DEFAULT_REPETITIONS 10
+#define DEFAULT_RES_DIR "../proj2/res/"
+
 string* randomStr(int size)
 {
 	string* s = new string(size, '\0');
@@ -16,98 +26,380 @@ string* randomStr(int size)
 	return s;
 }
 
-void measureTimeExact1()
+string* mutate(const string &s, int edits)
 {
-	vector<long int> time;
-	vector<int> size;
+	string* res = new string(s);
+	for (int i = 0; i < edits && !res->empty(); i++)
+		res->at(rand() % res->size()) = (char)(33 + rand() % 94);
+	return res;
+}
 
-	for (long long i = 10000; i < UINT_MAX; i *= 10)
+vector<string> randomNames(int n)
+{
+	vector<string> names;
+	for (int i = 0; i < n; i++)
+	{
+		string* s = randomStr(10 + rand() % 20);
+		names.push_back(*s);
+		delete s;
+	}
+	return names;
+}
+
+void measureExact(Benchmark &b, bool large)
+{
+	b.setSuite("strings");
+	for (long long i = 1000000; i <= (large ? 100000000 : 10000000); i *= 10)
 	{
+		//the pattern never occurs in the text (it has a character outside of the text's alphabet),
+		//so the whole text is scanned by every search
 		string* s = randomStr(i);
 		string* t = randomStr(100);
-		long int start = GetTickCount();
-		kmpStringMatching(*s, *t, true);
-		long int end = GetTickCount();
+		t->at(t->size() / 2) = '\n';
+		b.run("kmpStringMatching", i, [&]() { doNotOptimize(kmpStringMatching(*s, *t, true)); });
+		b.run("kmpStringMatching (no case)", i, [&]() { doNotOptimize(kmpStringMatching(*s, *t, false)); });
+		b.run("exactStringMatching", i, [&]() { doNotOptimize(exactStringMatching(*s, *t, true)); });
+		b.run("exactStringMatching (no case)", i, [&]() { doNotOptimize(exactStringMatching(*s, *t, false)); });
 		delete s;
 		delete t;
-		time.push_back(end - start);
-		size.push_back(i);
-	}
-	cout << "Exact search: variable text size, fixed pattern size:\n[";
-	for (int i = 0; i < time.size(); i++)
-		cout << time.at(i) << ", ";
-	cout << "],\n[";
-	for (int i = 0; i < size.size(); i++)
-		cout << size.at(i) << ", ";
-	cout << "]\n";
+	}
 }
 
-void measureTimeExact2()
+void measureApprox(Benchmark &b)
 {
-	vector<long int> time;
-	vector<int> size;
-
-	for (long long i = 10; i < 1e6; i *= 7)
+	b.setSuite("strings");
+	for (long long i = 100; i <= 10000; i *= 10)
 	{
-		string* s = randomStr(1e6);
+		string* s = randomStr(i);
 		string* t = randomStr(i);
-		long int start = GetTickCount();
-		kmpStringMatching(*s, *t, true);
-		long int end = GetTickCount();
+		b.run("levenshtein_distance_dp", i, [&]() { doNotOptimize(levenshtein_distance_dp(*s, *t, true)); }, i < 10000 ? -1 : 3);
+		b.run("levenshtein_distance", i, [&]() { doNotOptimize(levenshtein_distance(*s, *t, true)); });
 		delete s;
 		delete t;
-		time.push_back(end - start);
-		size.push_back(i);
-	}
-	cout << "Exact search: variable pattern size, fixed text size:\n[";
-	for (int i = 0; i < time.size(); i++)
-		cout << time.at(i) << ", ";
-	cout << "],\n[";
-	for (int i = 0; i < size.size(); i++)
-		cout << size.at(i) << ", ";
-	cout << "]\n";
+	}
+
+	for (int i = 1000; i <= 100000; i *= 10)
+	{
+		vector<string> names = randomNames(i);
+		NGramIndex ngrams(names);
+		BKTree bk(names);
+		string* pattern = mutate(names.at(rand() % names.size()), 2);
+
+		b.run("approximateStringMatching", i, [&]() { doNotOptimize(approximateStringMatching(names, *pattern, true)); });
+		b.run("NGramIndex::search", i, [&]() { doNotOptimize(ngrams.search(*pattern, true, 10)); });
+		b.run("BKTree::search", i, [&]() { doNotOptimize(bk.search(*pattern, true, 2)); });
+		delete pattern;
+	}
 }
 
-void measureTimeApprox1()
+void measureIndexes(Benchmark &b)
 {
-	vector<long int> time;
-	vector<int> size;
-
-	string* s = randomStr(100);
-	string* t = randomStr(100);
-	long int start = GetTickCount();
-	levenshtein_distance(*s, *t, true);
-	long int end = GetTickCount();
-	delete s;
-	delete t;
-	time.push_back(end - start);
-	size.push_back(100);
-
-	for (long long i = 100000; i < 1000000; i *= 1.2)
-	{
-		s = randomStr(i);
-		t = randomStr(i);
-		long int start = GetTickCount();
-		levenshtein_distance(*s, *t, true);
-		long int end = GetTickCount();
-		delete s;
-		delete t;
-		time.push_back(end - start);
-		size.push_back(i);
-	}
-	cout << "Approx search:\n[";
-	for (int i = 0; i < time.size(); i++)
-		cout << time.at(i) << ", ";
-	cout << "],\n[";
-	for (int i = 0; i < size.size(); i++)
-		cout << size.at(i) << ", ";
-	cout << "]\n";
+	b.setSuite("strings");
+	//the automaton has a transition table entry per node and symbol, so it is not built for larger vocabularies
+	for (int i = 1000; i <= 10000; i *= 10)
+	{
+		vector<string> names = randomNames(i);
+		vector<int> weights;
+		for (int j = 0; j < i; j++)
+			weights.push_back(rand() % 100);
+
+		b.run("AhoCorasick (build)", i, [&]() { AhoCorasick a(names); doNotOptimize(a); }, 3);
+		b.run("CompletionTrie (build)", i, [&]() { CompletionTrie c(names, weights, 10); doNotOptimize(c); }, 3);
+
+		AhoCorasick automaton(names);
+		CompletionTrie trie(names, weights, 10);
+		string text = names.at(rand() % i) + " and " + names.at(rand() % i);
+		string prefix = names.at(rand() % i).substr(0, 2);
+		b.run("AhoCorasick::search", i, [&]() { doNotOptimize(automaton.search(text, false)); });
+		b.run("CompletionTrie::complete", i, [&]() { doNotOptimize(trie.complete(prefix, 10)); });
+	}
 }
 
-int main()
+void measureLandmarks(Benchmark &b, Graph<RoadNode> &g, const vector<pair<RoadNode, RoadNode> > &pairs, const string &name)
 {
-	srand(time(NULL));
-//	measureTimeExact1();
-	measureTimeExact2();
-//	measureTimeApprox1();
+	b.run("dijkstraShortestPath (" + name + ", pairs)", pairs.size(), [&]() {
+		for (int i = 0; i < pairs.size(); i++)
+			doNotOptimize(g.dijkstraShortestPath(pairs.at(i).first, pairs.at(i).second));
+	});
+	vector<int> dist(pairs.size());
+	long long dijkstraSpace = 0;
+	for (int i = 0; i < pairs.size(); i++)
+	{
+		dist.at(i) = g.dijkstraShortestPath(pairs.at(i).first, pairs.at(i).second);
+		dijkstraSpace += g.getSearchSpace();
+	}
+
+	const char* selections[] = { "farthest", "avoid" };
+	for (int s = 0; s < NUM_LANDMARK_SELECTIONS; s++)
+	{
+		string kind = selections[s];
+		b.run("computeLandmarks (" + name + ", " + kind + ")", g.getNumVertex(), [&]() {
+			doNotOptimize(g.computeLandmarks(ALT_LANDMARKS, (landmark_selection_t)s));
+		}, 1);
+		alt_landmarks_t lm = g.computeLandmarks(ALT_LANDMARKS, (landmark_selection_t)s);
+		b.run("altShortestPath (" + name + ", " + kind + ", pairs)", pairs.size(), [&]() {
+			for (int i = 0; i < pairs.size(); i++)
+				doNotOptimize(g.altShortestPath(lm, pairs.at(i).first, pairs.at(i).second));
+		});
+
+		//search space: vertexes settled by A* against those settled by Dijkstra's algorithm, for the same distances
+		long long altSpace = 0;
+		int wrong = 0;
+		for (int i = 0; i < pairs.size(); i++)
+		{
+			if (g.altShortestPath(lm, pairs.at(i).first, pairs.at(i).second) != dist.at(i))
+				wrong++;
+			altSpace += g.getSearchSpace();
+		}
+		cerr << "ALT (" << name << ", " << kind << "): " << altSpace << " vertexes settled against " << dijkstraSpace
+				<< " (" << (dijkstraSpace == 0 ? 0 : 100.0 * altSpace / dijkstraSpace) << "%)";
+		if (wrong != 0)
+			cerr << ", " << wrong << " distances differ";
+		cerr << "\n";
+	}
+}
+
+void measureGraph(Benchmark &b, const string &resDir)
+{
+	b.setSuite("graph");
+	string files[] = { "", resDir + "nodes.txt", resDir + "road_info.txt", resDir + "roads.txt",
+						resDir + "markets.txt", resDir + "map.txt" };
+	char* filenames[6];
+	for (int i = 0; i < 6; i++)
+		filenames[i] = const_cast<char*>(files[i].c_str());
+
+	Program* p = NULL;
+	try
+	{
+		p = new Program(filenames, false);
+	}
+	catch (FileNotFound* ex)
+	{
+		cerr << "File " << ex->filename << " not found, skipping the graph benchmarks\n";
+		return;
+	}
+	Graph<RoadNode> &g = p->getGraph();
+	const vector<RoadNode> &markets = p->getMarkets();
+
+	b.run("load (res)", g.getNumVertex(), [&]() { Program q(filenames, false); doNotOptimize(q); }, 3);
+	b.run("dijkstraShortestPath (res, per market)", g.getNumVertex(), [&]() {
+		for (int i = 0; i < markets.size(); i++)
+			g.dijkstraShortestPath(markets.at(i));
+	});
+	b.run("computeShortestPathTree (res, per market)", g.getNumVertex(), [&]() {
+		for (int i = 0; i < markets.size(); i++)
+			doNotOptimize(g.computeShortestPathTree(markets.at(i)));
+	});
+	b.run("CoreGraph (build, res)", g.getNumVertex(), [&]() { CoreGraph c(g); doNotOptimize(c); });
+	b.run("CoreGraph::computeShortestPathTree (res, per market)", g.getNumVertex(), [&]() {
+		for (int i = 0; i < markets.size(); i++)
+			doNotOptimize(p->getCoreGraph().computeShortestPathTree(markets.at(i)));
+	});
+	b.run("Program::getTree (res, per market, cached)", g.getNumVertex(), [&]() {
+		for (int i = 0; i < markets.size(); i++)
+			doNotOptimize(p->getTree(markets.at(i)));
+	});
+	b.run("Program::getTree (res, per market, cleared)", g.getNumVertex(), [&]() {
+		p->getTreeCache().clear();
+		for (int i = 0; i < markets.size(); i++)
+			doNotOptimize(p->getTree(markets.at(i)));
+	});
+
+	//hub labels: built once, written to a file and mapped back, then queried for random pairs of nodes
+	b.run("HubLabels (build, res)", g.getNumVertex(), [&]() { HubLabels h; h.build(g); doNotOptimize(h); }, 1);
+	string labelsFile = "measurer.labels";
+	HubLabels built;
+	built.build(g);
+	built.save(labelsFile);
+	b.run("HubLabels::load (res, mapped)", g.getNumVertex(), [&]() { HubLabels h; h.load(labelsFile, g); doNotOptimize(h); });
+	HubLabels labels;
+	labels.load(labelsFile, g);
+	vector<pair<int, int> > pairs;
+	for (int i = 0; i < 1000; i++)
+		pairs.push_back(pair<int, int>(rand() % g.getNumVertex(), rand() % g.getNumVertex()));
+	b.run("HubLabels::distance (res, pairs)", pairs.size(), [&]() {
+		for (int i = 0; i < pairs.size(); i++)
+			doNotOptimize(labels.distance(pairs.at(i).first, pairs.at(i).second));
+	});
+	remove(labelsFile.c_str());
+
+	//turn rules: no U-turns at any junction of three or more roads, written to a file and loaded back
+	string turnsFile = "measurer.turns";
+	ofstream turnsOut(turnsFile.c_str());
+	for (int i = 0; i < g.getNumVertex(); i++)
+	{
+		const Vertex<RoadNode>* v = g.getVertexSet().at(i);
+		if (v->getAdj().size() < 3)
+			continue;
+		for (int j = 0; j < v->getAdj().size(); j++)
+		{
+			const Vertex<RoadNode>* w = v->getAdj().at(j).getDest();
+			for (int k = 0; k < v->getIncoming().size(); k++)
+				if (v->getIncoming().at(k).first == w)
+					turnsOut << w->getInfo().getID() << ";" << v->getInfo().getID() << ";" << w->getInfo().getID() << ";no\n";
+		}
+	}
+	turnsOut.close();
+	b.run("TurnGraph::load (res, no U-turns)", g.getNumVertex(), [&]() { TurnGraph t(g); t.load(turnsFile); doNotOptimize(t); });
+	TurnGraph turns(g);
+	turns.load(turnsFile);
+	b.run("TurnGraph::computeShortestPathTree (res, per market)", g.getNumVertex(), [&]() {
+		for (int i = 0; i < markets.size(); i++)
+			doNotOptimize(turns.computeShortestPathTree(markets.at(i)));
+	});
+	cerr << "TurnGraph (res, no U-turns): " << turns.getNumRules() << " rules, " << turns.getNumStates() <<
+			" turn states for " << g.getNumVertex() << " vertexes\n";
+	remove(turnsFile.c_str());
+
+	//ALT: the same random pairs searched by Dijkstra's algorithm and by A* with each kind of landmarks
+	vector<pair<RoadNode, RoadNode> > nodePairs;
+	for (int i = 0; i < 100; i++)
+		nodePairs.push_back(pair<RoadNode, RoadNode>(g.getVertexSet().at(pairs.at(i).first)->getInfo(),
+				g.getVertexSet().at(pairs.at(i).second)->getInfo()));
+	measureLandmarks(b, g, nodePairs, "res");
+
+	for (int n = 100; n <= 1000; n *= 10)
+	{
+		p->generatePurchases(n);
+		b.run("checkValidMarkets (res)", n, [&]() { p->checkValidMarkets(); });
+		//the whole planning of a batch job, with the client lists, the routes and the planner's buffers kept
+		//between repetitions (once the warm-up runs grew them, neither step allocates memory)
+		vector<vector<RoadNode> > marketClients(markets.size());
+		vector<vector<truck_route_t> > routes(markets.size());
+		plan_scratch_t scratch;
+		b.run("truck planning (res, all markets)", n, [&]() {
+			p->setClosestMarketToAllClients();
+			for (int i = 0; i < markets.size(); i++)
+				marketClients.at(i).clear();
+			for (int j = 0; j < p->getPurchases().size(); j++)
+				if (p->getPurchases().at(j).getClosestMarketDist() != INT_INFINITY)
+					marketClients.at(p->getPurchases().at(j).getClosestMarketIndex()).push_back(p->getPurchases().at(j).getAddr());
+			for (int i = 0; i < markets.size(); i++)
+			{
+				p->planMarketRoutes(i, marketClients.at(i), routes.at(i), scratch);
+				doNotOptimize(routes.at(i));
+			}
+		});
+
+		//the planner alone, with the client lists made by the case above
+		b.run("planMarketRoutes (res, all markets)", n, [&]() {
+			for (int i = 0; i < markets.size(); i++)
+			{
+				p->planMarketRoutes(i, marketClients.at(i), routes.at(i), scratch);
+				doNotOptimize(routes.at(i));
+			}
+		});
+	}
+	delete p;
+}
+
+void measureGeneratedGraph(Benchmark &b)
+{
+	b.setSuite("graph");
+	for (int n = 50; n <= 200; n *= 2)
+	{
+		//n x n grid with two-way streets, 100 meters long
+		Graph<RoadNode> g;
+		for (int i = 0; i < n * n; i++)
+			g.addVertex(RoadNode(i, 0, 0, 0, 0));
+		for (int i = 0; i < n; i++)
+			for (int j = 0; j < n; j++)
+			{
+				RoadNode v(i * n + j, 0, 0, 0, 0);
+				if (j + 1 < n)
+				{
+					g.addEdge(v, RoadNode(i * n + j + 1, 0, 0, 0, 0), 100, i * n + j);
+					g.addEdge(RoadNode(i * n + j + 1, 0, 0, 0, 0), v, 100, i * n + j);
+				}
+				if (i + 1 < n)
+				{
+					g.addEdge(v, RoadNode((i + 1) * n + j, 0, 0, 0, 0), 100, n * n + i * n + j);
+					g.addEdge(RoadNode((i + 1) * n + j, 0, 0, 0, 0), v, 100, n * n + i * n + j);
+				}
+			}
+		RoadNode source(rand() % (n * n), 0, 0, 0, 0);
+		b.run("dijkstraShortestPath (grid)", n * n, [&]() { g.dijkstraShortestPath(source); });
+		b.run("computeShortestPathTree (grid)", n * n, [&]() { doNotOptimize(g.computeShortestPathTree(source)); });
+		vector<pair<RoadNode, RoadNode> > pairs;
+		for (int i = 0; i < 100; i++)
+			pairs.push_back(pair<RoadNode, RoadNode>(RoadNode(rand() % (n * n), 0, 0, 0, 0), RoadNode(rand() % (n * n), 0, 0, 0, 0)));
+		measureLandmarks(b, g, pairs, "grid");
+
+		//grid drawn 4 pixels apart, simplified at the scale where each node gets its own cell and at 1/8 of it
+		vector<pair<float, float> > points;
+		for (int i = 0; i < n * n; i++)
+			points.push_back(pair<float, float>((i % n) * 4, (i / n) * 4));
+		b.run("LevelOfDetail (build, grid)", n * n, [&]() { LevelOfDetail l(g, points, vector<bool>()); doNotOptimize(l); });
+		LevelOfDetail lod(g, points, vector<bool>());
+		b.run("LevelOfDetail::getLevel (grid, 1:1)", n * n, [&]() { doNotOptimize(lod.getLevel(LOD_CELL_SIZE / 4.0f)); });
+		b.run("LevelOfDetail::getLevel (grid, 1:8)", n * n, [&]() { doNotOptimize(lod.getLevel(LOD_CELL_SIZE / 32.0f)); });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int warmup = DEFAULT_WARMUP, repetitions = DEFAULT_REPETITIONS;
+	unsigned int seed = 1;
+	string csvFile = "", jsonFile = "", resDir = DEFAULT_RES_DIR, suites = "strings,graph";
+	bool large = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--warmup" && hasValue)
+			warmup = atoi(argv[++i]);
+		else if (arg == "--reps" && hasValue)
+			repetitions = atoi(argv[++i]);
+		else if (arg == "--seed" && hasValue)
+			seed = atoi(argv[++i]);
+		else if (arg == "--csv" && hasValue)
+			csvFile = argv[++i];
+		else if (arg == "--json" && hasValue)
+			jsonFile = argv[++i];
+		else if (arg == "--res" && hasValue)
+			resDir = argv[++i];
+		else if (arg == "--suites" && hasValue)
+			suites = argv[++i];
+		else if (arg == "--large")
+			large = true;
+		else
+		{
+			cout << "Usage: Measurer [--warmup n] [--reps n] [--seed n] [--csv file] [--json file]\n";
+			cout << "                [--res dir] [--suites strings,graph] [--large]\n";
+			cout << "--large uses texts of up to 100MB in the exact search benchmarks\n";
+			cout << "Without --csv or --json, the results are written as CSV to the standard output\n";
+			return 1;
+		}
+	}
+	if (!resDir.empty() && resDir[resDir.size() - 1] != '/' && resDir[resDir.size() - 1] != '\\')
+		resDir += '/';
+
+	srand(seed);
+	Benchmark b(warmup, repetitions);
+	if (suites.find("strings") != string::npos)
+	{
+		measureExact(b, large);
+		measureApprox(b);
+		measureIndexes(b);
+	}
+	if (suites.find("graph") != string::npos)
+	{
+		measureGraph(b, resDir);
+		measureGeneratedGraph(b);
+	}
+
+	if (csvFile != "")
+	{
+		ofstream out(csvFile.c_str());
+		b.writeCSV(out);
+	}
+	if (jsonFile != "")
+	{
+		ofstream out(jsonFile.c_str());
+		b.writeJSON(out);
+	}
+	if (csvFile == "" && jsonFile == "")
+		b.writeCSV(cout);
+	return 0;
 }
@@ -0,0 +1,45 @@
+#include "Arena.h"
+
+Arena::Arena(): current(NULL), used(0), capacity(0), reserved(0)
+{
+}
+
+Arena::~Arena()
+{
+	for (int i = 0; i < blocks.size(); i++)
+		delete[] blocks.at(i);
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+	size_t start = (used + alignment - 1) & ~(alignment - 1);
+	if (current != NULL && start + bytes <= capacity)
+	{
+		used = start + bytes;
+		return current + start;
+	}
+
+	//a large request gets its own block, so the rest of the current block is not wasted
+	char* block = new char[bytes > ARENA_BLOCK_SIZE / 4 ? bytes : ARENA_BLOCK_SIZE];
+	blocks.push_back(block);
+	if (bytes > ARENA_BLOCK_SIZE / 4)
+	{
+		reserved += bytes;
+		return block;
+	}
+	reserved += ARENA_BLOCK_SIZE;
+	current = block;
+	capacity = ARENA_BLOCK_SIZE;
+	used = bytes;
+	return block;
+}
+
+size_t Arena::getReservedBytes() const
+{
+	return reserved;
+}
+
+int Arena::getNumBlocks() const
+{
+	return blocks.size();
+}
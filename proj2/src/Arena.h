@@ -0,0 +1,166 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <vector>
+#include <stddef.h>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+using namespace std;
+
+#define ARENA_BLOCK_SIZE (1 << 20)		//bytes of each block of an arena (larger requests get a block of their own)
+
+/**
+ * Monotonic allocator: memory is handed out from a few large blocks and is only given back, all at once,
+ * when the arena is destroyed. Nothing allocated from an arena ever moves.
+ */
+class Arena
+{
+private:
+	vector<char*> blocks;		/// Blocks allocated so far
+	char* current;				/// Block the next requests are served from
+	size_t used;				/// Bytes already handed out from the current block
+	size_t capacity;			/// Size of the current block
+	size_t reserved;			/// Bytes of all the blocks
+
+public:
+	/**
+	 * Creates an empty arena (the first block is only allocated by the first request)
+	 */
+	Arena();
+
+	/**
+	 * Frees all the blocks of the arena, without calling any destructor
+	 */
+	~Arena();
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	/**
+	 * Allocates memory from the arena
+	 * @param bytes size of the memory
+	 * @param alignment alignment of the memory (a power of two, at most that of a block)
+	 * @return pointer to the memory, valid until the arena is destroyed
+	 */
+	void* allocate(size_t bytes, size_t alignment);
+
+	/**
+	 * Gets the amount of memory taken by the arena
+	 * @return bytes of all the blocks
+	 */
+	size_t getReservedBytes() const;
+
+	/**
+	 * Gets the amount of blocks of the arena
+	 * @return size of Arena::blocks
+	 */
+	int getNumBlocks() const;
+};
+
+/**
+ * Growable array whose items are stored in an arena. Growing moves the items to a new place of the arena and
+ * leaves the old one unused, as the arena only frees memory when it is destroyed. Items are never destroyed,
+ * so they must not need it.
+ */
+template <class E>
+class ArenaArray
+{
+	static_assert(is_trivially_destructible<E>::value, "items of an ArenaArray are never destroyed");
+
+	E* items;				/// First item
+	int count;				/// Amount of items
+	int capacity;			/// Amount of items that fit in the current storage
+public:
+	/**
+	 * Creates an empty array
+	 */
+	ArenaArray(): items(NULL), count(0), capacity(0) {}
+
+	/**
+	 * Gets the amount of items
+	 * @return value of ArenaArray::count
+	 */
+	int size() const { return count; }
+
+	/**
+	 * Checks whether the array is empty
+	 * @return true if there are no items
+	 */
+	bool empty() const { return count == 0; }
+
+	/**
+	 * Gets an item, without checking its position
+	 * @param i position of the item
+	 * @return the item
+	 */
+	E &operator[](int i) { return items[i]; }
+	const E &operator[](int i) const { return items[i]; }
+
+	/**
+	 * Gets an item, checking its position
+	 * @param i position of the item
+	 * @return the item (throws out_of_range if there is no such position)
+	 */
+	E &at(int i)
+	{
+		if (i < 0 || i >= count)
+			throw out_of_range("ArenaArray::at");
+		return items[i];
+	}
+
+	const E &at(int i) const
+	{
+		if (i < 0 || i >= count)
+			throw out_of_range("ArenaArray::at");
+		return items[i];
+	}
+
+	/**
+	 * Gets the last item (the array must not be empty)
+	 * @return the item
+	 */
+	E &back() { return items[count - 1]; }
+	const E &back() const { return items[count - 1]; }
+
+	/**
+	 * Gets pointers to the first item and past the last one, to iterate over the items
+	 */
+	E* begin() { return items; }
+	E* end() { return items + count; }
+	const E* begin() const { return items; }
+	const E* end() const { return items + count; }
+
+	/**
+	 * Adds an item at the end, doubling the storage if it is full
+	 * @param e the item
+	 * @param arena arena where the storage is allocated (always the same one)
+	 */
+	void push_back(const E &e, Arena &arena)
+	{
+		if (count == capacity)
+		{
+			int newCapacity = (capacity == 0 ? 2 : capacity * 2);
+			E* newItems = static_cast<E*>(arena.allocate(newCapacity * sizeof(E), alignof(E)));
+			for (int i = 0; i < count; i++)
+				new (newItems + i) E(items[i]);
+			items = newItems;
+			capacity = newCapacity;
+		}
+		new (items + count) E(e);
+		count++;
+	}
+
+	/**
+	 * Removes an item, moving the following ones back
+	 * @param position pointer to the item
+	 */
+	void erase(E* position)
+	{
+		for (E* it = position; it + 1 < end(); it++)
+			*it = *(it + 1);
+		count--;
+	}
+};
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,330 @@
+#include "CoreGraph.h"
+
+/**
+ * Gets the edge from a vertex to another
+ * @return index of the edge, or -1 if there is no such edge
+ */
+static int findEdge(const Vertex<RoadNode>* from, int to)
+{
+	const ArenaArray<Edge<RoadNode> > &adj = from->getAdj();
+	for (int i = 0; i < adj.size(); i++)
+		if (adj.at(i).getDest()->getIndex() == to)
+			return adj.at(i).getIndex();
+	return -1;
+}
+
+CoreGraph::CoreGraph(Graph<RoadNode> &graph): graph(graph), metric(graph.getMetric())
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	int n = vs.size();
+
+	//amount of edges leading to each vertex, and the sources of the first two
+	vector<int> inCount(n, 0), inFirst(n, -1), inSecond(n, -1);
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			int dest = adj.at(j).getDest()->getIndex();
+			if (inCount.at(dest)++ == 0)
+				inFirst.at(dest) = i;
+			else
+				inSecond.at(dest) = i;
+		}
+	}
+
+	//a vertex is pass-through if it has two neighbours and is either a one-way street (one edge in from a
+	//neighbour and one out to the other) or a two-way street (one edge in and one out with each neighbour)
+	vector<char> twoWay(n, false);
+	coreIndex.assign(n, -1);
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		bool pass = false;
+		if (adj.size() == 1 && inCount.at(i) == 1)
+		{
+			int a = inFirst.at(i), b = adj.at(0).getDest()->getIndex();
+			pass = (a != b && a != i && b != i);
+		}
+		else if (adj.size() == 2 && inCount.at(i) == 2)
+		{
+			int a = adj.at(0).getDest()->getIndex(), b = adj.at(1).getDest()->getIndex();
+			pass = (a != b && a != i && b != i &&
+					((inFirst.at(i) == a && inSecond.at(i) == b) || (inFirst.at(i) == b && inSecond.at(i) == a)));
+			twoWay.at(i) = pass;
+		}
+		if (!pass)
+		{
+			coreIndex.at(i) = coreVertices.size();
+			coreVertices.push_back(i);
+		}
+	}
+
+	//walks from each core vertex along each of its edges; vertices left out are on cycles without core
+	//vertices, so one vertex of each cycle becomes a core vertex
+	chainOf.assign(n, -1);
+	chainPosition.assign(n, -1);
+	function<void(int)> walkFrom = [&](int v)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(v)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			int dest = adj.at(j).getDest()->getIndex();
+			if (coreIndex.at(dest) == -1 && chainOf.at(dest) != -1)
+				continue;
+			walkChain(v, adj.at(j), coreIndex.at(dest) == -1 && twoWay.at(dest));
+		}
+	};
+	int initialCore = coreVertices.size();
+	for (int i = 0; i < initialCore; i++)
+		walkFrom(coreVertices.at(i));
+	for (int i = 0; i < n; i++)
+	{
+		if (coreIndex.at(i) != -1 || chainOf.at(i) != -1)
+			continue;
+		coreIndex.at(i) = coreVertices.size();
+		coreVertices.push_back(i);
+		walkFrom(i);
+	}
+
+	//each chain is an edge of the core graph in each direction it can be travelled
+	edgeStart.assign(coreVertices.size() + 1, 0);
+	for (int c = 0; c < chains.size(); c++)
+	{
+		const core_chain_t &chain = chains.at(c);
+		if (chain.forward)
+			edgeStart.at(coreIndex.at(chainVertices.at(chain.first)) + 1)++;
+		if (chain.backward)
+			edgeStart.at(coreIndex.at(chainVertices.at(chain.first + chain.count - 1)) + 1)++;
+	}
+	for (int i = 0; i < coreVertices.size(); i++)
+		edgeStart.at(i + 1) += edgeStart.at(i);
+	edges.resize(edgeStart.back());
+	vector<int> next(edgeStart.begin(), edgeStart.end() - 1);
+	for (int c = 0; c < chains.size(); c++)
+	{
+		const core_chain_t &chain = chains.at(c);
+		int from = coreIndex.at(chainVertices.at(chain.first));
+		int to = coreIndex.at(chainVertices.at(chain.first + chain.count - 1));
+		core_edge_t e;
+		e.chain = c;
+		if (chain.forward)
+		{
+			e.to = to;
+			e.backward = false;
+			edges.at(next.at(from)++) = e;
+		}
+		if (chain.backward)
+		{
+			e.to = from;
+			e.backward = true;
+			edges.at(next.at(to)++) = e;
+		}
+	}
+	customize();
+}
+
+void CoreGraph::walkChain(int start, const Edge<RoadNode> &edge, bool twoWay)
+{
+	core_chain_t chain;
+	chain.first = chainVertices.size();
+	chain.forward = true;
+	chain.backward = twoWay;
+	int c = chains.size();
+
+	chainVertices.push_back(start);
+	int prev = start;
+	const Edge<RoadNode>* e = &edge;
+	while (true)
+	{
+		const Vertex<RoadNode>* cur = e->getDest();
+		int v = cur->getIndex();
+		forwardEdges.push_back(e->getIndex());
+		backwardEdges.push_back(twoWay ? findEdge(cur, prev) : -1);
+		chainVertices.push_back(v);
+		if (coreIndex.at(v) != -1)
+			break;
+		chainOf.at(v) = c;
+		chainPosition.at(v) = chainVertices.size() - 1;
+		const ArenaArray<Edge<RoadNode> > &adj = cur->getAdj();
+		e = (adj.size() == 1 || adj.at(0).getDest()->getIndex() != prev ? &adj.at(0) : &adj.at(1));
+		prev = v;
+	}
+	forwardEdges.push_back(-1);
+	backwardEdges.push_back(-1);
+	chain.count = chainVertices.size() - chain.first;
+	chains.push_back(chain);
+}
+
+void CoreGraph::customize()
+{
+	metric = graph.getMetric();
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	vector<double> w(graph.getNumEdges(), INT_INFINITY);
+	for (int i = 0; i < vs.size(); i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+			w.at(adj.at(j).getIndex()) = graph.getEdgeWeight(adj.at(j));
+	}
+	forwardWeights.assign(chainVertices.size(), INT_INFINITY);
+	backwardWeights.assign(chainVertices.size(), INT_INFINITY);
+	for (int i = 0; i < chainVertices.size(); i++)
+	{
+		if (forwardEdges.at(i) != -1)
+			forwardWeights.at(i) = w.at(forwardEdges.at(i));
+		if (backwardEdges.at(i) != -1)
+			backwardWeights.at(i) = w.at(backwardEdges.at(i));
+	}
+}
+
+int CoreGraph::getNumVertex() const
+{
+	return coreVertices.size();
+}
+
+int CoreGraph::getNumEdges() const
+{
+	return edges.size();
+}
+
+sp_tree_t CoreGraph::computeShortestPathTree(const RoadNode &s) const
+{
+	typedef pair<double, int> entry;
+	sp_tree_t tree;
+	tree.metric = metric;
+	tree.dist.assign(coreIndex.size(), INT_INFINITY);
+	tree.pred.assign(coreIndex.size(), -1);
+	Vertex<RoadNode>* source = graph.getVertex(s);
+	tree.source = (source == NULL ? -1 : source->getIndex());
+	if (tree.source == -1)
+		return tree;
+	tree.dist[tree.source] = 0;
+
+	vector<double> dist(coreVertices.size(), INT_INFINITY);
+	vector<int> pred(coreVertices.size(), -1);
+	vector<entry> pq;
+	if (coreIndex[tree.source] != -1)
+	{
+		dist[coreIndex[tree.source]] = 0;
+		pq.push_back(entry(0, coreIndex[tree.source]));
+	}
+	else
+	{
+		//the source is inside a chain, so the search starts from the ends of the chain it can reach
+		const core_chain_t &chain = chains[chainOf[tree.source]];
+		int pos = chainPosition[tree.source], last = chain.first + chain.count - 1;
+		if (chain.forward)
+		{
+			double d = 0;
+			for (int k = pos; k < last; k++)
+				d += forwardWeights[k];
+			int v = coreIndex[chainVertices[last]];
+			if (d < dist[v])
+			{
+				dist[v] = d;
+				pred[v] = forwardEdges[last - 1];
+				pq.push_back(entry(d, v));
+			}
+		}
+		if (chain.backward)
+		{
+			double d = 0;
+			for (int k = pos - 1; k >= chain.first; k--)
+				d += backwardWeights[k];
+			int v = coreIndex[chainVertices[chain.first]];
+			if (d < dist[v])
+			{
+				dist[v] = d;
+				pred[v] = backwardEdges[chain.first];
+				pq.push_back(entry(d, v));
+			}
+		}
+		make_heap(pq.begin(), pq.end(), greater<entry>());
+	}
+
+	//Dijkstra's algorithm over the core vertices, adding up the weights of each chain it goes through
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		entry top = pq.back();
+		pq.pop_back();
+		int u = top.second;
+		if (top.first > dist[u])
+			continue;
+
+		for (int i = edgeStart[u]; i < edgeStart[u + 1]; i++)
+		{
+			const core_edge_t &e = edges[i];
+			const core_chain_t &chain = chains[e.chain];
+			int last = chain.first + chain.count - 1, p;
+			double d = dist[u];
+			if (!e.backward)
+			{
+				for (int k = chain.first; k < last; k++)
+					d += forwardWeights[k];
+				p = forwardEdges[last - 1];
+			}
+			else
+			{
+				for (int k = last - 1; k >= chain.first; k--)
+					d += backwardWeights[k];
+				p = backwardEdges[chain.first];
+			}
+			if (d < dist[e.to])
+			{
+				dist[e.to] = d;
+				pred[e.to] = p;
+				pq.push_back(entry(d, e.to));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+
+	//unpacks the chains: each inner vertex is reached from the end of its chain that gets there first
+	for (int i = 0; i < coreVertices.size(); i++)
+	{
+		tree.dist[coreVertices[i]] = dist[i];
+		tree.pred[coreVertices[i]] = pred[i];
+	}
+	for (int c = 0; c < chains.size(); c++)
+	{
+		const core_chain_t &chain = chains[c];
+		int last = chain.first + chain.count - 1;
+		if (chain.count <= 2)
+			continue;
+		if (chain.forward)
+		{
+			double d = tree.dist[chainVertices[chain.first]];
+			for (int k = chain.first + 1; k < last; k++)
+			{
+				int v = chainVertices[k];
+				d += forwardWeights[k - 1];
+				if (d < tree.dist[v])
+				{
+					tree.dist[v] = d;
+					tree.pred[v] = forwardEdges[k - 1];
+				}
+				else
+					d = tree.dist[v];
+			}
+		}
+		if (chain.backward)
+		{
+			double d = tree.dist[chainVertices[last]];
+			for (int k = last - 1; k > chain.first; k--)
+			{
+				int v = chainVertices[k];
+				d += backwardWeights[k];
+				if (d < tree.dist[v])
+				{
+					tree.dist[v] = d;
+					tree.pred[v] = backwardEdges[k];
+				}
+				else
+					d = tree.dist[v];
+			}
+		}
+	}
+	return tree;
+}
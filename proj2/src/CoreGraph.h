@@ -0,0 +1,97 @@
+#ifndef COREGRAPH_H_
+#define COREGRAPH_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include <vector>
+
+/**
+ * A chain of edges between two core vertices, whose inner vertices are pass-through vertices
+ */
+struct core_chain_t
+{
+	int first;				/// position of the first vertex in CoreGraph::chainVertices (a core vertex)
+	int count;				/// amount of vertices, from a core vertex to a core vertex (which may be the same one)
+	bool forward;			/// true if the chain can be travelled from its first vertex to its last
+	bool backward;			/// true if the chain can be travelled from its last vertex to its first
+};
+
+/**
+ * An edge of the core graph, standing for a chain travelled in one direction
+ */
+struct core_edge_t
+{
+	int to;					/// core index of the vertex the edge leads to
+	int chain;				/// index of the chain in CoreGraph::chains
+	bool backward;			/// true if the chain is travelled from its last vertex to its first
+};
+
+/**
+ * Contracted version of a graph, for routing. Most nodes of a road only shape its curves: they have two
+ * neighbours and can only be crossed from one to the other (a pass-through vertex). Those vertices are
+ * contracted into chains between the remaining ones (the core vertices), and a shortest path tree is computed
+ * by running Dijkstra's algorithm over the core only. The vertices and edges of each chain are kept in flat
+ * side arrays, which are used to snap a source that is inside a chain onto both of its ends, and to unpack
+ * the tree into every vertex of the graph. The weights of a chain are added one by one, in the order Dijkstra's
+ * algorithm would add them over the whole graph, so the distances are the same as Graph::computeShortestPathTree.
+ */
+class CoreGraph
+{
+private:
+	Graph<RoadNode> &graph;				/// The graph contracted
+	metric_t metric;					/// Metric of the weights (see CoreGraph::customize)
+	vector<int> coreIndex;				/// Position of each vertex of the graph among the core vertices, -1 for pass-through vertices
+	vector<int> coreVertices;			/// Index in the graph of each core vertex
+	vector<int> chainOf;				/// Chain of each pass-through vertex (-1 for core vertices)
+	vector<int> chainPosition;			/// Position of each pass-through vertex in CoreGraph::chainVertices
+	vector<core_chain_t> chains;		/// Chains between core vertices, covering every edge of the graph once
+	vector<int> chainVertices;			/// Indexes of the vertices of the chains, chain after chain
+	vector<int> forwardEdges;			/// Edge from each position of chainVertices to the next one (-1 if none, or at the end of a chain)
+	vector<int> backwardEdges;			/// Edge from the next position of chainVertices to each one (-1 if none)
+	vector<double> forwardWeights;		/// Weight of each edge of CoreGraph::forwardEdges (INT_INFINITY if closed)
+	vector<double> backwardWeights;		/// Weight of each edge of CoreGraph::backwardEdges (INT_INFINITY if closed)
+	vector<int> edgeStart;				/// Position in CoreGraph::edges of the first edge of each core vertex (plus the end)
+	vector<core_edge_t> edges;			/// Edges of the core graph, grouped by the core vertex they start from
+
+	/**
+	 * Walks along a chain, from a core vertex until the next one, marking its inner vertices as contracted
+	 * @param start index of the core vertex where the chain starts
+	 * @param edge the edge leaving the core vertex
+	 * @param twoWay true if the inner vertices of the chain can be crossed both ways
+	 */
+	void walkChain(int start, const Edge<RoadNode> &edge, bool twoWay);
+
+public:
+	/**
+	 * Contracts the pass-through vertices of a graph, with the weights of its current metric
+	 * @param graph the graph (its vertices and edges must not change while the core graph is used)
+	 */
+	CoreGraph(Graph<RoadNode> &graph);
+
+	/**
+	 * Reloads the weights of the chains from the current metric of the graph, after the weights
+	 * of its edges changed, some of them were closed or reopened or another metric was chosen
+	 */
+	void customize();
+
+	/**
+	 * Gets the amount of core vertices
+	 * @return the amount of vertices not contracted
+	 */
+	int getNumVertex() const;
+
+	/**
+	 * Gets the amount of edges of the core graph
+	 * @return the amount of chains times the directions in which they can be travelled
+	 */
+	int getNumEdges() const;
+
+	/**
+	 * Computes the shortest paths from a vertex to all the others over the core graph
+	 * @param s content of the source vertex
+	 * @return the tree of the whole graph, as given by Graph::computeShortestPathTree
+	 */
+	sp_tree_t computeShortestPathTree(const RoadNode &s) const;
+};
+
+#endif /* COREGRAPH_H_ */
@@ -10,10 +10,78 @@
 #include <limits.h>
 #include <list>
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <type_traits>
+#include <thread>
+#include "SpeedProfile.h"
+#include "Arena.h"
 using namespace std;
 
 const int INT_INFINITY = INT_MAX;
 
+#define GRAPH_MIN_SLOTS 16		//smallest size of the hash table of the vertexes of a graph
+#define ALT_LANDMARKS 16		//landmarks usually chosen for the ALT algorithm
+
+/**
+ * Metrics that can be used as the weight of the edges of a graph
+ */
+enum metric_t
+{
+	DISTANCE,		/// Length of the edge in meters
+	TIME,			/// Time needed to travel the edge in seconds
+	COST,			/// Cost of travelling the edge in cents
+	NUM_METRICS		/// Number of metrics
+};
+
+/**
+ * Change to the weight of an edge, used to update a graph in batches
+ */
+struct edge_update_t
+{
+	int edge;		/// Index of the edge (Edge::index)
+	double weight;	/// New weight in the selected metric, INT_INFINITY to close the edge or a negative value to reopen it with its previous weight
+};
+
+/**
+ * Shortest path tree from a source vertex, stored in flat arrays indexed by Vertex::index
+ * instead of in the vertexes themselves, so that many trees can be kept at once and
+ * repaired when the weights of the graph change
+ */
+struct sp_tree_t
+{
+	int source;				/// Index of the source vertex
+	metric_t metric;		/// Metric used as the weight of the edges
+	vector<double> dist;	/// Distance from the source to each vertex (INT_INFINITY if unreachable)
+	vector<int> pred;		/// Index of the edge used to reach each vertex (-1 for the source and unreachable vertexes)
+	vector<int> parent;		/// Entry each entry was reached from, in trees that are followed by turn states (see TurnGraph; empty otherwise)
+};
+
+/**
+ * Ways of choosing the landmarks of the ALT algorithm (see Graph::computeLandmarks)
+ */
+enum landmark_selection_t
+{
+	FARTHEST_LANDMARKS,		/// Each landmark is the vertex farthest from (or to) the ones chosen before
+	AVOID_LANDMARKS,		/// Each landmark is a leaf of the part of a shortest path tree whose bounds are the worst (Goldberg and Werneck)
+	NUM_LANDMARK_SELECTIONS	/// Number of ways of choosing the landmarks
+};
+
+/**
+ * Landmarks of the ALT algorithm (A*, landmarks and the triangle inequality): a few vertexes and the distances
+ * from and to each of them, which give a lower bound on the distance between any two vertexes. Edges are travelled
+ * in their direction only, so the distances from and to a landmark differ on one-way streets
+ */
+struct alt_landmarks_t
+{
+	metric_t metric;				/// Metric used as the weight of the edges
+	unsigned int version;			/// Graph::getWeightsVersion when the landmarks were computed
+	vector<int> landmarks;			/// Index of each landmark
+	vector<vector<double> > from;	/// Distance from each landmark to each vertex (INT_INFINITY if unreachable)
+	vector<vector<double> > to;		/// Distance from each vertex to each landmark (INT_INFINITY if unreachable)
+};
+
 template <class T> class Edge;
 template <class T> class Graph;
 
@@ -24,11 +92,13 @@ template <class T> class Graph;
 template <class T>
 class Vertex {
 	T info;					/// Information on vertex's content
-	vector<Edge<T>  > adj;	/// Edge that connects this vertex to another
+	ArenaArray<Edge<T> > adj;	/// Edge that connects this vertex to another (stored in the arena of the graph)
+	ArenaArray<pair<Vertex<T>*, int> > incoming;	/// Source vertex and index of each edge leading to this vertex
+	int index;				/// Position of the vertex in Graph::vertexSet
 	bool visited;			///	Keeps track whether the vertex was already visited or not
 	bool processed;			/// Keeps track whether the vertex was processed or not
 	int indegree;			/// Number of edges leading to this vertex
-	int dist;				/// Distance to starting vertex of an algorithm
+	double dist;			/// Distance to starting vertex of an algorithm
 public:
 	/**
 	 * Creates an instance of vertex
@@ -42,6 +112,12 @@ public:
 	 */
 	T getInfo() const;
 
+	/**
+	 * Gets the position of the vertex in its graph
+	 * @return Vertex::index
+	 */
+	int getIndex() const;
+
 	/**
 	 * Gets the number of edges leading into the vertex
 	 * @return Vertex::indegree
@@ -50,9 +126,15 @@ public:
 
 	/**
 	 * Gets the edges starting from the vertex
-	 * @return vector of edges stored in Vertex::adj
+	 * @return reference to Vertex::adj
 	 */
-	vector<Edge<T> > getAdj() const;
+	const ArenaArray<Edge<T> > &getAdj() const;
+
+	/**
+	 * Gets the edges leading to the vertex
+	 * @return reference to Vertex::incoming
+	 */
+	const ArenaArray<pair<Vertex<T>*, int> > &getIncoming() const;
 
 	/**
 	 * Gets distance to starting vertex of an algorithm
@@ -88,7 +170,7 @@ struct vertex_greater_than {
 };
 
 template <class T>
-Vertex<T>::Vertex(T in): info(in), visited(false), indegree(0), dist(0), processed(false), path(NULL){}
+Vertex<T>::Vertex(T in): info(in), index(-1), visited(false), processed(false), indegree(0), dist(0), path(NULL){}
 
 template <class T>
 T Vertex<T>::getInfo() const
@@ -96,6 +178,12 @@ T Vertex<T>::getInfo() const
 	return info;
 }
 
+template <class T>
+int Vertex<T>::getIndex() const
+{
+	return index;
+}
+
 template <class T>
 int Vertex<T>::getIndegree() const
 {
@@ -103,15 +191,23 @@ int Vertex<T>::getIndegree() const
 }
 
 template <class T>
-vector<Edge<T> > Vertex<T>::getAdj() const
+const ArenaArray<Edge<T> > &Vertex<T>::getAdj() const
 {
 	return adj;
 }
 
+template <class T>
+const ArenaArray<pair<Vertex<T>*, int> > &Vertex<T>::getIncoming() const
+{
+	return incoming;
+}
+
 template <class T>
 int Vertex<T>::getDist() const
 {
-	return dist;
+	if (dist >= INT_INFINITY)
+		return INT_INFINITY;
+	return static_cast<int>(dist + 0.5);
 }
 
 template <class T>
@@ -135,14 +231,17 @@ class Edge {
 	Vertex<T> * dest;		/// Pointer to the vertex the edge leads to
 	double weight;			/// Edge's weight
 	int id;					/// Edge's id
+	int profile;			/// Index of the edge's speed profile in Graph::profiles (-1 if the weight is a static time)
+	int index;				/// Position of the edge in the weight layers of the graph
 public:
 	/**
 	 * Creates an instance of Edge
 	 * @param d pointer to this edge's destiny
 	 * @param w this edge's weight
 	 * @param id this edge's id
+	 * @param profile index of this edge's speed profile, -1 if it has none
 	 */
-	Edge(Vertex<T> *d, double w, int id);
+	Edge(Vertex<T> *d, double w, int id, int profile = -1);
 
 	/**
 	 * Gets the edge's id
@@ -162,6 +261,18 @@ public:
 	 */
 	double getWeight() const;
 
+	/**
+	 * Gets the position of the edge in the weight layers of its graph
+	 * @return content of Edge::index
+	 */
+	int getIndex() const;
+
+	/**
+	 * Gets the index of the edge's speed profile
+	 * @return content of Edge::profile
+	 */
+	int getProfile() const;
+
 	/**
 	 * Declares the Graph class as friend
 	 * @see Graph
@@ -176,7 +287,7 @@ public:
 };
 
 template <class T>
-Edge<T>::Edge(Vertex<T> *d, double w, int id): dest(d), weight(w), id(id){}
+Edge<T>::Edge(Vertex<T> *d, double w, int id, int profile): dest(d), weight(w), id(id), profile(profile), index(-1){}
 
 template <class T>
 int Edge<T>::getID() const
@@ -196,22 +307,115 @@ double Edge<T>::getWeight() const
 	return weight;
 }
 
+template <class T>
+int Edge<T>::getIndex() const
+{
+	return index;
+}
+
+template <class T>
+int Edge<T>::getProfile() const
+{
+	return profile;
+}
+
 //------------------------------
 //Graph<T>
 //------------------------------
 
 template <class T>
 class Graph {
+	Arena arena;								/// Storage of the vertexes and their edges, freed with the graph (must be the first member)
 	vector<Vertex<T> *> vertexSet;				/// Vector containing pointers to all the vertexes in the graph
+	vector<int> vertexSlots;					/// Hash table (open addressing) with the position of each vertex in Graph::vertexSet, -1 for empty slots (needs std::hash<T>)
+	int slotBits;								/// Logarithm of the size of Graph::vertexSlots
 	vector<T> dfsResult;						/// Vector containing the result of the last Depth-First Search
 	bool isDAGflag;								/// Set to True if this is a Directed acyclic-graph and false otherwise
+	vector<SpeedProfile> profiles;				/// Speed profiles shared by the edges, indexed by Edge::profile
+	vector<vector<double> > layers;				/// One weight per edge for each metric, indexed by metric and Edge::index
+	metric_t metric;							/// Metric used as the weight of the edges by the shortest path algorithms
+	int numEdges;								/// Number of edges ever added, and the size of each weight layer
+	vector<Vertex<T>*> edgeSource;				/// Vertex where each edge starts, indexed by Edge::index
+	vector<Vertex<T>*> edgeDest;				/// Vertex where each edge ends (NULL if it was removed), indexed by Edge::index
+	vector<bool> closed;						/// True for each edge that is closed, indexed by Edge::index
+	int settled;								/// Vertexes settled by the last search for a single destination
+	unsigned int weightsVersion;				/// Changed whenever a path may have become shorter (see Graph::getWeightsVersion)
+
+	/**
+	 * Creates an edge, registering its weight in all layers, and adds it to a vertex
+	 * @param v vertex where the edge starts
+	 * @param e the edge
+	 */
+	void insertEdge(Vertex<T>* v, Edge<T> &e);
+
+	/**
+	 * Finds the slot of the hash table of the vertexes where some content is, or where it would be added
+	 * @param info content of the vertex
+	 * @return position in Graph::vertexSlots
+	 */
+	int findSlot(const T &info) const;
+
+	/**
+	 * Computes the distances from a vertex to all the others, or from all the others to it, with Dijkstra's
+	 * algorithm, without changing the state of the vertexes
+	 * @param source index of the vertex
+	 * @param backward true to follow the edges against their direction (distances to the vertex)
+	 * @param dist where the distances are written (INT_INFINITY if unreachable)
+	 */
+	void landmarkDistances(int source, bool backward, vector<double> &dist) const;
+
+	/**
+	 * Chooses the next landmark as the leaf of a shortest path tree below which the lower bounds given by the
+	 * landmarks chosen so far fall the shortest of the real distances (the "avoid" method of Goldberg and Werneck)
+	 * @param lm the landmarks chosen so far
+	 * @param tree shortest path tree from the root of this choice (see Graph::avoidRoot)
+	 * @return index of the new landmark, or -1 if every vertex reached is already covered by a landmark
+	 */
+	int avoidLandmark(const alt_landmarks_t &lm, const sp_tree_t &tree) const;
+
+	/**
+	 * Gets the root of the shortest path tree used to choose a landmark with the "avoid" method, which depends only
+	 * on how many landmarks were chosen before, so the tree can be computed before they are
+	 * @param chosen amount of landmarks chosen before
+	 * @return index of the vertex
+	 */
+	int avoidRoot(int chosen) const;
+
+	/**
+	 * Gets the lower bound on the distance from a vertex to another given by the landmarks
+	 * @param lm the landmarks
+	 * @param v index of the vertex
+	 * @param t index of the destination
+	 * @return the bound, or INT_INFINITY if the landmarks show that t cannot be reached from v
+	 */
+	double landmarkBound(const alt_landmarks_t &lm, int v, int t) const;
+
+	/**
+	 * Rebuilds the hash table of the vertexes
+	 * @param bits logarithm of the new size of the table
+	 */
+	void rehash(int bits);
 
 public:
+	/**
+	 * Creates an empty graph, using distance as the metric
+	 */
+	Graph();
+
+	/**
+	 * Destroys the graph. The vertexes and edges are freed with the arena, so nothing is done
+	 * for each one unless the content of the vertexes needs to be destroyed
+	 */
+	~Graph();
+
+	Graph(const Graph &) = delete;
+	Graph &operator=(const Graph &) = delete;
+
 	/**
 	 * Gets the vector containing pointers to all the vertexes of the graph
-	 * @return content of Graph::vertexSet
+	 * @return reference to Graph::vertexSet
 	 */
-	vector<Vertex<T> * > getVertexSet() const;
+	const vector<Vertex<T> * > &getVertexSet() const;
 
 	/**
 	 * Gets the amount of vertexes in the graph
@@ -245,6 +449,140 @@ public:
 	 */
 	bool addEdge(const T &sourc, const T &dest, double w);
 
+	/**
+	 * Adds an edge with a speed profile to the current graph
+	 * @param sourc starting point of this edge
+	 * @param dest destiny of the edge
+	 * @param w edge's weight (its length in meters)
+	 * @param id edge's id
+	 * @param profile index of the edge's speed profile in Graph::profiles
+	 * @return true if successful and false otherwise
+	 */
+	bool addEdge(const T &sourc, const T &dest, double w, int id, int profile);
+
+	/**
+	 * Replaces the speed profiles shared by the edges of the graph
+	 * @param p vector with the new profiles
+	 */
+	void setSpeedProfiles(const vector<SpeedProfile> &p);
+
+	/**
+	 * Gets the speed profiles shared by the edges of the graph
+	 * @return content of Graph::profiles
+	 */
+	const vector<SpeedProfile>& getSpeedProfiles() const;
+
+	/**
+	 * Selects the metric used as the weight of the edges by the shortest path algorithms
+	 * @param m the metric
+	 */
+	void setMetric(metric_t m);
+
+	/**
+	 * Gets the metric used as the weight of the edges
+	 * @return content of Graph::metric
+	 */
+	metric_t getMetric() const;
+
+	/**
+	 * Gets the amount of edges ever added to the graph (removed ones included)
+	 * @return content of Graph::numEdges
+	 */
+	int getNumEdges() const;
+
+	/**
+	 * Gets a number that changes whenever an edge is added, gets lighter or is reopened, or the vertexes are
+	 * renumbered, so that bounds computed before (see alt_landmarks_t) can be told apart from valid ones
+	 * @return content of Graph::weightsVersion
+	 */
+	unsigned int getWeightsVersion() const;
+
+	/**
+	 * Gets the weight of an edge for the selected metric
+	 * @param e the edge
+	 * @return weight of the edge in the layer of Graph::metric
+	 */
+	double getEdgeWeight(const Edge<T> &e) const;
+
+	/**
+	 * Gets the weight of an edge for a given metric
+	 * @param e the edge
+	 * @param m the metric
+	 * @return weight of the edge in the layer of m
+	 */
+	double getEdgeWeight(const Edge<T> &e, metric_t m) const;
+
+	/**
+	 * Replaces all the weights of a metric at once. The new weights go live immediately,
+	 * without rebuilding the graph
+	 * @param m the metric to customise
+	 * @param w vector with the new weights, indexed by Edge::index (its content is taken by the graph)
+	 * @return false if w doesn't have one weight per edge, true otherwise
+	 */
+	bool customizeMetric(metric_t m, vector<double> &w);
+
+	/**
+	 * Recomputes all the weights of a metric from a function of the edge
+	 * @param m the metric to customise
+	 * @param f function that gives the new weight of an edge
+	 */
+	void customizeMetric(metric_t m, function<double(const Edge<T> &)> f);
+
+	/**
+	 * Calculates the length of a path (the sum of the shortest edges between consecutive vertexes)
+	 * @param path vector with the contents of the vertexes of the path
+	 * @return length of the path, or INT_INFINITY if two consecutive vertexes are not connected
+	 */
+	double getPathLength(const vector<T> &path);
+
+	/**
+	 * Applies a batch of changes to the weights of the selected metric, closing or reopening edges
+	 * @param updates vector with the changes (see edge_update_t)
+	 * @return vector with the indexes of the edges that were changed
+	 */
+	vector<int> updateEdges(const vector<edge_update_t> &updates);
+
+	/**
+	 * Checks if an edge is closed
+	 * @param edge index of the edge (Edge::index)
+	 * @return true if the edge is closed, false otherwise
+	 */
+	bool isEdgeClosed(int edge) const;
+
+	/**
+	 * Calculates the shortest path tree from vertex s using Dijkstra's algorithm,
+	 * without changing the state of the vertexes
+	 * @param s content of the source vertex
+	 * @return the tree
+	 */
+	sp_tree_t computeShortestPathTree(const T &s) const;
+
+	/**
+	 * Repairs a shortest path tree after some edges changed, recomputing only the vertexes
+	 * whose distance may have changed (as described by Ramalingam and Reps)
+	 * @param tree the tree to repair, computed with the selected metric (and without turn states)
+	 * @param changed indexes of the edges that changed since the tree was computed
+	 * @return number of vertexes whose distance was recomputed
+	 */
+	int repairShortestPathTree(sp_tree_t &tree, const vector<int> &changed) const;
+
+	/**
+	 * Gets the path from the source of a tree to a vertex
+	 * @param tree the shortest path tree
+	 * @param dest content of finishing vertex for the path
+	 * @return vector with the contents of the vertexes in the path (empty if dest is unreachable)
+	 */
+	vector<T> getTreePath(const sp_tree_t &tree, const T &dest);
+
+	/**
+	 * Gets the path from the source of a tree to a vertex, without allocating memory if path has room for it
+	 * @param tree the shortest path tree
+	 * @param dest index of the finishing vertex
+	 * @param path where the indexes of the vertexes of the path are written, from the source to dest
+	 * (empty if dest is unreachable)
+	 */
+	void getTreePath(const sp_tree_t &tree, int dest, vector<int> &path) const;
+
 	/**
 	 * Removes a vertex from the graph
 	 * @param in reference of the vertex to remove
@@ -345,6 +683,59 @@ public:
 	 */
 	int dijkstraShortestPath(const T &s, const T &d);
 
+	/**
+	 * Chooses landmarks for the ALT algorithm and computes the distances from and to each of them, with the
+	 * selected metric. The two searches of each landmark run in parallel, and with the "avoid" method also the
+	 * tree the next landmark is chosen from; only the choice itself waits for the landmarks before it. The bounds
+	 * stay valid if edges are closed or get heavier, but are ignored once an edge gets lighter or is reopened
+	 * @param count amount of landmarks
+	 * @param selection how the landmarks are chosen
+	 * @return the landmarks
+	 */
+	alt_landmarks_t computeLandmarks(int count = ALT_LANDMARKS, landmark_selection_t selection = AVOID_LANDMARKS) const;
+
+	/**
+	 * Calculates the shortest path from vertex s to vertex d with the ALT algorithm: A* search guided by the
+	 * largest lower bound given by the landmarks, which settles far fewer vertexes than Graph::dijkstraShortestPath
+	 * and leaves the same distances and paths in the vertexes (landmarks of another metric, or computed before the
+	 * weights last changed as told by Graph::getWeightsVersion, are not used and the search is plain Dijkstra)
+	 * @param lm the landmarks (see Graph::computeLandmarks)
+	 * @param s content of the path's starting vertex
+	 * @param d content of the path's destiny vertex
+	 * @return distance from s to d, or INT_INFINITY if d is unreachable
+	 */
+	int altShortestPath(const alt_landmarks_t &lm, const T &s, const T &d);
+
+	/**
+	 * Gets the amount of vertexes settled by the last search for a single destination (the search space of
+	 * Graph::dijkstraShortestPath or Graph::altShortestPath)
+	 * @return content of Graph::settled
+	 */
+	int getSearchSpace() const;
+
+	/**
+	 * Calculates the shortest path tree from vertex s using the time-dependent variant of Dijkstra's algorithm,
+	 * without changing the state of the vertexes: each edge is entered at the time its path arrives at its source,
+	 * and weighed by the time it takes from then. With the travel time as the weight and speed profiles that satisfy
+	 * the FIFO property, the paths are the earliest arrivals; with other weights they only follow the arrival times
+	 * @param s content of the source vertex
+	 * @param departure time of departure from s (in seconds since midnight)
+	 * @param travel function that gives the time needed to travel an edge entered at a given time (in seconds)
+	 * @param weight function that gives the weight of an edge, in the selected metric, from the time needed to travel it
+	 * @return the tree (closed edges are not used)
+	 */
+	sp_tree_t timeDependentShortestPathTree(const T &s, double departure,
+			function<double(const Edge<T> &, double)> travel, function<double(const Edge<T> &, double)> weight) const;
+
+	/**
+	 * Calculates the time needed to travel a given path, entering each edge at the time the previous ones lead to
+	 * @param path vector with the contents of the vertexes of the path
+	 * @param departure time of departure from the first vertex (in seconds since midnight)
+	 * @param travel function that gives the time needed to travel an edge entered at a given time (in seconds)
+	 * @return travel time in seconds, or INT_INFINITY if two consecutive vertexes are not connected
+	 */
+	double getPathTravelTime(const vector<T> &path, double departure, function<double(const Edge<T> &, double)> travel);
+
 	/**
 	 * Resets all the vertex's visited status to false
 	 */
@@ -376,73 +767,418 @@ public:
 	vector<Vertex<T>* > incompletePrimMST(const T &s, vector<T> elem, int &distance);
 };
 
+template <class T>
+Graph<T>::Graph(): slotBits(0), isDAGflag(false), layers(NUM_METRICS), metric(DISTANCE), numEdges(0), settled(0), weightsVersion(0)
+{
+	rehash(0);
+}
+
+template <class T>
+Graph<T>::~Graph()
+{
+	if (!is_trivially_destructible<Vertex<T> >::value)
+		for (int i = 0; i < vertexSet.size(); i++)
+			vertexSet[i]->~Vertex<T>();
+}
+
+template <class T>
+int Graph<T>::findSlot(const T &info) const
+{
+	//Fibonacci hashing spreads ids that share their lowest bits
+	int mask = vertexSlots.size() - 1;
+	int slot = static_cast<int>((hash<T>()(info) * 11400714819323198485ULL) >> (64 - slotBits)) & mask;
+	while (vertexSlots[slot] != -1 && !(vertexSet[vertexSlots[slot]]->info == info))
+		slot = (slot + 1) & mask;
+	return slot;
+}
+
+template <class T>
+void Graph<T>::rehash(int bits)
+{
+	slotBits = max(bits, 1);
+	while ((1 << slotBits) < GRAPH_MIN_SLOTS)
+		slotBits++;
+	vertexSlots.assign(1 << slotBits, -1);
+	int mask = vertexSlots.size() - 1;
+	for (int i = 0; i < vertexSet.size(); i++)
+	{
+		//the contents are all different, so each one goes to the first empty slot
+		int slot = static_cast<int>((hash<T>()(vertexSet[i]->info) * 11400714819323198485ULL) >> (64 - slotBits)) & mask;
+		while (vertexSlots[slot] != -1)
+			slot = (slot + 1) & mask;
+		vertexSlots[slot] = i;
+	}
+}
+
 template <class T>
 int Graph<T>::getNumVertex() const {
 	return vertexSet.size();
 }
 
 template <class T>
-vector<Vertex<T> * > Graph<T>::getVertexSet() const {
+const vector<Vertex<T> * > &Graph<T>::getVertexSet() const {
 	return vertexSet;
 }
 
 template <class T>
 bool Graph<T>::addVertex(const T &in)
 {
-	for (int i = 0; i < vertexSet.size(); i++)
-	{
-		if (vertexSet.at(i)->info == in)
-			return false;
-	}
-	Vertex<T>* v = new Vertex<T>(in);
+	int slot = findSlot(in);
+	if (vertexSlots[slot] != -1)
+		return false;
+	Vertex<T>* v = new (arena.allocate(sizeof(Vertex<T>), alignof(Vertex<T>))) Vertex<T>(in);
+	v->index = vertexSet.size();
 	vertexSet.push_back(v);
+	vertexSlots[slot] = v->index;
+
+	//the table is kept at most half full
+	if (vertexSet.size() * 2 > vertexSlots.size())
+		rehash(slotBits + 1);
 	return true;
 }
 
 template <class T>
 bool Graph<T>::addEdge(const T &sourc, const T &dest, double w, int id)
 {
+	Vertex<T>* s = getVertex(sourc);
+	Vertex<T>* d = getVertex(dest);
+	if (s == NULL || d == NULL)
+		return false;
+	Edge<T> e(d, w, id);
+	insertEdge(s, e);
+	return true;
+}
+
+template <class T>
+bool Graph<T>::addEdge(const T &sourc, const T &dest, double w)
+{
+	return addEdge(sourc, dest, w, 0);
+}
+
+template <class T>
+bool Graph<T>::addEdge(const T &sourc, const T &dest, double w, int id, int profile)
+{
+	Vertex<T>* s = getVertex(sourc);
+	Vertex<T>* d = getVertex(dest);
+	if (s == NULL || d == NULL)
+		return false;
+	Edge<T> e(d, w, id, profile);
+	insertEdge(s, e);
+	return true;
+}
+
+template <class T>
+void Graph<T>::insertEdge(Vertex<T>* v, Edge<T> &e)
+{
+	e.index = numEdges++;
+	weightsVersion++;
+	for (int m = 0; m < NUM_METRICS; m++)
+		layers[m].push_back(e.weight);
+	edgeSource.push_back(v);
+	edgeDest.push_back(e.dest);
+	closed.push_back(false);
+	v->adj.push_back(e, arena);
+	e.dest->incoming.push_back(pair<Vertex<T>*, int>(v, e.index), arena);
+	e.dest->indegree++;
+}
+
+template <class T>
+void Graph<T>::setSpeedProfiles(const vector<SpeedProfile> &p)
+{
+	profiles = p;
+}
+
+template <class T>
+const vector<SpeedProfile>& Graph<T>::getSpeedProfiles() const
+{
+	return profiles;
+}
+
+template <class T>
+void Graph<T>::setMetric(metric_t m)
+{
+	metric = m;
+}
+
+template <class T>
+metric_t Graph<T>::getMetric() const
+{
+	return metric;
+}
+
+template <class T>
+int Graph<T>::getNumEdges() const
+{
+	return numEdges;
+}
+
+template <class T>
+unsigned int Graph<T>::getWeightsVersion() const
+{
+	return weightsVersion;
+}
+
+template <class T>
+double Graph<T>::getEdgeWeight(const Edge<T> &e) const
+{
+	if (closed[e.index])
+		return INT_INFINITY;
+	return layers[metric][e.index];
+}
+
+template <class T>
+double Graph<T>::getEdgeWeight(const Edge<T> &e, metric_t m) const
+{
+	if (closed[e.index])
+		return INT_INFINITY;
+	return layers[m][e.index];
+}
+
+template <class T>
+bool Graph<T>::customizeMetric(metric_t m, vector<double> &w)
+{
+	if (w.size() != numEdges)
+		return false;
+	layers[m].swap(w);
+	weightsVersion++;
+	return true;
+}
+
+template <class T>
+void Graph<T>::customizeMetric(metric_t m, function<double(const Edge<T> &)> f)
+{
+	vector<double> w(layers[m]);
 	for (int i = 0; i < vertexSet.size(); i++)
 	{
-		if (vertexSet.at(i)->info == sourc)
+		for (int j = 0; j < vertexSet.at(i)->adj.size(); j++)
 		{
-			for (int j = 0; j < vertexSet.size(); j++)
-			{
-				if (vertexSet.at(j)->info == dest)
-				{
-					Edge<T> e(vertexSet.at(j), w, id);
-					vertexSet.at(i)->adj.push_back(e);
-					vertexSet.at(j)->indegree++;
-					return true;
-				}
-			}
-			return false;
+			const Edge<T> &e = vertexSet.at(i)->adj.at(j);
+			w[e.index] = f(e);
 		}
 	}
-	return false;
+	layers[m].swap(w);
+	weightsVersion++;
 }
 
 template <class T>
-bool Graph<T>::addEdge(const T &sourc, const T &dest, double w)
+double Graph<T>::getPathLength(const vector<T> &path)
 {
-	for (int i = 0; i < vertexSet.size(); i++)
+	double res = 0;
+	for (int i = 1; i < path.size(); i++)
 	{
-		if (vertexSet.at(i)->info == sourc)
+		Vertex<T>* v = getVertex(path.at(i - 1));
+		double best = INT_INFINITY;
+		for (int j = 0; j < v->adj.size(); j++)
 		{
-			for (int j = 0; j < vertexSet.size(); j++)
+			if (v->adj.at(j).dest->info == path.at(i))
+				best = min(best, v->adj.at(j).weight);
+		}
+		if (best == INT_INFINITY)
+			return INT_INFINITY;
+		res += best;
+	}
+	return res;
+}
+
+template <class T>
+vector<int> Graph<T>::updateEdges(const vector<edge_update_t> &updates)
+{
+	vector<int> res;
+	for (int i = 0; i < updates.size(); i++)
+	{
+		int e = updates.at(i).edge;
+		if (e < 0 || e >= numEdges || edgeDest.at(e) == NULL)
+			continue;
+		if (updates.at(i).weight >= INT_INFINITY)
+			closed[e] = true;
+		else
+		{
+			if (closed[e] || (updates.at(i).weight >= 0 && updates.at(i).weight < layers[metric][e]))
+				weightsVersion++;
+			closed[e] = false;
+			if (updates.at(i).weight >= 0)
+				layers[metric][e] = updates.at(i).weight;
+		}
+		res.push_back(e);
+	}
+	return res;
+}
+
+template <class T>
+bool Graph<T>::isEdgeClosed(int edge) const
+{
+	return closed.at(edge);
+}
+
+template <class T>
+sp_tree_t Graph<T>::computeShortestPathTree(const T &s) const
+{
+	sp_tree_t tree;
+	tree.metric = metric;
+	tree.dist.assign(vertexSet.size(), INT_INFINITY);
+	tree.pred.assign(vertexSet.size(), -1);
+	tree.source = vertexSlots[findSlot(s)];
+	if (tree.source == -1)
+		return tree;
+
+	vector<int> none;
+	tree.dist[tree.source] = 0;
+	repairShortestPathTree(tree, none);
+	return tree;
+}
+
+template <class T>
+int Graph<T>::repairShortestPathTree(sp_tree_t &tree, const vector<int> &changed) const
+{
+	typedef pair<double, int> entry;
+	vector<entry> pq;
+	int recomputed = 0;
+
+	if (changed.empty())
+		pq.push_back(entry(tree.dist[tree.source], tree.source));
+	else
+	{
+		//First part: find the tree edges whose weight increased, and reset their subtrees
+		vector<vector<int> > children(vertexSet.size());
+		for (int v = 0; v < vertexSet.size(); v++)
+		{
+			if (tree.pred[v] != -1)
+				children[edgeSource[tree.pred[v]]->index].push_back(v);
+		}
+		vector<int> affected;
+		vector<bool> isAffected(vertexSet.size(), false);
+		for (int i = 0; i < changed.size(); i++)
+		{
+			int e = changed.at(i);
+			if (edgeDest[e] == NULL)
+				continue;
+			int v = edgeDest[e]->index;
+			if (tree.pred[v] == e && !isAffected[v])
 			{
-				if (vertexSet.at(j)->info == dest)
+				double w = closed[e] ? INT_INFINITY : layers[tree.metric][e];
+				if (tree.dist[edgeSource[e]->index] + w != tree.dist[v])
 				{
-					Edge<T> e(vertexSet.at(j), w, 0);
-					vertexSet.at(i)->adj.push_back(e);
-					vertexSet.at(j)->indegree++;
-					return true;
+					isAffected[v] = true;
+					affected.push_back(v);
 				}
 			}
-			return false;
 		}
+		for (int i = 0; i < affected.size(); i++)
+		{
+			for (int j = 0; j < children[affected[i]].size(); j++)
+			{
+				int c = children[affected[i]][j];
+				if (!isAffected[c])
+				{
+					isAffected[c] = true;
+					affected.push_back(c);
+				}
+			}
+		}
+
+		//Second part: give each affected vertex its best distance through unaffected vertexes
+		for (int i = 0; i < affected.size(); i++)
+		{
+			int v = affected[i];
+			tree.dist[v] = INT_INFINITY;
+			tree.pred[v] = -1;
+			for (int j = 0; j < vertexSet[v]->incoming.size(); j++)
+			{
+				int u = vertexSet[v]->incoming[j].first->index;
+				int e = vertexSet[v]->incoming[j].second;
+				if (isAffected[u] || closed[e] || tree.dist[u] >= INT_INFINITY)
+					continue;
+				double d = tree.dist[u] + layers[tree.metric][e];
+				if (d < tree.dist[v])
+				{
+					tree.dist[v] = d;
+					tree.pred[v] = e;
+				}
+			}
+			if (tree.dist[v] < INT_INFINITY)
+				pq.push_back(entry(tree.dist[v], v));
+		}
+
+		//Third part: edges whose weight decreased may shorten the path to their destiny
+		for (int i = 0; i < changed.size(); i++)
+		{
+			int e = changed.at(i);
+			if (edgeDest[e] == NULL || closed[e])
+				continue;
+			int u = edgeSource[e]->index, v = edgeDest[e]->index;
+			double d = tree.dist[u] + layers[tree.metric][e];
+			if (tree.dist[u] < INT_INFINITY && d < tree.dist[v])
+			{
+				tree.dist[v] = d;
+				tree.pred[v] = e;
+				pq.push_back(entry(d, v));
+			}
+		}
+		make_heap(pq.begin(), pq.end(), greater<entry>());
 	}
-	return false;
+
+	//Fourth part: propagate the new distances with Dijkstra's algorithm
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		entry top = pq.back();
+		pq.pop_back();
+		int v = top.second;
+		if (top.first > tree.dist[v])
+			continue;
+		recomputed++;
+
+		for (int i = 0; i < vertexSet[v]->adj.size(); i++)
+		{
+			const Edge<T> &e = vertexSet[v]->adj[i];
+			if (closed[e.index])
+				continue;
+			int w = e.dest->index;
+			double d = tree.dist[v] + layers[tree.metric][e.index];
+			if (d < tree.dist[w])
+			{
+				tree.dist[w] = d;
+				tree.pred[w] = e.index;
+				pq.push_back(entry(d, w));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+	return recomputed;
+}
+
+template <class T>
+vector<T> Graph<T>::getTreePath(const sp_tree_t &tree, const T &dest)
+{
+	Vertex<T>* v = getVertex(dest);
+	if (v == NULL)
+		return vector<T>();
+	vector<int> indexes;
+	getTreePath(tree, v->index, indexes);
+	vector<T> res;
+	res.reserve(indexes.size());
+	for (int i = 0; i < indexes.size(); i++)
+		res.push_back(vertexSet[indexes[i]]->info);
+	return res;
+}
+
+template <class T>
+void Graph<T>::getTreePath(const sp_tree_t &tree, int dest, vector<int> &path) const
+{
+	path.clear();
+	if (tree.dist[dest] >= INT_INFINITY)
+		return;
+
+	//the path is walked twice, to count its vertexes and then to write them from the end; in trees with turn
+	//states, the path goes back through the entry each one was reached from instead of the start of its edge
+	bool states = !tree.parent.empty();
+	int length = 1;
+	for (int v = dest; tree.pred[v] != -1; v = (states ? tree.parent[v] : edgeSource[tree.pred[v]]->index))
+		length++;
+	path.resize(length);
+	path[--length] = dest;
+	for (int v = dest; tree.pred[v] != -1; v = (states ? tree.parent[v] : edgeSource[tree.pred[v]]->index))
+		path[--length] = edgeSource[tree.pred[v]]->index;
 }
 
 template <class T>
@@ -452,11 +1188,19 @@ bool Graph<T>::removeVertex(const T &in)
 	{
 		if (vertexSet.at(i)->info == in)
 		{
-			for (int j = 0; j < vertexSet.at(i)->adj.size(); j++)
-				removeEdge(vertexSet.at(i)->info, vertexSet.at(i)->adj.at(j).dest->info);
-
-			delete vertexSet.at(i);
+			Vertex<T>* v = vertexSet.at(i);
+			while (!v->adj.empty())
+				removeEdge(v->info, v->adj.back().dest->info);
+			while (!v->incoming.empty())
+				removeEdge(v->incoming.back().first->info, v->info);
+
+			//the memory of the vertex stays in the arena until the graph is destroyed
+			v->~Vertex<T>();
 			vertexSet.erase(vertexSet.begin() + i);
+			for (int j = i; j < vertexSet.size(); j++)
+				vertexSet.at(j)->index = j;
+			weightsVersion++;
+			rehash(slotBits);
 			return true;
 		}
 	}
@@ -474,15 +1218,19 @@ bool Graph<T>::removeEdge(const T &sourc, const T &dest)
 			{
 				if (vertexSet.at(i)->adj.at(j).dest->info == dest)
 				{
+					Vertex<T>* w = vertexSet.at(i)->adj.at(j).dest;
+					int index = vertexSet.at(i)->adj.at(j).index;
 					vertexSet.at(i)->adj.erase(vertexSet.at(i)->adj.begin() + j);
-					for (int k = 0; j < vertexSet.size(); k++)
+					for (int k = 0; k < w->incoming.size(); k++)
 					{
-						if (vertexSet.at(k)->info == dest)
+						if (w->incoming.at(k).second == index)
 						{
-							vertexSet.at(k)->indegree--;
+							w->incoming.erase(w->incoming.begin() + k);
 							break;
 						}
 					}
+					w->indegree--;
+					edgeDest.at(index) = NULL;
 					return true;
 				}
 			}
@@ -494,12 +1242,10 @@ bool Graph<T>::removeEdge(const T &sourc, const T &dest)
 template <class T>
 Vertex<T>* Graph<T>::getVertex(const T &info)
 {
-	for (int i = 0; i < vertexSet.size(); i++)
-	{
-		if (vertexSet.at(i)->getInfo() == info)
-			return vertexSet.at(i);
-	}
-	return NULL;
+	int index = vertexSlots[findSlot(info)];
+	if (index == -1)
+		return NULL;
+	return vertexSet.at(index);
 }
 
 template <class T>
@@ -738,30 +1484,31 @@ void Graph<T>::dijkstraShortestPath(const T &s)
 	Vertex<T>* v = getVertex(s);
 	v->dist = 0;
 
-	vector< Vertex<T>* > pq;
-	pq.push_back(v);
-	make_heap(pq.begin(), pq.end());
+	//lazy deletion heap, ordered by distance
+	typedef pair<double, Vertex<T>*> entry;
+	vector<entry> pq;
+	pq.push_back(entry(0, v));
 
 	while( !pq.empty() )
 	{
-		v = pq.front();
-		pop_heap(pq.begin(), pq.end());
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		v = pq.back().second;
 		pq.pop_back();
+		if (v->processed)
+			continue;
+		v->processed = true;
 
 		for(unsigned int i = 0; i < v->adj.size(); i++)
 		{
 			Vertex<T>* w = v->adj[i].dest;
+			double d = v->dist + getEdgeWeight(v->adj[i]);
 
-			if(v->dist + v->adj[i].weight < w->dist )
+			if(d < w->dist)
 			{
-				w->dist = v->dist + v->adj[i].weight;
+				w->dist = d;
 				w->path = v;
-				if(!w->processed)
-				{
-					w->processed = true;
-					pq.push_back(w);
-				}
-				make_heap (pq.begin(),pq.end(),vertex_greater_than<T>());
+				pq.push_back(entry(d, w));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
 			}
 		}
 	}
@@ -779,39 +1526,349 @@ int Graph<T>::dijkstraShortestPath(const T &s, const T &d)
 
 	Vertex<T>* v = getVertex(s);
 	v->dist = 0;
+	settled = 0;
 
-	vector< Vertex<T>* > pq;
-	pq.push_back(v);
-	make_heap(pq.begin(), pq.end());
+	//lazy deletion heap, ordered by distance
+	typedef pair<double, Vertex<T>*> entry;
+	vector<entry> pq;
+	pq.push_back(entry(0, v));
 
 	while( !pq.empty() )
 	{
-		v = pq.front();
-		if (v->getInfo() == d)
-			return v->dist;
-		pop_heap(pq.begin(), pq.end());
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		v = pq.back().second;
 		pq.pop_back();
+		if (v->processed)
+			continue;
+		v->processed = true;
+		settled++;
+		if (v->getInfo() == d)
+			return v->getDist();
 
 		for(unsigned int i = 0; i < v->adj.size(); i++)
 		{
 			Vertex<T>* w = v->adj[i].dest;
+			double nd = v->dist + getEdgeWeight(v->adj[i]);
 
-			if(v->dist + v->adj[i].weight < w->dist )
+			if(nd < w->dist)
 			{
-				w->dist = v->dist + v->adj[i].weight;
+				w->dist = nd;
 				w->path = v;
-				if(!w->processed)
+				pq.push_back(entry(nd, w));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+	return INT_INFINITY;
+}
+
+template <class T>
+void Graph<T>::landmarkDistances(int source, bool backward, vector<double> &dist) const
+{
+	typedef pair<double, int> entry;
+	dist.assign(vertexSet.size(), INT_INFINITY);
+	dist[source] = 0;
+	vector<entry> pq(1, entry(0, source));
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		entry top = pq.back();
+		pq.pop_back();
+		int v = top.second;
+		if (top.first > dist[v])
+			continue;
+
+		const Vertex<T>* u = vertexSet[v];
+		int degree = (backward ? u->incoming.size() : u->adj.size());
+		for (int i = 0; i < degree; i++)
+		{
+			int e = (backward ? u->incoming[i].second : u->adj[i].index);
+			int w = (backward ? u->incoming[i].first->index : u->adj[i].dest->index);
+			if (closed[e])
+				continue;
+			double d = dist[v] + layers[metric][e];
+			if (d < dist[w])
+			{
+				dist[w] = d;
+				pq.push_back(entry(d, w));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+}
+
+template <class T>
+double Graph<T>::landmarkBound(const alt_landmarks_t &lm, int v, int t) const
+{
+	//by the triangle inequality, d(v,t) >= d(L,t) - d(L,v) and d(v,t) >= d(v,L) - d(t,L); if L reaches v but not t,
+	//or t reaches L but v does not, then t cannot be reached from v
+	double best = 0;
+	for (int i = 0; i < lm.landmarks.size(); i++)
+	{
+		if (lm.from[i][v] < INT_INFINITY)
+		{
+			if (lm.from[i][t] >= INT_INFINITY)
+				return INT_INFINITY;
+			best = max(best, lm.from[i][t] - lm.from[i][v]);
+		}
+		if (lm.to[i][t] < INT_INFINITY)
+		{
+			if (lm.to[i][v] >= INT_INFINITY)
+				return INT_INFINITY;
+			best = max(best, lm.to[i][v] - lm.to[i][t]);
+		}
+	}
+	return best;
+}
+
+template <class T>
+int Graph<T>::avoidRoot(int chosen) const
+{
+	return (int)((chosen * 2654435761u) % vertexSet.size());
+}
+
+template <class T>
+int Graph<T>::avoidLandmark(const alt_landmarks_t &lm, const sp_tree_t &tree) const
+{
+	int n = vertexSet.size();
+	int root = tree.source;
+
+	//children of each vertex in the tree, in flat arrays
+	vector<int> start(n + 1, 0), children(n);
+	for (int v = 0; v < n; v++)
+		if (tree.pred[v] != -1)
+			start[edgeSource[tree.pred[v]]->index + 1]++;
+	for (int v = 0; v < n; v++)
+		start[v + 1] += start[v];
+	vector<int> next(start.begin(), start.end() - 1);
+	for (int v = 0; v < n; v++)
+		if (tree.pred[v] != -1)
+			children[next[edgeSource[tree.pred[v]]->index]++] = v;
+
+	//the size of a vertex is how much the bounds fall short over its subtree, or 0 if there is a landmark in it;
+	//the vertexes are visited in depth-first order, so going backwards every child comes before its parent
+	vector<bool> isLandmark(n, false);
+	for (int i = 0; i < lm.landmarks.size(); i++)
+		isLandmark[lm.landmarks[i]] = true;
+	vector<int> order(1, root);
+	for (int i = 0; i < order.size(); i++)
+		for (int j = start[order[i]]; j < start[order[i] + 1]; j++)
+			order.push_back(children[j]);
+	vector<double> size(n, 0);
+	vector<bool> covered(n, false);
+	for (int i = order.size() - 1; i >= 0; i--)
+	{
+		int v = order[i];
+		covered[v] = isLandmark[v];
+		size[v] = tree.dist[v] - landmarkBound(lm, root, v);
+		for (int j = start[v]; j < start[v + 1]; j++)
+		{
+			covered[v] = covered[v] || covered[children[j]];
+			size[v] += size[children[j]];
+		}
+		if (covered[v])
+			size[v] = 0;
+	}
+
+	int best = root;
+	for (int i = 0; i < order.size(); i++)
+		if (size[order[i]] > size[best])
+			best = order[i];
+	if (size[best] <= 0)
+		return -1;
+	while (start[best] != start[best + 1])
+	{
+		int child = children[start[best]];
+		for (int j = start[best]; j < start[best + 1]; j++)
+			if (size[children[j]] > size[child])
+				child = children[j];
+		best = child;
+	}
+	return best;
+}
+
+template <class T>
+alt_landmarks_t Graph<T>::computeLandmarks(int count, landmark_selection_t selection) const
+{
+	alt_landmarks_t lm;
+	lm.metric = metric;
+	lm.version = weightsVersion;
+	int n = vertexSet.size();
+	vector<double> minDist(n, INT_INFINITY);
+	sp_tree_t tree;		//tree the next "avoid" landmark is chosen from, computed along with the landmark before
+	if (selection == AVOID_LANDMARKS && n > 0)
+		tree = computeShortestPathTree(vertexSet[avoidRoot(0)]->info);
+	while (lm.landmarks.size() < count && lm.landmarks.size() < n)
+	{
+		int next = -1;
+		if (selection == AVOID_LANDMARKS)
+			next = avoidLandmark(lm, tree);
+		if (next == -1 && lm.landmarks.empty())
+		{
+			//the first farthest landmark is the vertex farthest from the first vertex
+			vector<double> dist;
+			landmarkDistances(0, false, dist);
+			for (int v = 0; v < n; v++)
+				if (dist[v] < INT_INFINITY && (next == -1 || dist[v] > dist[next]))
+					next = v;
+		}
+		else if (next == -1)
+		{
+			//the vertex farthest from the landmarks, measured both from and to them, since a landmark on a
+			//one-way street may reach few vertexes while many reach it
+			for (int v = 0; v < n; v++)
+				if (minDist[v] < INT_INFINITY && minDist[v] > 0 && (next == -1 || minDist[v] > minDist[next]))
+					next = v;
+		}
+		if (next == -1)
+			break;
+
+		lm.landmarks.push_back(next);
+		lm.from.push_back(vector<double>());
+		lm.to.push_back(vector<double>());
+		vector<thread> searches;
+		searches.push_back(thread(&Graph<T>::landmarkDistances, this, next, true, ref(lm.to.back())));
+		if (selection == AVOID_LANDMARKS && lm.landmarks.size() < count && lm.landmarks.size() < n)
+		{
+			const T &root = vertexSet[avoidRoot(lm.landmarks.size())]->info;
+			searches.push_back(thread([this, &tree, &root]() { tree = computeShortestPathTree(root); }));
+		}
+		landmarkDistances(next, false, lm.from.back());
+		for (int i = 0; i < searches.size(); i++)
+			searches[i].join();
+		for (int v = 0; v < n; v++)
+			minDist[v] = min(minDist[v], min(lm.from.back()[v], lm.to.back()[v]));
+	}
+	return lm;
+}
+
+template <class T>
+int Graph<T>::altShortestPath(const alt_landmarks_t &lm, const T &s, const T &d)
+{
+	for(unsigned int i = 0; i < vertexSet.size(); i++)
+	{
+		vertexSet[i]->path = NULL;
+		vertexSet[i]->dist = INT_INFINITY;
+		vertexSet[i]->processed = false;
+	}
+	settled = 0;
+	Vertex<T>* v = getVertex(s);
+	Vertex<T>* target = getVertex(d);
+	if (v == NULL || target == NULL)
+		return INT_INFINITY;
+	bool bounded = (lm.metric == metric && lm.version == weightsVersion && !lm.landmarks.empty());
+	v->dist = 0;
+
+	//lazy deletion heap, ordered by distance plus the bound on the distance left
+	typedef pair<double, Vertex<T>*> entry;
+	vector<entry> pq;
+	pq.push_back(entry(0, v));
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		v = pq.back().second;
+		pq.pop_back();
+		if (v->processed)
+			continue;
+		v->processed = true;
+		settled++;
+		if (v == target)
+			return v->getDist();
+
+		for (int i = 0; i < v->adj.size(); i++)
+		{
+			Vertex<T>* w = v->adj[i].dest;
+			double nd = v->dist + getEdgeWeight(v->adj[i]);
+			if (nd < w->dist)
+			{
+				w->dist = nd;
+				w->path = v;
+				double bound = (bounded ? landmarkBound(lm, w->index, target->index) : 0);
+				if (bound < INT_INFINITY)
 				{
-					w->processed = true;
-					pq.push_back(w);
+					pq.push_back(entry(nd + bound, w));
+					push_heap(pq.begin(), pq.end(), greater<entry>());
 				}
-				make_heap (pq.begin(),pq.end(),vertex_greater_than<T>());
 			}
 		}
 	}
 	return INT_INFINITY;
 }
 
+template <class T>
+int Graph<T>::getSearchSpace() const
+{
+	return settled;
+}
+
+template <class T>
+sp_tree_t Graph<T>::timeDependentShortestPathTree(const T &s, double departure,
+		function<double(const Edge<T> &, double)> travel, function<double(const Edge<T> &, double)> weight) const
+{
+	typedef pair<double, int> entry;
+	sp_tree_t tree;
+	tree.metric = metric;
+	tree.dist.assign(vertexSet.size(), INT_INFINITY);
+	tree.pred.assign(vertexSet.size(), -1);
+	tree.source = vertexSlots[findSlot(s)];
+	if (tree.source == -1)
+		return tree;
+
+	//arrival time at each vertex, by the path of the tree, at which the edges leaving it are entered
+	vector<double> arrival(vertexSet.size(), INT_INFINITY);
+	arrival[tree.source] = departure;
+	tree.dist[tree.source] = 0;
+	vector<entry> pq(1, entry(0, tree.source));
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		entry top = pq.back();
+		pq.pop_back();
+		int u = top.second;
+		if (top.first > tree.dist[u])
+			continue;
+
+		const ArenaArray<Edge<T> > &adj = vertexSet[u]->adj;
+		for (int i = 0; i < adj.size(); i++)
+		{
+			if (closed[adj[i].index])
+				continue;
+			double seconds = travel(adj[i], arrival[u]);
+			int v = adj[i].dest->index;
+			double d = top.first + weight(adj[i], seconds);
+			if (d < tree.dist[v])
+			{
+				tree.dist[v] = d;
+				tree.pred[v] = adj[i].index;
+				arrival[v] = arrival[u] + seconds;
+				pq.push_back(entry(d, v));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+	return tree;
+}
+
+template <class T>
+double Graph<T>::getPathTravelTime(const vector<T> &path, double departure, function<double(const Edge<T> &, double)> travel)
+{
+	double t = departure;
+	for (int i = 1; i < path.size(); i++)
+	{
+		Vertex<T>* v = getVertex(path.at(i - 1));
+		double best = INT_INFINITY;
+		for (int j = 0; j < v->adj.size(); j++)
+		{
+			if (v->adj.at(j).dest->info == path.at(i))
+				best = min(best, travel(v->adj.at(j), t));
+		}
+		if (best == INT_INFINITY)
+			return INT_INFINITY;
+		t += best;
+	}
+	return t - departure;
+}
+
 template <class T>
 void Graph<T>::resetVisited()
 {
@@ -849,7 +1906,7 @@ int Graph<T>::primMinimumSpanningTree(const T &s, const T &d)
 
 		for (int k = 0; k < this->getNumVertex(); k++)
 		{
-			vector<Edge<T> > adj = vertexSet[u]->getAdj();
+			const ArenaArray<Edge<T> > &adj = vertexSet[u]->getAdj();
 			int index = -1;
 			for (unsigned j = 0; j < adj.size(); j++)
 				if(adj[j].getDest()==vertexSet[k])
@@ -0,0 +1,523 @@
+#include "HubLabels.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * A hub of a label, while the labels are built
+ */
+struct hub_entry_t
+{
+	int hub;				/// rank of the hub
+	double dist;			/// distance to or from the hub
+};
+
+/**
+ * Edges of a graph in a flat array, grouped by the vertex they start from (or end at, for the reverse graph)
+ */
+struct label_graph_t
+{
+	vector<int> start;		/// position of the first edge of each vertex (plus the end)
+	vector<int> to;			/// other end of each edge
+	vector<double> weight;	/// weight of each edge
+};
+
+/**
+ * Gets the edges of a graph that are not closed, forwards and backwards
+ */
+static void flatten(const Graph<RoadNode> &graph, label_graph_t &forward, label_graph_t &backward)
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	int n = vs.size();
+	forward.start.assign(n + 1, 0);
+	backward.start.assign(n + 1, 0);
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs[i]->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			double w = graph.getEdgeWeight(adj[j]);
+			if (w >= INT_INFINITY)
+				continue;
+			forward.to.push_back(adj[j].getDest()->getIndex());
+			forward.weight.push_back(w);
+			backward.start[adj[j].getDest()->getIndex() + 1]++;
+		}
+		forward.start[i + 1] = forward.to.size();
+	}
+	for (int i = 0; i < n; i++)
+		backward.start[i + 1] += backward.start[i];
+	backward.to.resize(forward.to.size());
+	backward.weight.resize(forward.to.size());
+	vector<int> next(backward.start.begin(), backward.start.end() - 1);
+	for (int i = 0; i < n; i++)
+		for (int k = forward.start[i]; k < forward.start[i + 1]; k++)
+		{
+			int p = next[forward.to[k]]++;
+			backward.to[p] = i;
+			backward.weight[p] = forward.weight[k];
+		}
+}
+
+/**
+ * Hashes the edges of a graph that are not closed, with their weights in the selected metric (FNV-1a over the
+ * end and the weight of each edge, vertex by vertex), so that labels built for other weights can be told apart
+ */
+static uint64_t hashWeights(const Graph<RoadNode> &graph)
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	uint64_t hash = 14695981039346656037ULL;
+	for (int i = 0; i < vs.size(); i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs[i]->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			double w = graph.getEdgeWeight(adj[j]);
+			if (w >= INT_INFINITY)
+				continue;
+			int32_t ends[2] = {i, adj[j].getDest()->getIndex()};
+			unsigned char bytes[sizeof(ends) + sizeof(w)];
+			memcpy(bytes, ends, sizeof(ends));
+			memcpy(bytes + sizeof(ends), &w, sizeof(w));
+			for (int k = 0; k < sizeof(bytes); k++)
+				hash = (hash ^ bytes[k]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+/**
+ * Ranks the vertices by how many shortest paths go through them: the size of the subtree of each vertex is
+ * added up over the trees from a few vertices spread over the graph (ties are broken by degree)
+ * @return the vertices, from the most important to the least
+ */
+static vector<int> rankVertices(const label_graph_t &forward, const label_graph_t &backward)
+{
+	typedef pair<double, int> entry;
+	int n = forward.start.size() - 1;
+	vector<long long> score(n, 0);
+	vector<double> dist(n, INT_INFINITY);
+	vector<int> parent(n, -1), position(n, -1), settled;
+	vector<entry> pq;
+	for (int sample = 0; sample < HUB_LABELS_ORDER_SAMPLES && sample < n; sample++)
+	{
+		int s = (long long)sample * n / min(n, HUB_LABELS_ORDER_SAMPLES);
+		dist[s] = 0;
+		pq.push_back(entry(0, s));
+		while (!pq.empty())
+		{
+			pop_heap(pq.begin(), pq.end(), greater<entry>());
+			entry top = pq.back();
+			pq.pop_back();
+			int u = top.second;
+			if (top.first > dist[u])
+				continue;
+			position[u] = settled.size();
+			settled.push_back(u);
+			for (int k = forward.start[u]; k < forward.start[u + 1]; k++)
+			{
+				int v = forward.to[k];
+				double d = dist[u] + forward.weight[k];
+				if (d < dist[v])
+				{
+					dist[v] = d;
+					parent[v] = u;
+					pq.push_back(entry(d, v));
+					push_heap(pq.begin(), pq.end(), greater<entry>());
+				}
+			}
+		}
+		//vertices are settled in order of distance, so going backwards every child comes before its parent
+		vector<int> subtree(settled.size(), 1);
+		for (int i = settled.size() - 1; i > 0; i--)
+			subtree[position[parent[settled[i]]]] += subtree[i];
+		for (int i = 0; i < settled.size(); i++)
+		{
+			score[settled[i]] += subtree[i];
+			dist[settled[i]] = INT_INFINITY;
+			parent[settled[i]] = -1;
+		}
+		settled.clear();
+	}
+
+	vector<int> order(n);
+	for (int i = 0; i < n; i++)
+		order[i] = i;
+	sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		if (score[a] != score[b])
+			return score[a] > score[b];
+		int da = forward.start[a + 1] - forward.start[a] + backward.start[a + 1] - backward.start[a];
+		int db = forward.start[b + 1] - forward.start[b] + backward.start[b + 1] - backward.start[b];
+		if (da != db)
+			return da > db;
+		return a < b;
+	});
+	return order;
+}
+
+/**
+ * Appends a number to a buffer as a varint (7 bits per byte, from the lowest, with the top bit set on all bytes but the last)
+ */
+static void putVarint(vector<unsigned char> &buffer, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		buffer.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	buffer.push_back(value);
+}
+
+/**
+ * Reads a varint written by putVarint
+ * @param p position of the varint, moved past it
+ * @return the number
+ */
+static inline uint32_t getVarint(const unsigned char* &p)
+{
+	uint32_t value = 0;
+	int shift = 0;
+	while (*p & 0x80)
+	{
+		value |= (uint32_t)(*p++ & 0x7F) << shift;
+		shift += 7;
+	}
+	return value | ((uint32_t)*p++ << shift);
+}
+
+HubLabels::HubLabels(): mapped(NULL), mappedSize(0), header(NULL)
+{
+}
+
+HubLabels::~HubLabels()
+{
+	release();
+}
+
+void HubLabels::release()
+{
+#ifdef __linux__
+	if (mapped != NULL)
+		munmap(mapped, mappedSize);
+#endif
+	mapped = NULL;
+	mappedSize = 0;
+	vector<char>().swap(storage);
+	header = NULL;
+}
+
+bool HubLabels::setPointers(const char* base, size_t size)
+{
+	header = NULL;
+	if (size < sizeof(hub_labels_header_t))
+		return false;
+	const hub_labels_header_t* h = reinterpret_cast<const hub_labels_header_t*>(base);
+	if (h->magic != HUB_LABELS_MAGIC || h->numVertex < 0)
+		return false;
+
+	//the header, then for each direction the first hub and first byte of each vertex and the distances, then the hubs
+	size_t n = h->numVertex;
+	size_t expected = sizeof(hub_labels_header_t);
+	for (int d = 0; d < 2; d++)
+		expected += 2 * (n + 1) * sizeof(uint32_t) + (size_t)h->entries[d] * sizeof(float);
+	expected += (size_t)h->bytes[0] + h->bytes[1];
+	if (size != expected)
+		return false;
+
+	const char* p = base + sizeof(hub_labels_header_t);
+	for (int d = 0; d < 2; d++)
+	{
+		entryStart[d] = reinterpret_cast<const uint32_t*>(p);
+		p += (n + 1) * sizeof(uint32_t);
+		byteStart[d] = reinterpret_cast<const uint32_t*>(p);
+		p += (n + 1) * sizeof(uint32_t);
+		dists[d] = reinterpret_cast<const float*>(p);
+		p += (size_t)h->entries[d] * sizeof(float);
+	}
+	for (int d = 0; d < 2; d++)
+	{
+		hubs[d] = reinterpret_cast<const unsigned char*>(p);
+		p += h->bytes[d];
+	}
+	for (int d = 0; d < 2; d++)
+		if (entryStart[d][n] != h->entries[d] || byteStart[d][n] != h->bytes[d])
+			return false;
+	header = h;
+	return true;
+}
+
+bool HubLabels::build(const Graph<RoadNode> &graph, size_t maxBytes)
+{
+	typedef pair<double, int> entry;
+	release();
+	label_graph_t g[2];
+	flatten(graph, g[0], g[1]);
+	int n = graph.getVertexSet().size();
+	vector<int> order = rankVertices(g[0], g[1]);
+
+	//labels[0] are the forward labels, filled by the searches over the reverse graph, and labels[1] the backward ones
+	vector<vector<hub_entry_t> > labels[2];
+	labels[0].resize(n);
+	labels[1].resize(n);
+	vector<double> dist(n, INT_INFINITY), hubDist(n, INT_INFINITY);
+	vector<int> reached;
+	vector<entry> pq;
+
+	//memory taken while labelling: the flat graphs, the work arrays and the labels as they grow (their capacity)
+	size_t footprint = 2 * n * sizeof(vector<hub_entry_t>) + 2 * n * sizeof(double) + order.size() * sizeof(int);
+	for (int d = 0; d < 2; d++)
+		footprint += g[d].start.capacity() * sizeof(int) + g[d].to.capacity() * sizeof(int) + g[d].weight.capacity() * sizeof(double);
+	if (footprint > maxBytes)
+		return false;
+	for (int r = 0; r < n; r++)
+	{
+		int v = order[r];
+		for (int d = 0; d < 2; d++)
+		{
+			//a search forwards from v adds v to the backward labels of the vertices it reaches, and a search
+			//backwards to the forward labels; hubDist has the distances of v's own label on the other side
+			const label_graph_t &edges = g[d];
+			vector<vector<hub_entry_t> > &own = labels[d], &other = labels[1 - d];
+			for (int i = 0; i < own[v].size(); i++)
+				hubDist[own[v][i].hub] = own[v][i].dist;
+			dist[v] = 0;
+			reached.push_back(v);
+			pq.push_back(entry(0, v));
+			while (!pq.empty())
+			{
+				pop_heap(pq.begin(), pq.end(), greater<entry>());
+				entry top = pq.back();
+				pq.pop_back();
+				int u = top.second;
+				if (top.first > dist[u])
+					continue;
+
+				//pruned if the hubs labelled so far already give the distance
+				bool pruned = false;
+				const vector<hub_entry_t> &label = other[u];
+				for (int i = 0; i < label.size() && !pruned; i++)
+					pruned = (hubDist[label[i].hub] + label[i].dist <= dist[u]);
+				if (pruned)
+					continue;
+				size_t capacity = other[u].capacity();
+				other[u].push_back(hub_entry_t());
+				other[u].back().hub = r;
+				other[u].back().dist = dist[u];
+				footprint += (other[u].capacity() - capacity) * sizeof(hub_entry_t);
+
+				for (int k = edges.start[u]; k < edges.start[u + 1]; k++)
+				{
+					int w = edges.to[k];
+					double nd = dist[u] + edges.weight[k];
+					if (nd < dist[w])
+					{
+						if (dist[w] >= INT_INFINITY)
+							reached.push_back(w);
+						dist[w] = nd;
+						pq.push_back(entry(nd, w));
+						push_heap(pq.begin(), pq.end(), greater<entry>());
+					}
+				}
+			}
+			for (int i = 0; i < reached.size(); i++)
+				dist[reached[i]] = INT_INFINITY;
+			reached.clear();
+			for (int i = 0; i < own[v].size(); i++)
+				hubDist[own[v][i].hub] = INT_INFINITY;
+		}
+		if (footprint > maxBytes)
+			return false;
+	}
+
+	//lays the labels out as in the file (see HubLabels::setPointers)
+	vector<unsigned char> encoded[2];
+	vector<uint32_t> firstByte[2];
+	hub_labels_header_t h;
+	memset(&h, 0, sizeof(h));
+	h.magic = HUB_LABELS_MAGIC;
+	h.numVertex = n;
+	h.numEdges = graph.getNumEdges();
+	h.metric = graph.getMetric();
+	h.weightsHash = hashWeights(graph);
+	for (int d = 0; d < 2; d++)
+	{
+		for (int v = 0; v < n; v++)
+		{
+			firstByte[d].push_back(encoded[d].size());
+			int prev = 0;
+			for (int i = 0; i < labels[d][v].size(); i++)
+			{
+				putVarint(encoded[d], labels[d][v][i].hub - prev);
+				prev = labels[d][v][i].hub;
+			}
+			h.entries[d] += labels[d][v].size();
+		}
+		firstByte[d].push_back(encoded[d].size());
+		h.bytes[d] = encoded[d].size();
+	}
+	size_t size = sizeof(h);
+	for (int d = 0; d < 2; d++)
+		size += 2 * (n + 1) * sizeof(uint32_t) + (size_t)h.entries[d] * sizeof(float);
+	size += (size_t)h.bytes[0] + h.bytes[1];
+
+	//the labels are copied while they are still held, encoded and as they grew
+	for (int d = 0; d < 2; d++)
+		footprint += encoded[d].capacity() + firstByte[d].capacity() * sizeof(uint32_t);
+	if (footprint + size > maxBytes)
+		return false;
+	storage.resize(size);
+	char* p = &storage[0];
+	memcpy(p, &h, sizeof(h));
+	p += sizeof(h);
+	for (int d = 0; d < 2; d++)
+	{
+		uint32_t* first = reinterpret_cast<uint32_t*>(p);
+		memcpy(first + n + 1, &firstByte[d][0], (n + 1) * sizeof(uint32_t));
+		float* distances = reinterpret_cast<float*>(first + 2 * (n + 1));
+		uint32_t e = 0;
+		for (int v = 0; v < n; v++)
+		{
+			first[v] = e;
+			for (int i = 0; i < labels[d][v].size(); i++)
+				distances[e++] = labels[d][v][i].dist;
+		}
+		first[n] = e;
+		p = reinterpret_cast<char*>(distances + e);
+	}
+	for (int d = 0; d < 2; d++)
+	{
+		if (!encoded[d].empty())
+			memcpy(p, &encoded[d][0], encoded[d].size());
+		p += encoded[d].size();
+	}
+	return setPointers(&storage[0], size);
+}
+
+bool HubLabels::save(const string &file) const
+{
+	if (header == NULL)
+		return false;
+	ofstream out(file.c_str(), ios::binary);
+	out.write(reinterpret_cast<const char*>(header), getBytes());
+	return static_cast<bool>(out);
+}
+
+bool HubLabels::load(const string &file, const Graph<RoadNode> &graph)
+{
+	release();
+#ifdef __linux__
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (m != MAP_FAILED)
+		{
+			mapped = static_cast<char*>(m);
+			mappedSize = st.st_size;
+		}
+	}
+	close(fd);
+	if (mapped == NULL || !setPointers(mapped, mappedSize))
+	{
+		release();
+		return false;
+	}
+#else
+	ifstream in(file.c_str(), ios::binary);
+	if (!in.is_open())
+		return false;
+	storage.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	if (!setPointers(storage.empty() ? NULL : &storage[0], storage.size()))
+	{
+		release();
+		return false;
+	}
+#endif
+	if (header->numVertex != graph.getVertexSet().size() || header->numEdges != graph.getNumEdges() ||
+		header->metric != graph.getMetric() || header->weightsHash != hashWeights(graph))
+	{
+		release();
+		return false;
+	}
+	return true;
+}
+
+void HubLabels::clear()
+{
+	release();
+}
+
+bool HubLabels::empty() const
+{
+	return header == NULL;
+}
+
+bool HubLabels::isMapped() const
+{
+	return mapped != NULL;
+}
+
+size_t HubLabels::getBytes() const
+{
+	return (header == NULL ? 0 : (mapped != NULL ? mappedSize : storage.size()));
+}
+
+double HubLabels::getAverageLabelSize() const
+{
+	if (header == NULL || header->numVertex == 0)
+		return 0;
+	return ((double)header->entries[0] + header->entries[1]) / (2.0 * header->numVertex);
+}
+
+double HubLabels::distance(int s, int t) const
+{
+	if (header == NULL || s < 0 || t < 0 || s >= header->numVertex || t >= header->numVertex)
+		return INT_INFINITY;
+
+	//both labels are sorted by rank, so the shared hubs are found by merging them
+	const unsigned char* a = hubs[0] + byteStart[0][s];
+	const unsigned char* b = hubs[1] + byteStart[1][t];
+	uint32_t i = entryStart[0][s], iEnd = entryStart[0][s + 1];
+	uint32_t j = entryStart[1][t], jEnd = entryStart[1][t + 1];
+	if (i == iEnd || j == jEnd)
+		return INT_INFINITY;
+	uint32_t hubA = getVarint(a), hubB = getVarint(b);
+	double best = INT_INFINITY;
+	while (true)
+	{
+		if (hubA == hubB)
+		{
+			double d = (double)dists[0][i] + dists[1][j];
+			if (d < best)
+				best = d;
+			if (++i == iEnd || ++j == jEnd)
+				break;
+			hubA += getVarint(a);
+			hubB += getVarint(b);
+		}
+		else if (hubA < hubB)
+		{
+			if (++i == iEnd)
+				break;
+			hubA += getVarint(a);
+		}
+		else
+		{
+			if (++j == jEnd)
+				break;
+			hubB += getVarint(b);
+		}
+	}
+	return best;
+}
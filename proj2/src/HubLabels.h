@@ -0,0 +1,146 @@
+#ifndef HUBLABELS_H_
+#define HUBLABELS_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define HUB_LABELS_MAGIC 0x32424C48			//"HLB2", at the start of a file of hub labels
+#define HUB_LABELS_ORDER_SAMPLES 16			//shortest path trees used to rank the vertices before labelling them
+#define HUB_LABELS_DEFAULT_MB 256			//memory the labels may take, unless another bound is given
+
+/**
+ * Header of the labels, at the start of their memory (and of their file)
+ */
+struct hub_labels_header_t
+{
+	uint32_t magic;				/// HUB_LABELS_MAGIC
+	int32_t numVertex;			/// amount of vertices of the graph labelled
+	int32_t numEdges;			/// amount of edges of the graph labelled
+	int32_t metric;				/// metric of the distances
+	uint32_t entries[2];		/// amount of hubs of the forward and of the backward labels
+	uint32_t bytes[2];			/// bytes of the encoded hubs of the forward and of the backward labels
+	uint64_t weightsHash;		/// hash of the edges that were open and of their weights, when the graph was labelled
+};
+
+/**
+ * Distance oracle using pruned landmark labelling (Akiba, Iwata and Yoshida). Every vertex has a forward label,
+ * with some vertices (its hubs) it can reach and the distance to each of them, and a backward label, with
+ * some vertices that can reach it and the distance from each of them, such that a shortest path from s to t
+ * always goes through a hub of both the forward label of s and the backward label of t. The distance from s to t
+ * is then the smallest sum over the hubs they share, found by merging both labels, without searching the graph.
+ *
+ * The vertices are labelled from the most important to the least (ranked by how many shortest paths go through
+ * them, over a few sample trees), and each one is labelled by a Dijkstra search that stops wherever the labels
+ * found so far already give the distance, so the labels stay small on road networks.
+ *
+ * The labels are kept in flat arrays: each label is a run of hub ranks in increasing order, stored as varint
+ * deltas, with the distances (as floats) in a parallel array. The arrays are laid out as in their file, so the
+ * file can be memory mapped and used without being parsed.
+ */
+class HubLabels
+{
+private:
+	vector<char> storage;					/// Memory of the labels, when they were built or read
+	char* mapped;							/// Memory of the labels, when their file is mapped (NULL otherwise)
+	size_t mappedSize;						/// Bytes mapped
+	const hub_labels_header_t* header;		/// Header of the labels (NULL if there are none)
+	const uint32_t* entryStart[2];			/// Position of the first hub of each vertex in the forward and backward labels (plus the end)
+	const uint32_t* byteStart[2];			/// Position of the first byte of the hubs of each vertex (plus the end)
+	const float* dists[2];					/// Distance to (forward) or from (backward) each hub
+	const unsigned char* hubs[2];			/// Ranks of the hubs, as varint deltas
+
+	/**
+	 * Points the arrays into the memory of the labels
+	 * @param base start of the memory, where the header is
+	 * @param size bytes of the memory
+	 * @return true if the memory holds the whole labels, false otherwise
+	 */
+	bool setPointers(const char* base, size_t size);
+
+	/**
+	 * Frees the memory of the labels, leaving none
+	 */
+	void release();
+
+public:
+	/**
+	 * Creates an empty oracle, which has no labels
+	 */
+	HubLabels();
+
+	/**
+	 * Frees or unmaps the labels
+	 */
+	~HubLabels();
+
+	HubLabels(const HubLabels &) = delete;
+	HubLabels &operator=(const HubLabels &) = delete;
+
+	/**
+	 * Labels a graph, with the current weights of its edges (closed edges are left out)
+	 * @param graph the graph
+	 * @param maxBytes bound on the memory taken while labelling (the labels as they grow, and then laid out), and so on that of the labels
+	 * @return true if the labels were built, false if they would take more memory than the bound (no labels are left)
+	 */
+	bool build(const Graph<RoadNode> &graph, size_t maxBytes = (size_t)HUB_LABELS_DEFAULT_MB << 20);
+
+	/**
+	 * Writes the labels to a file
+	 * @param file name of the file
+	 * @return true if the file was written
+	 */
+	bool save(const string &file) const;
+
+	/**
+	 * Reads the labels from a file, memory mapping it where possible (on Linux). The file must have been
+	 * written for a graph with the same vertices, edges and metric, with the same edges closed and the same
+	 * weights (told by a hash of them, which is computed again)
+	 * @param file name of the file
+	 * @param graph the graph the labels are used with
+	 * @return true if the labels were read, false if the file is missing, damaged or for another graph (no labels are left)
+	 */
+	bool load(const string &file, const Graph<RoadNode> &graph);
+
+	/**
+	 * Drops the labels, after the weights of the graph changed
+	 */
+	void clear();
+
+	/**
+	 * Checks whether there are labels
+	 * @return true if there are no labels
+	 */
+	bool empty() const;
+
+	/**
+	 * Checks whether the labels are a memory mapped file
+	 * @return true if the labels are mapped
+	 */
+	bool isMapped() const;
+
+	/**
+	 * Gets the memory taken by the labels
+	 * @return bytes of the labels, header included
+	 */
+	size_t getBytes() const;
+
+	/**
+	 * Gets the average amount of hubs per label
+	 * @return hubs of all labels, forward and backward, over twice the amount of vertices
+	 */
+	double getAverageLabelSize() const;
+
+	/**
+	 * Gets the distance from a vertex to another, in the metric the labels were built with. The distances of
+	 * the labels are kept as floats, so it may be off the distance of Graph::computeShortestPathTree by their rounding
+	 * @param s index of the source vertex
+	 * @param t index of the destination vertex
+	 * @return the distance (INT_INFINITY if t cannot be reached from s, or there are no labels)
+	 */
+	double distance(int s, int t) const;
+};
+
+#endif /* HUBLABELS_H_ */
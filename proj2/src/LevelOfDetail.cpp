@@ -0,0 +1,258 @@
+#include "LevelOfDetail.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+/**
+ * Gets the weight of the lightest edge from a vertex to another
+ * @return the weight, or -1 if there is no such edge
+ */
+static double edgeWeight(const vector<Vertex<RoadNode>* > &vs, int from, int to)
+{
+	double res = -1;
+	const ArenaArray<Edge<RoadNode> > &adj = vs.at(from)->getAdj();
+	for (int i = 0; i < adj.size(); i++)
+		if (adj.at(i).getDest()->getIndex() == to && (res < 0 || adj.at(i).getWeight() < res))
+			res = adj.at(i).getWeight();
+	return res;
+}
+
+/**
+ * Walks along a chain, from a junction until the next one, marking its inner vertices as visited
+ * @param start position in neighbours of the first neighbour of each vertex (plus the end)
+ * @param neighbours neighbours of each vertex, vertex after vertex
+ * @param junction true for the junctions
+ * @param visited true for the inner vertices of the chains already walked
+ * @param first the junction where the chain starts
+ * @param second the vertex after the junction
+ * @param vertices where the vertices of the chain are appended
+ * @return the chain, without its direction and weight
+ */
+static lod_chain_t walkChain(const vector<int> &start, const vector<int> &neighbours, const vector<bool> &junction,
+		vector<bool> &visited, int first, int second, vector<int> &vertices)
+{
+	lod_chain_t chain;
+	chain.first = vertices.size();
+	vertices.push_back(first);
+	int prev = first, cur = second;
+	while (true)
+	{
+		vertices.push_back(cur);
+		if (junction.at(cur))
+			break;
+		visited.at(cur) = true;
+		int following = neighbours.at(start.at(cur));
+		if (following == prev)
+			following = neighbours.at(start.at(cur) + 1);
+		prev = cur;
+		cur = following;
+	}
+	chain.count = vertices.size() - chain.first;
+	return chain;
+}
+
+LevelOfDetail::LevelOfDetail(Graph<RoadNode> &graph, const vector<pair<float, float> > &points, const vector<bool> &pinned):
+	points(points), pinned(pinned)
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	int n = vs.size();
+	this->pinned.resize(n, false);
+
+	//neighbours of each vertex, ignoring the direction of the edges and the loops
+	vector<int> start(n + 1, 0), neighbours;
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			start.at(i + 1)++;
+			start.at(adj.at(j).getDest()->getIndex() + 1)++;
+		}
+	}
+	for (int i = 0; i < n; i++)
+		start.at(i + 1) += start.at(i);
+	neighbours.resize(start.at(n));
+	vector<int> next(start.begin(), start.end() - 1);
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			int dest = adj.at(j).getDest()->getIndex();
+			neighbours.at(next.at(i)++) = dest;
+			neighbours.at(next.at(dest)++) = i;
+		}
+	}
+	int size = 0;
+	for (int i = 0; i < n; i++)
+	{
+		vector<int>::iterator first = neighbours.begin() + start.at(i), last = neighbours.begin() + start.at(i + 1);
+		sort(first, last);
+		last = unique(first, last);
+		start.at(i) = size;
+		for (vector<int>::iterator it = first; it != last; it++)
+			if (*it != i)
+				neighbours.at(size++) = *it;
+	}
+	start.at(n) = size;
+
+	vector<bool> junction(n), visited(n, false);
+	for (int i = 0; i < n; i++)
+	{
+		junction.at(i) = (start.at(i + 1) - start.at(i) != 2 || this->pinned.at(i));
+		if (junction.at(i))
+			junctions.push_back(i);
+	}
+
+	//walks from each junction along each of its chains; vertices left unvisited are on cycles without junctions,
+	//so one vertex of each cycle becomes a junction
+	int initialJunctions = junctions.size();
+	for (int k = 0; k < initialJunctions; k++)
+	{
+		int first = junctions.at(k);
+		for (int j = start.at(first); j < start.at(first + 1); j++)
+		{
+			int cur = neighbours.at(j);
+			if ((junction.at(cur) && cur < first) || (!junction.at(cur) && visited.at(cur)))
+				continue;
+			chains.push_back(walkChain(start, neighbours, junction, visited, first, cur, chainVertices));
+		}
+	}
+	for (int i = 0; i < n; i++)
+	{
+		if (junction.at(i) || visited.at(i))
+			continue;
+		junction.at(i) = true;
+		junctions.push_back(i);
+		chains.push_back(walkChain(start, neighbours, junction, visited, i, neighbours.at(start.at(i)), chainVertices));
+	}
+
+	for (int c = 0; c < chains.size(); c++)
+	{
+		lod_chain_t &chain = chains.at(c);
+		chain.forward = true;
+		chain.backward = true;
+		chain.weight = 0;
+		for (int i = chain.first + 1; i < chain.first + chain.count; i++)
+		{
+			double f = edgeWeight(vs, chainVertices.at(i - 1), chainVertices.at(i));
+			double b = edgeWeight(vs, chainVertices.at(i), chainVertices.at(i - 1));
+			chain.forward = chain.forward && f >= 0;
+			chain.backward = chain.backward && b >= 0;
+			chain.weight += (f >= 0 && b >= 0 ? min(f, b) : max(f, b));
+		}
+	}
+}
+
+const vector<lod_chain_t> &LevelOfDetail::getChains() const
+{
+	return chains;
+}
+
+const vector<int> &LevelOfDetail::getChainVertices() const
+{
+	return chainVertices;
+}
+
+lod_level_t LevelOfDetail::getLevel(float scale) const
+{
+	lod_level_t level;
+	level.scale = scale;
+	float cell = LOD_CELL_SIZE / scale;
+
+	//junctions on the same cell are merged (pinned ones are never merged)
+	vector<int> nodeOf(points.size(), -1);
+	unordered_map<long long, int> cells;
+	for (int i = 0; i < junctions.size(); i++)
+	{
+		int v = junctions.at(i);
+		const pair<float, float> &p = points.at(v);
+		int node = -1;
+		if (!pinned.at(v))
+		{
+			long long key = (static_cast<long long>(floor(p.first / cell)) << 32) ^
+							static_cast<unsigned int>(static_cast<int>(floor(p.second / cell)));
+			unordered_map<long long, int>::iterator it = cells.find(key);
+			if (it != cells.end())
+				node = it->second;
+			else
+				cells[key] = level.nodes.size();
+		}
+		if (node == -1)
+		{
+			lod_node_t n;
+			n.vertex = v;
+			n.x = 0;
+			n.y = 0;
+			n.members = 0;
+			n.pinned = pinned.at(v);
+			node = level.nodes.size();
+			level.nodes.push_back(n);
+		}
+		level.nodes.at(node).x += p.first;
+		level.nodes.at(node).y += p.second;
+		level.nodes.at(node).members++;
+		nodeOf.at(v) = node;
+	}
+	for (int i = 0; i < level.nodes.size(); i++)
+	{
+		level.nodes.at(i).x /= level.nodes.at(i).members;
+		level.nodes.at(i).y /= level.nodes.at(i).members;
+	}
+
+	//the points of a chain closer than a screen pixel to the last one kept are skipped, and chains drawn
+	//as straight lines between the same two nodes are merged (if one of them has several junctions)
+	float minDist = 1 / scale;
+	unordered_map<long long, int> straight;
+	if (level.nodes.size() * 2 > junctions.size())
+	{
+		//few junctions were merged, so most chains will be kept
+		level.edges.reserve(chains.size());
+		level.points.reserve(chainVertices.size());
+	}
+	for (int c = 0; c < chains.size(); c++)
+	{
+		const lod_chain_t &chain = chains.at(c);
+		lod_edge_t edge;
+		edge.from = nodeOf.at(chainVertices.at(chain.first));
+		edge.to = nodeOf.at(chainVertices.at(chain.first + chain.count - 1));
+		edge.forward = chain.forward;
+		edge.backward = chain.backward;
+		edge.weight = chain.weight;
+		edge.first = level.points.size();
+		level.points.push_back(pair<float, float>(level.nodes.at(edge.from).x, level.nodes.at(edge.from).y));
+		for (int i = chain.first + 1; i < chain.first + chain.count - 1; i++)
+		{
+			const pair<float, float> &p = points.at(chainVertices.at(i));
+			if (fabs(p.first - level.points.back().first) >= minDist || fabs(p.second - level.points.back().second) >= minDist)
+				level.points.push_back(p);
+		}
+		level.points.push_back(pair<float, float>(level.nodes.at(edge.to).x, level.nodes.at(edge.to).y));
+		edge.count = level.points.size() - edge.first;
+
+		//a loop needs two points besides its node to be visible
+		bool keep = !(edge.from == edge.to && edge.count <= 3);
+		if (keep && edge.count == 2 &&
+			(level.nodes.at(edge.from).members > 1 || level.nodes.at(edge.to).members > 1))
+		{
+			long long key = (static_cast<long long>(min(edge.from, edge.to)) << 32) | max(edge.from, edge.to);
+			unordered_map<long long, int>::iterator it = straight.find(key);
+			if (it != straight.end())
+			{
+				lod_edge_t &other = level.edges.at(it->second);
+				bool same = (other.from == edge.from);
+				other.forward = other.forward || (same ? edge.forward : edge.backward);
+				other.backward = other.backward || (same ? edge.backward : edge.forward);
+				other.weight = min(other.weight, edge.weight);
+				keep = false;
+			}
+			else
+				straight[key] = level.edges.size();
+		}
+		if (keep)
+			level.edges.push_back(edge);
+		else
+			level.points.resize(edge.first);
+	}
+	return level;
+}
@@ -0,0 +1,104 @@
+#ifndef LEVELOFDETAIL_H_
+#define LEVELOFDETAIL_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include <vector>
+
+#define LOD_CELL_SIZE 8			//width and height of the cells whose nodes are merged (in pixels of the screen)
+
+/**
+ * A chain of roads between two junctions, whose inner vertices have exactly two neighbours
+ */
+struct lod_chain_t
+{
+	int first;				/// position of the first vertex in LevelOfDetail::getChainVertices
+	int count;				/// amount of vertices, from a junction to a junction (which may be the same one)
+	bool forward;			/// true if the chain can be travelled from its first vertex to its last
+	bool backward;			/// true if the chain can be travelled from its last vertex to its first
+	double weight;			/// sum of the weights of the edges of the chain (the lightest direction of each one)
+};
+
+/**
+ * A node of a simplified graph, standing for one or more junctions
+ */
+struct lod_node_t
+{
+	int vertex;				/// index of the first vertex merged into the node
+	float x;				/// x coordinate of the node (mean of the merged vertices, in pixels of the map)
+	float y;				/// y coordinate of the node
+	int members;			/// amount of vertices merged into the node
+	bool pinned;			/// true if the node is a pinned vertex, which is never merged
+};
+
+/**
+ * An edge of a simplified graph, drawn as a polyline
+ */
+struct lod_edge_t
+{
+	int from;							/// index of the first node (in lod_level_t::nodes)
+	int to;								/// index of the last node
+	bool forward;						/// true if the edge can be travelled from the first node to the last
+	bool backward;						/// true if the edge can be travelled from the last node to the first
+	double weight;						/// weight of the chain of the edge (the lightest, if several chains were merged)
+	int first;							/// position of the first point of the polyline in lod_level_t::points
+	int count;							/// amount of points of the polyline, from the first node to the last
+};
+
+/**
+ * A simplified graph, for a given scale
+ */
+struct lod_level_t
+{
+	float scale;				/// pixels of the screen per pixel of the map
+	vector<lod_node_t> nodes;	/// nodes of the simplified graph
+	vector<lod_edge_t> edges;	/// edges of the simplified graph
+	vector<pair<float, float> > points;	/// points of the polylines of the edges, edge after edge (in pixels of the map)
+};
+
+/**
+ * Simplifies a graph for drawing. The vertices with exactly two neighbours (most of the points of a road)
+ * are collapsed into chains between junctions, drawn as polylines. At each scale, the junctions that fall on
+ * the same cell of LOD_CELL_SIZE screen pixels are merged into a node, chains inside a node are dropped and
+ * the points of the polylines closer than a pixel are skipped. Pinned vertices (such as markets and clients)
+ * are always junctions and are never merged, so they keep their exact position.
+ */
+class LevelOfDetail
+{
+private:
+	vector<pair<float, float> > points;		/// Position of each vertex on the map (in pixels of the map)
+	vector<bool> pinned;					/// True for the vertices that are never merged
+	vector<lod_chain_t> chains;				/// Chains between junctions, covering every edge of the graph once
+	vector<int> chainVertices;				/// Indexes of the vertices of the chains, chain after chain
+	vector<int> junctions;					/// Indexes of the vertices at the ends of the chains
+
+public:
+	/**
+	 * Splits a graph into chains between junctions
+	 * @param graph the graph
+	 * @param points position of each vertex on the map (same order as the vertex set, in pixels of the map)
+	 * @param pinned true for the vertices that must be kept as they are (same order, may be empty)
+	 */
+	LevelOfDetail(Graph<RoadNode> &graph, const vector<pair<float, float> > &points, const vector<bool> &pinned);
+
+	/**
+	 * Gets the chains between junctions, which cover every edge of the graph once
+	 * @return the chains
+	 */
+	const vector<lod_chain_t> &getChains() const;
+
+	/**
+	 * Gets the vertices of all the chains
+	 * @return the indexes of the vertices of the chains, chain after chain (see lod_chain_t::first)
+	 */
+	const vector<int> &getChainVertices() const;
+
+	/**
+	 * Simplifies the graph for a scale
+	 * @param scale pixels of the screen per pixel of the map
+	 * @return the simplified graph
+	 */
+	lod_level_t getLevel(float scale) const;
+};
+
+#endif /* LEVELOFDETAIL_H_ */
@@ -6,6 +6,7 @@
 #include <functional>
 #include <set>
 #include <unordered_set>
+#include <chrono>
 
 #include "Program.h"
 #include "Exceptions.h"
@@ -14,23 +15,142 @@
 #ifdef __linux__
 #include <curses.h>
 #include <signal.h>
+#include <unistd.h>
 #else
 #include <conio.h>
+#include <direct.h>
 #endif
 
 #define DEFAULT_PURCHASES 15
-
-Program::Program(char** files): avgVelocity(30), running(true), lastEdgeID(-1), lastNodeID(-1), deliveryTime(2)
+#define APPROX_MAX_EDITS 3			//largest edit distance of the names shown by an approximate search
+#define FUEL_COST_PER_KM 15			//cost of fuel and maintenance of a truck (in cents per Km)
+#define DRIVER_COST_PER_HOUR 1000	//cost of a driver (in cents per hour)
+#define TOLL_PER_KM 10				//toll charged on motorways (in cents per Km)
+#define AUTOCOMPLETE_RESULTS 10		//amount of completions shown for a prefix
+#define MARKET_BONUS 100			//popularity added to markets and to the roads adjacent to a market, for autocompletion
+#define RENDER_DEFAULT_ZOOM 3		//largest zoom level of the tiles drawn by batch jobs, if not given
+#define RENDER_MAX_ZOOM 10			//largest zoom level allowed in batch jobs
+#define TREE_CACHE_MAX_MB 65536		//largest memory for the shortest path trees allowed in batch jobs (in MB)
+
+const char* metricKeys[] = { "distance", "time", "cost" };	//names of the metrics in batch jobs (same order as metric_t)
+const char* projectionKeys[] = { "equirectangular", "mercator" };	//names of the projections in batch jobs (same order as projection_t)
+
+Program::Program(char** files, bool useViewer): view(NULL), core(NULL), turns(NULL), avgVelocity(30), running(true),
+								deliveryTime(2), departureTime(9 * 60), timeDependent(true), metric(DISTANCE),
+								renderZoom(RENDER_DEFAULT_ZOOM)
 {
 	loadGraph(files[1], files[2], files[3]);
+	labelsFile = string(files[1]) + ".";
+	core = new CoreGraph(graph);
+	customizeWeights();
 	loadMarkets(files[4]);
 	loadMap(files[5]);
-	this->gv = new GraphViewer(xRes, yRes, false);
-	while(!gv->setBackground(mapName));
-	while(!gv->createWindow(xRes, yRes));
+	if (useViewer)
+		this->view = new ViewSession(xRes, yRes, mapName);
 	generatePurchases(DEFAULT_PURCHASES);
 }
 
+Program::~Program()
+{
+	delete core;
+	delete turns;
+}
+
+Graph<RoadNode> &Program::getGraph()
+{
+	return graph;
+}
+
+const vector<RoadNode> &Program::getMarkets() const
+{
+	return markets;
+}
+
+const vector<Purchase> &Program::getPurchases() const
+{
+	return purchases;
+}
+
+shared_ptr<const sp_tree_t> Program::getTree(const RoadNode &source)
+{
+	Vertex<RoadNode>* v = graph.getVertex(source);
+	if (v == NULL)
+		return shared_ptr<const sp_tree_t>();
+	if (turns != NULL)
+		return trees.get(*turns, v);
+	if (!isTimeDependent())
+		return trees.get(*core, v);
+
+	function<double(const Edge<RoadNode> &, double)> travel = [this](const Edge<RoadNode> &e, double departure)
+	{
+		return getTravelTime(e, departure);
+	};
+	function<double(const Edge<RoadNode> &, double)> weight = [this](const Edge<RoadNode> &e, double seconds)
+	{
+		return (metric == TIME ? seconds : getCost(e, seconds));
+	};
+	return trees.get(v, [&]() { return graph.timeDependentShortestPathTree(source, departureTime * 60.0, travel, weight); });
+}
+
+bool Program::isTimeDependent() const
+{
+	return timeDependent && metric != DISTANCE && turns == NULL;
+}
+
+TreeCache &Program::getTreeCache()
+{
+	return trees;
+}
+
+bool Program::loadTurns(const string &file)
+{
+	if (turns == NULL)
+		turns = new TurnGraph(graph);
+	bool loaded = false;
+	try
+	{
+		loaded = turns->load(file);
+	}
+	catch (FileNotFound* ex)
+	{
+		cout << "Turn file " << ex->filename << " not found\n";
+		delete ex;
+	}
+	if (!loaded)
+	{
+		delete turns;
+		turns = NULL;
+	}
+	customizeWeights();
+	return loaded;
+}
+
+bool Program::prepareHubLabels()
+{
+	if (turns != NULL || isTimeDependent())
+		return false;
+	if (!labels.empty())
+		return true;
+	string file = labelsFile + metricKeys[metric] + ".labels";
+	if (labels.load(file, graph))
+		return true;
+	if (!labels.build(graph))
+		return false;
+	if (!labels.save(file))
+		cout << "Could not write the hub labels to " << file << endl;
+	return true;
+}
+
+const HubLabels &Program::getHubLabels() const
+{
+	return labels;
+}
+
+const CoreGraph &Program::getCoreGraph() const
+{
+	return *core;
+}
+
 void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 {
 	ifstream nodes(nodesFile);
@@ -60,6 +180,7 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 	}
 
 	set <string> roadSet;
+	unordered_map<long long, int> roadPosition;		//position of each road in Program::r, by id
 
 	while (getline(roadInfo, s))
 	{
@@ -70,11 +191,15 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 		ss >> road.id >> marker;
 		getline(ss, aux, ';');
 		if (aux == "")
+		{
 			road.name = "Undefined street name";
+			road.roadClass = LOCAL;
+		}
 		else
 		{
 			trim(aux);
 			road.name = aux;
+			road.roadClass = classifyRoad(aux);
 			roadSet.insert(aux);
 		}
 		ss >> marker >> aux;
@@ -82,6 +207,8 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 			road.twoWay = false;
 		else
 			road.twoWay = true;
+		if (roadPosition.count(road.id) == 0)
+			roadPosition[road.id] = r.size();
 		r.push_back(road);
 	}
 
@@ -92,6 +219,8 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 		roadNames.push_back(*it);
 	}
 
+	graph.setSpeedProfiles(getDefaultSpeedProfiles());
+
 	while (getline(roads, s))
 	{
 		long long id, v1, v2;
@@ -99,22 +228,18 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 		istringstream ss(s);
 		ss >> id >> marker >> v1 >> marker >> v2;
 		road_t road;
-		for (int i = 0; i < r.size(); i++)
-		{
-			if (r.at(i).id == id)
-			{
-				road = r.at(i);
-				break;
-			}
-		}
+		unordered_map<long long, int>::iterator roadIt = roadPosition.find(id);
+		if (roadIt != roadPosition.end())
+			road = r.at(roadIt->second);
 
 		RoadNode aux1(v1, 0, 0, 0, 0), aux2(v2, 0, 0, 0, 0);
 		RoadNode n1 = graph.getVertex(aux1)->getInfo();
 		RoadNode n2 = graph.getVertex(aux2)->getInfo();
 		float edgeDistance = n1.getDistanceBetween(n2);
-		graph.addEdge(aux1, aux2, edgeDistance, id);
+		roadSegments[road.name]++;
+		graph.addEdge(aux1, aux2, edgeDistance, id, road.roadClass);
 		if (road.twoWay)
-			graph.addEdge(aux2, aux1, edgeDistance, id);
+			graph.addEdge(aux2, aux1, edgeDistance, id, road.roadClass);
 	}
 	nodes.close();
 	roadInfo.close();
@@ -123,6 +248,8 @@ void Program::loadGraph(char* nodesFile, char* roadInfoFile, char* roadFile)
 	roadNamesString = "";
 	for (auto s : roadSet)
 		roadNamesString += s + "  ";
+	roadIndex = NGramIndex(roadNames);
+	roadTree = BKTree(roadNames);
 }
 
 void Program::loadMap(char* mapFile)
@@ -132,28 +259,20 @@ void Program::loadMap(char* mapFile)
 		throw new FileNotFound(mapFile);
 
 	string s;
-	istringstream* ss;
 	char comma;
 	getline(map, s);
 	mapName = s;
+	pair<float, float> corners[3];		//top left, bottom left and top right
+	for (int i = 0; i < 3; i++)
+	{
+		getline(map, s);
+		istringstream ss(s);
+		ss >> corners[i].first >> comma >> corners[i].second;
+	}
 	getline(map, s);
-	ss = new istringstream(s);
-	pair<float, float> p1;
-	(*ss) >> p1.first >> comma >> p1.second;
-	origin = p1;
-	getline(map, s);
-	ss = new istringstream(s);
-	pair<float, float> p2;
-	(*ss) >> p2.first >> comma >> p1.second;
-	yMax = p2;
-	getline(map, s);
-	ss = new istringstream(s);
-	pair<float, float> p3;
-	(*ss) >> p3.first >> comma >> p3.second;
-	xMax = p3;
-	getline(map, s);
-	ss = new istringstream(s);
-	(*ss) >> xRes >> yRes;
+	istringstream ss(s);
+	ss >> xRes >> yRes;
+	projection.setViewport(corners[0], corners[2], corners[1], xRes, yRes);
 }
 
 void Program::loadMarkets(char* marketsFile)
@@ -183,18 +302,33 @@ void Program::loadMarkets(char* marketsFile)
 		adjacentRoads[mName] = pair<string, string>(r1, r2);
 		marketNamesString += mName + "  ";
 
-		for (int i = 0; i < graph.getNumVertex(); i++)
+		Vertex<RoadNode>* v = graph.getVertex(RoadNode(marketID, 0, 0, 0, 0));
+		if (v != NULL)
 		{
-			if (graph.getVertexSet().at(i)->getInfo().getID() == marketID)
-			{
-				RoadNode n = graph.getVertexSet().at(i)->getInfo();
-				markets.push_back(n);
-				marketNames.push_back(mName);
-				break;
-			}
+			markets.push_back(v->getInfo());
+			marketNames.push_back(mName);
 		}
 	}
 	mark.close();
+	marketIndex = NGramIndex(marketNames);
+	marketTree = BKTree(marketNames);
+
+	//road names come first in the automaton, followed by market names
+	vector<string> names = roadNames;
+	names.insert(names.end(), marketNames.begin(), marketNames.end());
+	nameMatcher = AhoCorasick(names);
+
+	//roads are ranked by their amount of segments and markets by the segments of their adjacent roads,
+	//with a bonus for markets and for roads adjacent to a market
+	vector<int> popularity;
+	for (int i = 0; i < roadNames.size(); i++)
+		popularity.push_back(roadSegments[roadNames.at(i)] + (roadMarkets[roadNames.at(i)] == "" ? 0 : MARKET_BONUS));
+	for (int i = 0; i < marketNames.size(); i++)
+	{
+		pair<string, string> rd = adjacentRoads[marketNames.at(i)];
+		popularity.push_back(roadSegments[rd.first] + roadSegments[rd.second] + MARKET_BONUS);
+	}
+	nameCompleter = CompletionTrie(names, popularity, AUTOCOMPLETE_RESULTS);
 }
 
 void Program::generatePurchases(int n)
@@ -268,11 +402,12 @@ void Program::run()
 		case 11:
 			searchMenu();
 			break;
+		case 12:
+			changeRoadState();
+			break;
 		case 0:
-#ifdef __linux__
-			close(GraphViewer::port -1);
-			kill(GraphViewer::procId, SIGTERM);
-#endif
+			delete view;
+			view = NULL;
 			running = false;
 			break;
 		default:
@@ -282,6 +417,391 @@ void Program::run()
 	}
 }
 
+bool Program::loadJob(const string &jobFile)
+{
+	ifstream job(jobFile.c_str());
+	if (!job.is_open())
+	{
+		cout << "Job file " << jobFile << " not found\n";
+		return false;
+	}
+
+	vector<RoadNode> jobPurchases, jobMarkets;
+	vector<string> jobMarketNames;
+	int randomPurchases = 0, lineNumber = 0;
+	bool seeded = false;
+	unsigned int seed = 0;
+	string s;
+	while (getline(job, s))
+	{
+		lineNumber++;
+		trim(s);
+		if (s.empty() || s[0] == '#')
+			continue;
+
+		istringstream ss(s);
+		string key, value, name;
+		getline(ss, key, ';');
+		getline(ss, value, ';');
+		getline(ss, name);
+		trim(key);
+		trim(value);
+		trim(name);
+		istringstream vs(value);
+		bool valid = true;
+
+		if (key == "velocity")
+		{
+			float v = 0;
+			valid = (vs >> v) && v >= 5.0 && v <= 80.0;
+			if (valid)
+				avgVelocity = v;
+		}
+		else if (key == "delivery")
+		{
+			int t = 0;
+			valid = (vs >> t) && t >= 1 && t <= 10;
+			if (valid)
+				deliveryTime = t;
+		}
+		else if (key == "departure")
+		{
+			int h = -1, m = -1;
+			char sep;
+			valid = (vs >> h >> sep >> m) && h >= 0 && h <= 23 && m >= 0 && m <= 59;
+			if (valid)
+				departureTime = h * 60 + m;
+		}
+		else if (key == "profiles")
+		{
+			valid = (value == "True" || value == "true" || value == "False" || value == "false");
+			timeDependent = (value == "True" || value == "true");
+		}
+		else if (key == "metric")
+		{
+			valid = false;
+			for (int i = 0; i < NUM_METRICS; i++)
+			{
+				if (value == metricKeys[i])
+				{
+					metric = static_cast<metric_t>(i);
+					valid = true;
+				}
+			}
+		}
+		else if (key == "projection")
+		{
+			valid = false;
+			for (int i = 0; i < NUM_PROJECTIONS; i++)
+			{
+				if (value == projectionKeys[i])
+				{
+					projection.setType(static_cast<projection_t>(i));
+					valid = true;
+				}
+			}
+		}
+		else if (key == "cache")
+		{
+			int mb = 0;
+			valid = (vs >> mb) && mb >= 1 && mb <= TREE_CACHE_MAX_MB;
+			if (valid)
+				trees.setCapacity((size_t)mb << 20);
+		}
+		else if (key == "turns")
+			valid = loadTurns(value);
+		else if (key == "seed")
+		{
+			valid = static_cast<bool>(vs >> seed);
+			seeded = true;
+		}
+		else if (key == "purchases")
+			valid = (vs >> randomPurchases) && randomPurchases > 0;
+		else if (key == "render")
+		{
+			valid = (value != "");
+			renderFile = value;
+		}
+		else if (key == "zoom")
+			valid = (vs >> renderZoom) && renderZoom >= 0 && renderZoom <= RENDER_MAX_ZOOM;
+		else if (key == "purchase" || key == "market")
+		{
+			long long id;
+			Vertex<RoadNode>* v = NULL;
+			if (vs >> id)
+				v = graph.getVertex(RoadNode(id, 0, 0, 0, 0));
+			valid = (v != NULL);
+			if (valid && key == "purchase")
+				jobPurchases.push_back(v->getInfo());
+			else if (valid)
+			{
+				//markets that were loaded keep their name unless the job gives another one
+				int idx = getIndexOfMarket(v->getInfo());
+				if (name == "")
+					name = (idx != -1 ? marketNames.at(idx) : "Market " + value);
+				jobMarkets.push_back(v->getInfo());
+				jobMarketNames.push_back(name);
+			}
+		}
+		else
+			valid = false;
+
+		if (!valid)
+		{
+			cout << "Invalid line " << lineNumber << " of job file " << jobFile << ": " << s << endl;
+			return false;
+		}
+	}
+
+	graph.setMetric(metric);
+	customizeWeights();
+	if (!jobMarkets.empty())
+	{
+		markets = jobMarkets;
+		marketNames = jobMarketNames;
+	}
+	if (seeded)
+		srand(seed);
+	if (!jobPurchases.empty())
+	{
+		purchases.clear();
+		for (int i = 0; i < jobPurchases.size(); i++)
+			purchases.push_back(Purchase(jobPurchases.at(i)));
+	}
+	else if (randomPurchases > 0)
+		generatePurchases(randomPurchases);
+	return true;
+}
+
+bool Program::runBatch(const string &jobFile, const string &outputFile)
+{
+	if (!loadJob(jobFile))
+		return false;
+	ofstream out(outputFile.c_str());
+	if (!out.is_open())
+	{
+		cout << "Could not write to " << outputFile << endl;
+		return false;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	checkValidMarkets();
+	chrono::steady_clock::time_point connected = chrono::steady_clock::now();
+	setClosestMarketToAllClients();
+	chrono::steady_clock::time_point assigned = chrono::steady_clock::now();
+	vector<vector<truck_route_t> > routes(markets.size());
+	int served = 0, numRoutes = 0;
+	for (int i = 0; i < markets.size(); i++)
+	{
+		vector<RoadNode> closest;
+		for (int j = 0; j < purchases.size(); j++)
+		{
+			if (purchases.at(j).getClosestMarketIndex() == i &&
+				purchases.at(j).getClosestMarketDist() != INT_INFINITY)
+				closest.push_back(purchases.at(j).getAddr());
+		}
+		planMarketRoutes(i, closest, routes.at(i), planScratch);
+		for (int j = 0; j < routes.at(i).size(); j++)
+			served += routes.at(i).at(j).served;
+		numRoutes += routes.at(i).size();
+	}
+	chrono::steady_clock::time_point planned = chrono::steady_clock::now();
+
+	vector<double> times;
+	times.push_back(chrono::duration<double, micro>(connected - start).count());
+	times.push_back(chrono::duration<double, micro>(assigned - connected).count());
+	times.push_back(chrono::duration<double, micro>(planned - assigned).count());
+
+	if (outputFile.size() >= 4 && outputFile.substr(outputFile.size() - 4) == ".csv")
+		writeBatchCSV(out, routes);
+	else
+		writeBatchJSON(out, routes, times);
+
+	cout << purchases.size() << " purchases, " << served << " served by " << numRoutes << " routes from ";
+	cout << markets.size() << " markets in " << setprecision(1) << fixed;
+	cout << chrono::duration<double, milli>(planned - start).count() << " ms\n";
+
+	if (renderFile != "")
+	{
+		chrono::steady_clock::time_point renderStart = chrono::steady_clock::now();
+		if (!renderRoutes(renderFile, routes))
+		{
+			cout << "Could not draw the routes on " << renderFile << endl;
+			return false;
+		}
+		cout << "Routes drawn on " << renderFile << " in ";
+		cout << chrono::duration<double, milli>(chrono::steady_clock::now() - renderStart).count() << " ms\n";
+	}
+	return true;
+}
+
+/**
+ * Splits a path into its directories and file name, dropping empty and "." parts
+ */
+static vector<string> splitPath(const string &path)
+{
+	vector<string> parts;
+	string part;
+	for (int i = 0; i <= path.size(); i++)
+	{
+		if (i == path.size() || path[i] == '/' || path[i] == '\\')
+		{
+			if (part != "" && part != ".")
+				parts.push_back(part);
+			part = "";
+		}
+		else
+			part += path[i];
+	}
+	return parts;
+}
+
+/**
+ * Gets the path of a file as seen from the directory of another one, for a link written in the latter (such as
+ * the picture behind an SVG map). If it cannot be told from the paths alone, the absolute path is used
+ * @param path path of the file linked to, absolute or relative to the working directory
+ * @param from path of the file the link is written in, absolute or relative to the working directory
+ * @return the path to write in the link
+ */
+static string linkPath(const string &path, const string &from)
+{
+	bool absolute = (path.size() > 0 && (path[0] == '/' || path[0] == '\\')) || (path.size() > 1 && path[1] == ':');
+	bool fromAbsolute = (from.size() > 0 && (from[0] == '/' || from[0] == '\\')) || (from.size() > 1 && from[1] == ':');
+	if (absolute)
+		return path;
+
+	vector<string> target = splitPath(path), dir = splitPath(from);
+	if (!dir.empty())
+		dir.pop_back();
+	int common = 0;
+	while (common < target.size() && common < dir.size() && target[common] == dir[common] && dir[common] != "..")
+		common++;
+	bool resolved = !fromAbsolute;
+	for (int i = common; i < dir.size(); i++)
+		resolved = resolved && dir[i] != "..";
+	if (!resolved)
+	{
+		char cwd[4096];
+#ifdef __linux__
+		char* res = getcwd(cwd, sizeof(cwd));
+#else
+		char* res = _getcwd(cwd, sizeof(cwd));
+#endif
+		return (res == NULL ? path : string(cwd) + "/" + path);
+	}
+
+	string link;
+	for (int i = common; i < dir.size(); i++)
+		link += "../";
+	for (int i = common; i < target.size(); i++)
+		link += target[i] + (i + 1 < target.size() ? "/" : "");
+	return link;
+}
+
+bool Program::renderRoutes(const string &file, const vector<vector<truck_route_t> > &routes)
+{
+	const vector<pair<float, float> > &points = projection.getPoints(graph);
+
+	//each market has its own route color
+	Renderer renderer(graph, points, xRes, yRes);
+	for (int i = 0; i < routes.size(); i++)
+		for (int j = 0; j < routes.at(i).size(); j++)
+			renderer.addRoute(routes.at(i).at(j).path, RENDER_ROUTE + i % (NUM_RENDER_COLORS - RENDER_ROUTE));
+	for (int i = 0; i < purchases.size(); i++)
+		renderer.addMarker(purchases.at(i).getAddr(), RENDER_CLIENT, "");
+	for (int i = 0; i < markets.size(); i++)
+		renderer.addMarker(markets.at(i), RENDER_MARKET, marketNames.at(i));
+
+	if (file.size() >= 4 && file.substr(file.size() - 4) == ".svg")
+		return renderer.writeSVG(file, linkPath(mapName, file));
+	return renderer.writeTiles(file, renderZoom, 0) != -1;
+}
+
+/**
+ * Quotes a string for CSV (doubling its quotes) or JSON (see escapeJSON)
+ * @param s the string
+ * @param csv true for CSV, false for JSON
+ * @return the quoted string
+ */
+static string quote(const string &s, bool csv)
+{
+	if (!csv)
+		return "\"" + escapeJSON(s) + "\"";
+	string res = "\"";
+	for (int i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '"')
+			res += '"';
+		res += s[i];
+	}
+	return res + "\"";
+}
+
+void Program::writeBatchJSON(ostream &out, const vector<vector<truck_route_t> > &routes, const vector<double> &times)
+{
+	out << "{\n";
+	out << "  \"parameters\": {\"velocity\": " << avgVelocity << ", \"delivery_time\": " << deliveryTime;
+	out << ", \"departure\": \"" << setfill('0') << setw(2) << departureTime / 60 << ":" << setw(2) << departureTime % 60;
+	out << setfill(' ') << "\", \"speed_profiles\": " << (timeDependent ? "true" : "false");
+	out << ", \"metric\": \"" << metricKeys[metric] << "\"},\n";
+	out << fixed << setprecision(1);
+	out << "  \"timing_us\": {\"connectivity\": " << times.at(0) << ", \"assignment\": " << times.at(1);
+	out << ", \"planning\": " << times.at(2) << "},\n";
+
+	//markets are identified by their node, and "weight" is the distance to the closest market in the routing metric
+	out << "  \"purchases\": [\n";
+	for (int i = 0; i < purchases.size(); i++)
+	{
+		const Purchase &p = purchases.at(i);
+		vector<RoadNode> valid = p.getValidMarkets();
+		out << "    {\"node\": " << p.getAddr().getID() << ", \"valid_markets\": [";
+		for (int j = 0; j < valid.size(); j++)
+			out << (j == 0 ? "" : ", ") << valid.at(j).getID();
+		out << "], \"market\": ";
+		if (p.getClosestMarketIndex() == -1 || p.getClosestMarketDist() == INT_INFINITY)
+			out << "null, \"weight\": null}";
+		else
+			out << markets.at(p.getClosestMarketIndex()).getID() << ", \"weight\": " << p.getClosestMarketDist() << "}";
+		out << (i + 1 < purchases.size() ? ",\n" : "\n");
+	}
+	out << "  ],\n";
+
+	out << "  \"markets\": [\n";
+	for (int i = 0; i < markets.size(); i++)
+	{
+		out << "    {\"node\": " << markets.at(i).getID() << ", \"name\": " << quote(marketNames.at(i), false) << ", \"routes\": [";
+		for (int j = 0; j < routes.at(i).size(); j++)
+		{
+			const truck_route_t &route = routes.at(i).at(j);
+			out << (j == 0 ? "\n" : ",\n") << "      {\"clients\": " << route.served << ", \"length_m\": " << route.length;
+			out << ", \"time_min\": " << route.time << ", \"path\": [";
+			for (int k = 0; k < route.path.size(); k++)
+				out << (k == 0 ? "" : ", ") << route.path.at(k).getID();
+			out << "]}";
+		}
+		out << (routes.at(i).empty() ? "]}" : "\n    ]}") << (i + 1 < markets.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+void Program::writeBatchCSV(ostream &out, const vector<vector<truck_route_t> > &routes)
+{
+	out << "market,market_name,route,clients,length_m,time_min,path\n";
+	for (int i = 0; i < routes.size(); i++)
+	{
+		for (int j = 0; j < routes.at(i).size(); j++)
+		{
+			const truck_route_t &route = routes.at(i).at(j);
+			out << markets.at(i).getID() << "," << quote(marketNames.at(i), true) << "," << j + 1 << ",";
+			out << route.served << "," << route.length << "," << route.time << ",";
+			for (int k = 0; k < route.path.size(); k++)
+				out << (k == 0 ? "" : " ") << route.path.at(k).getID();
+			out << "\n";
+		}
+	}
+}
+
 void Program::displayMenu()
 {
 	cout << endl;
@@ -296,63 +816,61 @@ void Program::displayMenu()
 	cout << "9.  Distribute from all markets to all clients\n";
 	cout << "10. Change delivery parameters\n";
 	cout << "11. Search roads/markets\n";
+	cout << "12. Close, reopen or slow down a road\n";
 	cout << "0.  Quit program\n";
 	cout << endl;
 }
 
-void Program::displayGraph(Graph<RoadNode> g)
+void Program::displayGraph(Graph<RoadNode> &g)
 {
-	resetGV();
-	while(!gv->defineVertexColor("blue"));
-	while(!gv->defineEdgeColor("black"));
-	while(!gv->defineEdgeCurved(false));
+	if (view == NULL)
+		return;
+	//the roads are simplified for the size of the window, with the markets and the purchases pinned,
+	//and the id of each node on GraphViewer is the index of one of its vertices
+	const vector<Vertex<RoadNode>* > &vs = g.getVertexSet();
+	const vector<pair<float, float> > &points = projection.getPoints(g);
+	vector<bool> pinned(vs.size(), false);
+	for (int i = 0; i < markets.size(); i++)
+		pinned.at(g.getVertex(markets.at(i))->getIndex()) = true;
+	for (int i = 0; i < purchases.size(); i++)
+		pinned.at(g.getVertex(purchases.at(i).getAddr())->getIndex()) = true;
+	lod_level_t level = LevelOfDetail(g, points, pinned).getLevel(1);
 
-	vector<pair<int, long long> > processed;
-	for (int i = 0; i < g.getVertexSet().size(); i++)
+	view->clear();
+	for (int i = 0; i < level.nodes.size(); i++)
 	{
-		pair<int, int> coord = mapCoordToXY(g.getVertexSet().at(i)->getInfo());
-		while(!gv->addNode(i, coord.first, coord.second));
-		while(!gv->setVertexSize(i, 5));
-		if (getIndexOfMarket(g.getVertexSet().at(i)->getInfo()) != -1)
-		{
-			while(!gv->setVertexColor(i, RED));
-			while(!gv->setVertexLabel(i, getMarketName(g.getVertexSet().at(i)->getInfo())));
-		}
-		processed.push_back(pair<int, long long>(i, g.getVertexSet().at(i)->getInfo().getID()));
+		const lod_node_t &n = level.nodes.at(i);
+		if (n.pinned && getIndexOfMarket(vs.at(n.vertex)->getInfo()) != -1)
+			view->addNode(n.vertex, n.x, n.y, RED, getMarketName(vs.at(n.vertex)->getInfo()));
+		else
+			view->addNode(n.vertex, n.x, n.y);
 	}
-	lastNodeID = g.getVertexSet().size() - 1;
-
-	int edgeID = 0;
-	for (int i = 0; i < g.getVertexSet().size(); i++)
+	for (int i = 0; i < level.edges.size(); i++)
 	{
-		Vertex<RoadNode>* n = g.getVertexSet().at(i);
-		for (int j = 0; j < n->getAdj().size(); j++)
-		{
-			int id1, id2;
-			for (int k = 0; k < processed.size(); k++)
-			{
-				if (processed.at(k).second == n->getInfo().getID())
-					id1 = processed.at(k).first;
-				if (processed.at(k).second == n->getAdj().at(j).getDest()->getInfo().getID())
-					id2 = processed.at(k).first;
-			}
-			while(!gv->addEdge(edgeID, id1, id2, EdgeType::DIRECTED));
-			while(!gv->setEdgeWeight(edgeID, n->getAdj().at(j).getWeight()));
-			edgeID++;
-		}
+		const lod_edge_t &e = level.edges.at(i);
+		int from = level.nodes.at(e.from).vertex, to = level.nodes.at(e.to).vertex;
+		if (e.forward || !e.backward)
+			view->addEdge(from, to, e.weight);
+		if (e.backward)
+			view->addEdge(to, from, e.weight);
 	}
-	lastEdgeID = --edgeID;
-	while(!gv->rearrange());
-
+	if (!view->show())
+		cout << "Some nodes or edges could not be displayed\n";
 }
 
-void Program::displayGraphStatistics(Graph<RoadNode> g)
+void Program::displayGraphStatistics(Graph<RoadNode> &g)
 {
 	cout << "\nGraph statistics: " << g.getNumVertex() << " nodes and ";
 	int nEdges = 0;
 	for (int i = 0; i < g.getVertexSet().size(); i++)
 		nEdges += g.getVertexSet().at(i)->getAdj().size();
 	cout << nEdges << " edges\n";
+	cout << "Routing core: " << core->getNumVertex() << " nodes and " << core->getNumEdges() << " edges\n";
+	if (turns != NULL)
+		cout << "Turn rules: " << turns->getNumRules() << ", with " << turns->getNumStates() << " turn states\n";
+	cout << "Shortest path trees cached: " << trees.getNumTrees() << " (" << trees.getUsedBytes() / 1024 << " of " <<
+			trees.getCapacity() / 1024 << " KB), " << trees.getHits() << " hits, " << trees.getMisses() << " misses, " <<
+			trees.getEvictions() << " evicted\n";
 }
 
 void Program::displayMarketsInfo()
@@ -391,14 +909,20 @@ void Program::singleMarketSingleClient()
 	marketIdx--;
 	try
 	{
-		int length = graph.dijkstraShortestPath(markets.at(marketIdx), purchases.at(clientIdx).getAddr());
-		vector<Vertex<RoadNode>* > path = graph.getPathVertex(markets.at(marketIdx), purchases.at(clientIdx).getAddr());
-		cout << getMarketName(path.at(0)->getInfo()) << endl;
+		shared_ptr<const sp_tree_t> tree = getTree(markets.at(marketIdx));
+		int client = graph.getVertex(purchases.at(clientIdx).getAddr())->getIndex();
+		cout << getMarketName(marketIdx) << endl;
 
-		if (length == INT_INFINITY)
+		if (tree->dist.at(client) >= INT_INFINITY)
 			cout << "There is no connection between the market and the client\n";
 		else
 		{
+			int weight = static_cast<int>(tree->dist.at(client) + 0.5);
+			vector<int> indexes;
+			graph.getTreePath(*tree, client, indexes);
+			vector<Vertex<RoadNode>* > path;
+			for (int i = 0; i < indexes.size(); i++)
+				path.push_back(graph.getVertexSet().at(indexes.at(i)));
 			try
 			{
 				displaySubGraph(path);
@@ -407,9 +931,15 @@ void Program::singleMarketSingleClient()
 			{
 				cout << "Problem displaying graph\n";
 			}
+			vector<RoadNode> pathInfo;
+			for (int i = 0; i < path.size(); i++)
+				pathInfo.push_back(path.at(i)->getInfo());
+			int length = graph.getPathLength(pathInfo);
+			if (metric != DISTANCE)
+				cout << "Path optimised for " << getMetricName(metric) << ": " << weight << endl;
 			cout << "Shortest path from market "<< marketIdx + 1 << " (" << getMarketName(marketIdx) <<
 					") is " << length << " meters (" << setprecision(2) << length / 1000.0 <<
-					" Km), estimated time is " << calculateTime(length, 1) << " min\n";
+					" Km), estimated time is " << calculateTime(pathInfo, length, 1) << " min\n";
 		}
 	}
 	catch (out_of_range &ex)
@@ -419,36 +949,39 @@ void Program::singleMarketSingleClient()
 	return;
 }
 
-void Program::addMarketToPurchase(RoadNode market, RoadNode purchaseAddr)
+void Program::dfsConnectivity(Vertex<RoadNode>* v)
 {
-	for (int i = 0; i < purchases.size(); i++)
+	vector<Vertex<RoadNode>* > stack(1, v);
+	v->setVisited(true);
+	while (!stack.empty())
 	{
-		if (purchases.at(i).getAddr() == purchaseAddr)
+		Vertex<RoadNode>* u = stack.back();
+		stack.pop_back();
+		const ArenaArray<Edge<RoadNode> > &adj = u->getAdj();
+		for (int i = 0; i < adj.size(); i++)
 		{
-			purchases.at(i).addValidMarket(market);
-			break;
+			if (!adj.at(i).getDest()->getVisited() && !graph.isEdgeClosed(adj.at(i).getIndex()))
+			{
+				adj.at(i).getDest()->setVisited(true);
+				stack.push_back(adj.at(i).getDest());
+			}
 		}
 	}
 }
 
-void Program::dfsConnectivity(Vertex<RoadNode>* v, RoadNode market)
-{
-	v->setVisited(true);
-	addMarketToPurchase(market, v->getInfo());
-
-	for (int i = 0; i < v->getAdj().size(); i++)
-	{
-		if (!v->getAdj().at(i).getDest()->getVisited())
-			dfsConnectivity(v->getAdj().at(i).getDest(), market);
-	}
-}
-
 void Program::checkValidMarkets()
 {
+	for (int i = 0; i < purchases.size(); i++)
+		purchases.at(i).clearValidMarkets();
 	for (int i = 0; i < markets.size(); i++)
 	{
 		graph.resetVisited();
-		dfsConnectivity(graph.getVertex(markets.at(i)), markets.at(i));
+		dfsConnectivity(graph.getVertex(markets.at(i)));
+		for (int j = 0; j < purchases.size(); j++)
+		{
+			if (graph.getVertex(purchases.at(j).getAddr())->getVisited())
+				purchases.at(j).addValidMarket(markets.at(i));
+		}
 	}
 	graph.resetVisited();
 }
@@ -503,10 +1036,13 @@ void Program::allMarketsSingleClient()
 		}
 		for (int i = 0; i < purchases.at(clientIdx).getValidMarkets().size(); i++)
 		{
-			int length = graph.dijkstraShortestPath(purchases.at(clientIdx).getValidMarkets().at(i),
-													purchases.at(clientIdx).getAddr());
-			cout << "Shortest path from market "<< i + 1 << " (" << getMarketName(i) << ") is " << length << " meters (" <<
-					setprecision(2) << length / 1000.0 << " Km), estimated time is " << calculateTime(length, 1) << " min\n";
+			int marketIdx = getIndexOfMarket(purchases.at(clientIdx).getValidMarkets().at(i));
+			shared_ptr<const sp_tree_t> tree = getTree(markets.at(marketIdx));
+			vector<RoadNode> path = graph.getTreePath(*tree, purchases.at(clientIdx).getAddr());
+			int length = graph.getPathLength(path);
+			cout << "Shortest path from market "<< marketIdx + 1 << " (" << getMarketName(marketIdx) << ") is " << length <<
+					" meters (" << setprecision(2) << length / 1000.0 << " Km), estimated time is " <<
+					calculateTime(path, length, 1) << " min\n";
 		}
 	}
 	catch (out_of_range &ex)
@@ -517,13 +1053,89 @@ void Program::allMarketsSingleClient()
 	return;
 }
 
-int Program::calculateTime(int length, int numberOfClients)
+int Program::calculateTime(int length, int numberOfClients, double extraTime)
 {
 	float v = avgVelocity / 3.6;
-	float t = length / v;
+	float t = length / v + extraTime;
 	return static_cast<int>(t / 60 + deliveryTime * numberOfClients);
 }
 
+double Program::getTravelTime(const Edge<RoadNode> &e, double departure) const
+{
+	float v = avgVelocity / 3.6;
+	double res = e.getWeight() / v;
+	if (timeDependent && e.getProfile() >= 0)
+		res = graph.getSpeedProfiles().at(e.getProfile()).getTravelTime(e.getWeight(), departure);
+	return res * slowdown.at(e.getIndex());
+}
+
+double Program::getCost(const Edge<RoadNode> &e, double seconds) const
+{
+	double km = e.getWeight() / 1000;
+	double res = km * FUEL_COST_PER_KM;
+	if (e.getProfile() == MOTORWAY)
+		res += km * TOLL_PER_KM;
+	return res * slowdown.at(e.getIndex()) + seconds / 3600 * DRIVER_COST_PER_HOUR;
+}
+
+double Program::getWeight(const Edge<RoadNode> &e, metric_t m) const
+{
+	double departure = departureTime * 60.0;
+	switch (m)
+	{
+	case TIME:
+		return getTravelTime(e, departure);
+	case COST:
+		return getCost(e, getTravelTime(e, departure));
+	default:
+		return e.getWeight() * slowdown.at(e.getIndex());
+	}
+}
+
+void Program::customizeWeights()
+{
+	slowdown.resize(graph.getNumEdges(), 1);
+	for (int m = 0; m < NUM_METRICS; m++)
+	{
+		function<double(const Edge<RoadNode> &)> weight = [&](const Edge<RoadNode> &e)
+		{
+			return getWeight(e, (metric_t)m);
+		};
+		graph.customizeMetric((metric_t)m, weight);
+	}
+	core->customize();
+	if (turns != NULL)
+		turns->customize(metric == TIME ? 1 : (metric == COST ? DRIVER_COST_PER_HOUR / 3600.0 : 0));
+	trees.clear();
+	labels.clear();
+}
+
+string Program::getMetricName(metric_t m)
+{
+	switch (m)
+	{
+	case TIME:
+		return "time (s)";
+	case COST:
+		return "cost (cents)";
+	default:
+		return "distance (m)";
+	}
+}
+
+int Program::calculateTime(const vector<RoadNode> &path, int length, int numberOfClients)
+{
+	double turnTime = (turns == NULL ? 0 : turns->getPathTurnTime(path));
+	function<double(const Edge<RoadNode> &, double)> travel = [this](const Edge<RoadNode> &e, double departure)
+	{
+		return getTravelTime(e, departure);
+	};
+	double t = graph.getPathTravelTime(path, departureTime * 60.0, travel);
+	if (t >= INT_INFINITY)
+		return calculateTime(length, numberOfClients, turnTime);
+	return static_cast<int>((t + turnTime) / 60 + deliveryTime * numberOfClients);
+}
+
 string Program::getMarketName(RoadNode n)
 {
 	for (int i = 0; i < markets.size(); i++)
@@ -535,52 +1147,133 @@ string Program::getMarketName(RoadNode n)
 
 void Program::displaySubGraph(vector<Vertex<RoadNode>* > path)
 {
-	resetGV();
-	while(!gv->defineVertexColor("blue"));
-	while(!gv->defineEdgeColor("black"));
-	while(!gv->defineEdgeCurved(false));
-
-	pair<int, int> coord = mapCoordToXY(path.at(0)->getInfo());
-	while(!gv->addNode(0, coord.first, coord.second));
-	while(!gv->setVertexLabel(0, getMarketName(path.at(0)->getInfo())));
-	while(!gv->setVertexColor(0, RED));
-	while(!gv->setVertexSize(0, 5));
-
-	for (int i = 1; i < path.size() - 1; i++)
-	{
-		coord = mapCoordToXY(path.at(i)->getInfo());
-		while(!gv->addNode(i, coord.first, coord.second));
-		while(!gv->setVertexSize(i, 5));
-		while(!gv->addEdge(i - 1, i - 1, i, EdgeType::DIRECTED));
-		while(!gv->setEdgeWeight(i, path.at(i - 1)->getInfo().getDistanceBetween(path.at(i)->getInfo())));
-	}
-	coord = mapCoordToXY(path.at(path.size() - 1)->getInfo());
-	while(!gv->addNode(path.size() - 1, coord.first, coord.second));
-	while(!gv->setVertexLabel(path.size() - 1, "Destination"));
-	while(!gv->setVertexColor(path.size() - 1, GREEN));
-	while(!gv->setVertexSize(path.size() - 1, 5));
-	while(!gv->addEdge(path.size() - 2, path.size() - 2, path.size() - 1, EdgeType::DIRECTED));
-	while(!gv->setEdgeWeight(path.size() - 1,
-			path.at(path.size() - 2)->getInfo().getDistanceBetween(path.at(path.size() - 1)->getInfo())));
-	while(!gv->rearrange());
-	lastEdgeID = path.size() - 2;
-	lastNodeID = path.size() - 1;
+	if (view == NULL)
+		return;
+	const vector<pair<float, float> > &points = projection.getPoints(graph);
+	view->clear();
+	for (int i = 0; i < path.size(); i++)
+	{
+		const pair<float, float> &coord = points.at(path.at(i)->getIndex());
+		if (i == 0)
+			view->addNode(path.at(i)->getIndex(), coord.first, coord.second, RED, getMarketName(path.at(i)->getInfo()));
+		else if (i == path.size() - 1)
+			view->addNode(path.at(i)->getIndex(), coord.first, coord.second, GREEN, "Destination");
+		else
+			view->addNode(path.at(i)->getIndex(), coord.first, coord.second);
+		if (i > 0)
+			view->addEdge(path.at(i - 1)->getIndex(), path.at(i)->getIndex(),
+					path.at(i - 1)->getInfo().getDistanceBetween(path.at(i)->getInfo()));
+	}
+	if (!view->show())
+		cout << "Some nodes or edges could not be displayed\n";
 }
 
 void Program::setClosestMarketToAllClients()
 {
+	//assignments made before are dropped, since the metric or the weights may have changed since then
+	for (int j = 0; j < purchases.size(); j++)
+		purchases.at(j).clearClosestMarket();
 	for (int i = 0; i < markets.size(); i++)
 	{
-		graph.dijkstraShortestPath(markets.at(i));
+		shared_ptr<const sp_tree_t> tree = getTree(markets.at(i));
 		for (int j = 0; j < purchases.size(); j++)
 		{
-			int dist = graph.getVertex(purchases.at(j).getAddr())->getDist();
+			double dist = tree->dist.at(graph.getVertex(purchases.at(j).getAddr())->getIndex());
 			if (dist > 0 && dist < INT_INFINITY)
-				purchases.at(j).setClosestMarketIndex(i, dist);
+				purchases.at(j).setClosestMarketIndex(i, static_cast<int>(dist + 0.5));
 		}
 	}
 }
 
+void Program::updateMarketTrees()
+{
+	for (int i = 0; i < markets.size(); i++)
+		getTree(markets.at(i));
+}
+
+void Program::changeRoadState()
+{
+	cout << "Name of the road: ";
+	string name;
+	cin.ignore();
+	getline(cin, name);
+	trim(name);
+
+	set<long long> ids;
+	for (int i = 0; i < r.size(); i++)
+	{
+		if (r.at(i).name == name)
+			ids.insert(r.at(i).id);
+	}
+	if (ids.empty())
+	{
+		cout << "No road with that name was found\n";
+		return;
+	}
+
+	cout << "1. Close the road\n";
+	cout << "2. Reopen the road\n";
+	cout << "3. Multiply the weights of the road by a factor\n";
+	cout << "Option: ";
+	int choice;
+	cin >> choice;
+	double factor = 1;
+	if (choice == 3)
+	{
+		cout << "Factor (between 0.1 and 10): ";
+		cin >> factor;
+		if (factor < 0.1 || factor > 10)
+		{
+			cout << "Invalid factor, no changes were made\n";
+			return;
+		}
+	}
+	else if (choice != 1 && choice != 2)
+	{
+		cout << "Invalid choice\n";
+		return;
+	}
+
+	vector<edge_update_t> updates;
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	for (int i = 0; i < vs.size(); i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			if (ids.find(adj.at(j).getID()) == ids.end())
+				continue;
+			edge_update_t u;
+			u.edge = adj.at(j).getIndex();
+			if (choice == 3)
+			{
+				//the factor is kept, so that the weights of the other metrics get it when they are customised,
+				//and a closed edge only gets it when it is reopened
+				slowdown.at(u.edge) *= factor;
+				if (graph.isEdgeClosed(u.edge))
+					continue;
+			}
+			//reopened and slowed down edges get the weight they would get from Program::customizeWeights
+			u.weight = (choice == 1 ? INT_INFINITY : getWeight(adj.at(j), metric));
+			updates.push_back(u);
+		}
+	}
+
+	//trees with turn states or time-dependent weights cannot be repaired, so they are computed again when asked for
+	vector<int> changed = graph.updateEdges(updates);
+	core->customize();
+	int recomputed = 0;
+	if (turns != NULL || isTimeDependent())
+		trees.clear();
+	else
+		recomputed = trees.repair(graph, changed);
+	labels.clear();
+	checkValidMarkets();
+	setClosestMarketToAllClients();
+	cout << changed.size() << " edges updated, " << recomputed << " vertexes recomputed in the " << trees.getNumTrees() <<
+			" shortest path trees cached\n";
+}
+
 void Program::displayClosestMarketsToClients()
 {
 	cout << endl;
@@ -599,58 +1292,122 @@ void Program::displayClosestMarketsToClients()
 	}
 }
 
-vector<RoadNode> Program::getTruckPath(RoadNode market, vector<RoadNode> &clients, int &distance)
+void Program::getTruckPath(const sp_tree_t &tree, vector<RoadNode> &clients, int &distance, vector<RoadNode> &path,
+		plan_scratch_t &scratch)
 {
 	//First part: get client node that is farther away from the market
-	Vertex<RoadNode>* farthestVertex;
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
 	int maxIndex = -1;
-	distance = 0;
+	double farthestDist = 0;
+	scratch.clientVertices.resize(clients.size());
 	for (int i = 0; i < clients.size(); i++)
 	{
-		Vertex<RoadNode>* v = graph.getVertex(clients.at(i));
-		if (v->getDist() > distance)
+		int v = graph.getVertex(clients.at(i))->getIndex();
+		scratch.clientVertices.at(i) = v;
+		if (tree.dist.at(v) > farthestDist)
 		{
-			distance = v->getDist();
-			farthestVertex = v;
+			farthestDist = tree.dist.at(v);
 			maxIndex = i;
 		}
 	}
-
-	vector<RoadNode>* aux = new vector<RoadNode>();	//apparently vector.erase() does not work,
-	for (int i = 0; i < clients.size(); i++)		//have to delete the element like this
+	path.clear();
+	if (maxIndex == -1)
+	{
+		//all clients are at the market itself
+		distance = 0;
+		clients.clear();
+		path.push_back(vs.at(tree.source)->getInfo());
+		return;
+	}
+	if (farthestDist >= INT_INFINITY)
 	{
-		if (i != maxIndex)
-			aux->push_back(clients.at(i));
+		distance = INT_INFINITY;
+		clients.erase(clients.begin() + maxIndex);
+		return;
 	}
-	clients.clear();
-	for (int i = 0; i < aux->size(); i++)
-		clients.push_back(aux->at(i));
-	delete aux;
+	distance = static_cast<int>(farthestDist + 0.5);
 
-	//Second part: get the path from the previous vertex to the market, and if it
-	//goes through a client, remove that client from the client vector
+	//Second part: get the path from the market to that client, marking its vertices (but the market),
+	//and remove the clients on marked vertices from the client vector, keeping the order of the others
+	graph.getTreePath(tree, scratch.clientVertices.at(maxIndex), scratch.pathVertices);
+	if (scratch.stamps.size() != vs.size())
+	{
+		scratch.stamps.assign(vs.size(), 0);
+		scratch.stamp = 0;
+	}
+	scratch.stamp++;
+	for (int i = 0; i < scratch.pathVertices.size(); i++)
+	{
+		path.push_back(vs.at(scratch.pathVertices.at(i))->getInfo());
+		if (i > 0)
+			scratch.stamps.at(scratch.pathVertices.at(i)) = scratch.stamp;
+	}
+	int kept = 0;
+	for (int i = 0; i < clients.size(); i++)
+	{
+		if (scratch.stamps.at(scratch.clientVertices.at(i)) != scratch.stamp)
+			clients.at(kept++) = clients.at(i);
+	}
+	clients.erase(clients.begin() + kept, clients.end());
+	if (metric != DISTANCE)
+		distance = graph.getPathLength(path);
+}
 
-	list<Vertex<RoadNode>* > buffer;
-	buffer.push_front(farthestVertex);
-	RoadNode n = farthestVertex->getInfo();
+void Program::planMarketRoutes(int marketIdx, const vector<RoadNode> &clients, vector<truck_route_t> &routes,
+		plan_scratch_t &scratch)
+{
+	//the routes given are set aside, so the memory of their paths is reused by the new ones
+	while (!routes.empty())
+	{
+		scratch.routes.push_back(move(routes.back()));
+		routes.pop_back();
+	}
+	shared_ptr<const sp_tree_t> tree = getTree(markets.at(marketIdx));
+	scratch.clients.assign(clients.begin(), clients.end());
+	while (!scratch.clients.empty())
+	{
+		if (scratch.routes.empty())
+			scratch.routes.push_back(truck_route_t());
+		truck_route_t &route = scratch.routes.back();
+		int remaining = scratch.clients.size();
+		route.market = marketIdx;
+		getTruckPath(*tree, scratch.clients, route.length, route.path, scratch);
+		if (route.length == INT_INFINITY)
+			continue;
+		route.served = remaining - scratch.clients.size();
+		route.time = calculateTime(route.path, route.length, route.served);
+		routes.push_back(move(route));
+		scratch.routes.pop_back();
+	}
+}
 
-	while ( farthestVertex->path != NULL &&  farthestVertex->path->getInfo() != market)
+truck_route_t Program::getRoute(const sp_tree_t &tree, const RoadNode &dest)
+{
+	truck_route_t route;
+	route.market = getIndexOfMarket(graph.getVertexSet().at(tree.source)->getInfo());
+	route.path = graph.getTreePath(tree, dest);
+	route.served = 1;
+	route.length = INT_INFINITY;
+	route.time = INT_INFINITY;
+	if (!route.path.empty())
 	{
-		farthestVertex = farthestVertex->path;
-		clients.erase(remove(clients.begin(), clients.end(), farthestVertex->getInfo()),
-						clients.end());
-		buffer.push_front(farthestVertex);
+		route.length = graph.getPathLength(route.path);
+		route.time = calculateTime(route.path, route.length, 1);
 	}
-	if( farthestVertex->path != NULL )
-		buffer.push_front(farthestVertex->path);
+	return route;
+}
 
-	//Third part: convert to a vector and return
-	vector<RoadNode> res;
-	while( !buffer.empty() ) {
-		res.push_back( buffer.front()->getInfo() );
-		buffer.pop_front();
+void Program::displayRoutes(const vector<truck_route_t> &routes)
+{
+	int clientCounter = 0;
+	for (int i = 0; i < routes.size(); i++)
+	{
+		const truck_route_t &route = routes.at(i);
+		cout << "Path " << i + 1 << ": " << route.served << " clients served, length is ";
+		cout << route.length << " meters (" << route.length / 1000.0 << " Km), estimated time is " << route.time << " min\n";
+		clientCounter += route.served;
 	}
-	return res;
+	cout << clientCounter << " clients served by " << routes.size() << " paths\n";
 }
 
 void Program::singleMarketAllClients()
@@ -669,31 +1426,17 @@ void Program::singleMarketAllClients()
 				validPurchases.push_back(purchases.at(i).getAddr());
 		}
 	}
-	vector<RoadNode> backupVP = validPurchases;
-	int validPurchasesSize = validPurchases.size();
-	graph.dijkstraShortestPath(markets.at(marketIdx));
-	int pathId = 1;
-	int clientCounter = 0;
+	vector<truck_route_t> routes;
+	planMarketRoutes(marketIdx, validPurchases, routes, planScratch);
+	displayRoutes(routes);
 	vector<vector<RoadNode> > paths;
 	vector<pair<int, int> > distTime;
-	while (!validPurchases.empty())
+	for (int i = 0; i < routes.size(); i++)
 	{
-		int distance;
-		vector<RoadNode> path = getTruckPath(markets.at(marketIdx), validPurchases, distance);
-		if (distance != INT_INFINITY)
-		{
-			cout << "Path " << pathId << ": " << validPurchasesSize - validPurchases.size() << " clients served, length is ";
-			cout << distance << " meters (" << distance / 1000.0 << " Km), estimated time is " <<
-					calculateTime(distance, validPurchasesSize - validPurchases.size()) << " min\n";
-			clientCounter += validPurchasesSize - validPurchases.size();
-			validPurchasesSize = validPurchases.size();
-			paths.push_back(path);
-			distTime.push_back(pair<int, int>(distance, calculateTime(distance, validPurchasesSize - validPurchases.size())));
-			pathId++;
-		}
+		paths.push_back(routes.at(i).path);
+		distTime.push_back(pair<int, int>(routes.at(i).length, routes.at(i).time));
 	}
-	cout << clientCounter << " clients are served by " << paths.size() << " paths\n";
-	displaySetOfPaths(paths, backupVP);
+	displaySetOfPaths(paths, validPurchases);
 	analyzeData(distTime);
 	return;
 }
@@ -712,33 +1455,19 @@ void Program::allMarketsAllClients()
 				purchases.at(j).getClosestMarketDist() != INT_INFINITY)
 				closest.push_back(purchases.at(j).getAddr());
 		}
-		vector<RoadNode> backupVP = closest;
-		int closestSize = closest.size();
-		graph.dijkstraShortestPath(markets.at(i));
-		int pathId = 1;
-		int clientCounter = 0;
+		vector<truck_route_t> routes;
+		planMarketRoutes(i, closest, routes, planScratch);
+		displayRoutes(routes);
 		vector<vector<RoadNode> > paths;
 		vector<pair<int, int> > distTime;
-		while (!closest.empty())
+		for (int j = 0; j < routes.size(); j++)
 		{
-			int distance;
-			vector<RoadNode> path = getTruckPath(markets.at(i), closest, distance);
-			if (distance != INT_INFINITY)
-			{
-				cout << "Path " << pathId << ": " << closestSize - closest.size() << " clients served, length is ";
-				cout << distance << " meters (" << distance / 1000.0 << " Km), estimated time is " <<
-						calculateTime(distance, closestSize - closest.size()) << " min\n";
-				paths.push_back(path);
-				clientCounter += closestSize - closest.size();
-				distTime.push_back(pair<int, int>(distance, calculateTime(distance, closestSize - closest.size())));
-				pathId++;
-			}
-			closestSize = closest.size();
+			paths.push_back(routes.at(j).path);
+			distTime.push_back(pair<int, int>(routes.at(j).length, routes.at(j).time));
 		}
-		cout << clientCounter << " clients served by " << paths.size() << " paths\n";
 		try
 		{
-			displaySetOfPaths(paths, backupVP);
+			displaySetOfPaths(paths, closest);
 		}
 		catch(...)
 		{
@@ -750,114 +1479,52 @@ void Program::allMarketsAllClients()
 	}
 }
 
-pair<int, int> Program::mapCoordToXY(RoadNode n)
-{
-	float lond = (origin.second - xMax.second) / xRes;
-	float lond2 = (origin.second - n.getDegLong());
-	int x = static_cast<int>(lond2 / lond);
-
-	float latd = (origin.first - yMax.first) / yRes;
-	float latd2 = (origin.first - n.getDegLat());
-	int y = static_cast<int>(latd2 / latd);
-
-	return pair<int, int>(x, y);
-}
-
-void Program::resetGV()
+void Program::displaySetOfPaths(const vector<vector<RoadNode> > &paths, const vector<RoadNode> &clients)
 {
-	gv->closeWindow();
-	delete(gv);
-#ifdef __linux__
-	close(GraphViewer::port -1);
-	kill(GraphViewer::procId, SIGTERM);
-#else
-	system("taskkill /im java.exe /f");
-#endif
-	this->gv = new GraphViewer(xRes, yRes, false);
-	while(!gv->setBackground(mapName));
-	while(!gv->createWindow(xRes, yRes));
-}
-
-void Program::displaySetOfPaths(vector<vector<RoadNode> > paths, vector<RoadNode> clients)
-{
-	resetGV();
-	vector<pair<RoadNode, int> > processed;
-	while(!gv->defineVertexColor("blue"));
-	while(!gv->defineEdgeColor("black"));
-	while(!gv->defineEdgeCurved(false));
+	if (view == NULL || paths.empty())
+		return;
+	const vector<pair<float, float> > &points = projection.getPoints(graph);
+	vector<bool> isClient(points.size(), false);
+	for (int i = 0; i < clients.size(); i++)
+		isClient.at(graph.getVertex(clients.at(i))->getIndex()) = true;
 
-	pair<int, int> coord = mapCoordToXY(paths.at(0).at(0));
-	while(!gv->addNode(0, coord.first, coord.second));
-	while(!gv->setVertexSize(0, 5));
-	int nodeID = 1;
-	for (int i = 0; i < paths.size(); i++)
+	//the paths are added from the last, so a client on several paths is labelled with the first
+	view->clear();
+	for (int i = paths.size() - 1; i >= 0; i--)
 	{
+		int prev = -1;
 		for (int j = 0; j < paths.at(i).size(); j++)
 		{
-			bool found = false;
-			for (int k = 0; k < processed.size(); k++)
-			{
-				if (processed.at(k).first == paths.at(i).at(j))
-				{
-					found = true;
-					break;
-				}
-			}
-			if (!found)
-			{
-				coord = mapCoordToXY(paths.at(i).at(j));
-				while(!gv->addNode(nodeID, coord.first, coord.second));
-				if (find(clients.begin(), clients.end(), paths.at(i).at(j)) != clients.end())
-				{
-					while(!gv->setVertexColor(nodeID, GREEN));
-					ostringstream ss;
-					ss << "Path " << i + 1;
-					while(!gv->setVertexLabel(nodeID, ss.str()));
-				}
-				while(!gv->setVertexSize(nodeID, 5));
-				processed.push_back(pair<RoadNode, int>(paths.at(i).at(j), nodeID));
-				nodeID++;
-			}
-		}
-	}
-	while(!gv->setVertexColor(0, RED));
-	while(!gv->setVertexLabel(0, getMarketName(paths.at(0).at(0))));
-	lastNodeID = --nodeID;
-	int edgeID = 0;
-	vector<pair<int, int> > edgesProcessed;
-	for (int i = 0; i < paths.size(); i++)
-	{
-		for (int j = 1; j < paths.at(i).size(); j++)
-		{
-			pair <RoadNode, int> n1, n2;
-			for (int k = 0; k < processed.size(); k++)
-			{
-				if (processed.at(k).first == paths.at(i).at(j - 1))
-					n1 = processed.at(k);
-				if (processed.at(k).first == paths.at(i).at(j))
-					n2 = processed.at(k);
-			}
-			pair <int, int> edge(n1.second, n2.second);
-			vector<pair <int, int> >::iterator it = find(edgesProcessed.begin(),
-														edgesProcessed.end(),
-														edge);
-			if (it == edgesProcessed.end())
+			int id = graph.getVertex(paths.at(i).at(j))->getIndex();
+			const pair<float, float> &coord = points.at(id);
+			if (isClient.at(id))
 			{
-				while(!gv->addEdge(edgeID, n1.second, n2.second, EdgeType::DIRECTED));
-				while(!gv->setEdgeWeight(edgeID, n1.first.getDistanceBetween(n2.first)));
-				edgesProcessed.push_back(edge);
-				edgeID++;
+				ostringstream ss;
+				ss << "Path " << i + 1;
+				view->addNode(id, coord.first, coord.second, GREEN, ss.str());
 			}
+			else
+				view->addNode(id, coord.first, coord.second);
+			if (prev != -1)
+				view->addEdge(prev, id, paths.at(i).at(j - 1).getDistanceBetween(paths.at(i).at(j)));
+			prev = id;
 		}
 	}
-	lastEdgeID = --edgeID;
-	while(!gv->rearrange());
+	int market = graph.getVertex(paths.at(0).at(0))->getIndex();
+	view->addNode(market, points.at(market).first, points.at(market).second, RED,
+			getMarketName(paths.at(0).at(0)));
+	if (!view->show())
+		cout << "Some nodes or edges could not be displayed\n";
 }
 
 void Program::changeParameters()
 {
 	cout << "Current average velocity: " << avgVelocity << " Km/h\n";
-	cout << "Current time spent per delivery: " << deliveryTime << " min\n\n";
+	cout << "Current time spent per delivery: " << deliveryTime << " min\n";
+	cout << "Current departure time: " << setfill('0') << setw(2) << right << departureTime / 60 << ":" <<
+			setw(2) << departureTime % 60 << setfill(' ') << left << endl;
+	cout << "Speed profiles of the roads are " << (timeDependent ? "enabled" : "disabled") << endl;
+	cout << "Current routing metric: " << getMetricName(metric) << "\n\n";
 	cout << "New average velocity (between 5 Km/h and 80 Km/h): ";
 	float v = 0;
 	cin >> v;
@@ -872,6 +1539,32 @@ void Program::changeParameters()
 		cout << "Invalid time, no changes were made\n";
 	else
 		deliveryTime = i;
+	int h = -1, m = -1;
+	char sep;
+	cout << "New departure time (HH:MM): ";
+	cin >> h >> sep >> m;
+	if (h < 0 || h > 23 || m < 0 || m > 59)
+		cout << "Invalid departure time, no changes were made\n";
+	else
+		departureTime = h * 60 + m;
+	char c;
+	cout << "Use the speed profiles of the roads instead of the average velocity? (Y/N): ";
+	cin >> c;
+	if (tolower(c) != 'n' && tolower(c) != 'y')
+		cout << "Unrecognized choice entered, no changes were made\n";
+	else
+		timeDependent = (tolower(c) == 'y');
+	cout << "Routing metric (1 - " << getMetricName(DISTANCE) << ", 2 - " << getMetricName(TIME) <<
+			", 3 - " << getMetricName(COST) << "): ";
+	cin >> i;
+	if (i < 1 || i > NUM_METRICS)
+		cout << "Invalid metric, no changes were made\n";
+	else
+	{
+		metric = static_cast<metric_t>(i - 1);
+		graph.setMetric(metric);
+	}
+	customizeWeights();
 }
 
 void Program::analyzeData(vector<pair<int, int> > distTime)
@@ -958,6 +1651,8 @@ void Program::searchMenu()
 		cout << "2. Exact search for a market\n";
 		cout << "3. Approximate search for a road\n";
 		cout << "4. Approximate search for a market\n";
+		cout << "5. Find roads and markets mentioned in a text\n";
+		cout << "6. Autocomplete a road or market name\n";
 		cout << "0. Return to main menu\n";
 		cout << endl;
 		cout << "Option: ";
@@ -977,6 +1672,12 @@ void Program::searchMenu()
 		case 4:
 			searchMarketApprox();
 			break;
+		case 5:
+			searchNamesInText();
+			break;
+		case 6:
+			autocompleteName();
+			break;
 		case 0:
 			searchMenuRunning = false;
 			break;
@@ -987,6 +1688,76 @@ void Program::searchMenu()
 	}
 }
 
+void Program::searchNamesInText()
+{
+	string input;
+	bool caseSensitiveFlag;
+
+	caseSensitiveFlag = promptCaseSensitive();
+	cout << "Text (e.g. a client's address): ";
+	cin.ignore();
+	getline(cin, input);
+	vector<string_match_t> found = nameMatcher.search(input, caseSensitiveFlag);
+
+	int shown = 0;
+	for (int i = 0; i < found.size(); i++)
+	{
+		//names inside a longer name that was also found (such as "Alameda" in "Rua da Alameda") are not shown
+		bool contained = false;
+		for (int j = 0; j < found.size() && !contained; j++)
+			contained = found.at(j).length > found.at(i).length && found.at(j).position <= found.at(i).position &&
+				found.at(j).position + found.at(j).length >= found.at(i).position + found.at(i).length;
+		if (contained)
+			continue;
+
+		string name = nameMatcher.getString(found.at(i).id);
+		if (found.at(i).id < roadNames.size())
+		{
+			cout << "Road \"" << name << "\"";
+			string mk = roadMarkets[name];
+			if (mk != "")
+				cout << ", adjacent to market \"" << mk << "\"";
+		}
+		else
+		{
+			pair<string, string> rd = adjacentRoads[name];
+			cout << "Market \"" << name << "\", adjacent roads: " << rd.first << ", " << rd.second;
+		}
+		cout << " (at position " << found.at(i).position << ")\n";
+		shown++;
+	}
+	if (shown == 0)
+		cout << "No road or market was mentioned in the text\n";
+}
+
+void Program::autocompleteName()
+{
+	string input;
+	cin.ignore();
+	while (true)
+	{
+		cout << "Beginning of the name (empty to return): ";
+		getline(cin, input);
+		if (input == "")
+			return;
+
+		vector<int> found = nameCompleter.complete(input, AUTOCOMPLETE_RESULTS);
+		if (found.empty())
+		{
+			cout << "No road or market starts with \"" << input << "\"\n";
+			continue;
+		}
+		for (int i = 0; i < found.size(); i++)
+		{
+			if (found.at(i) < roadNames.size())
+				cout << "Road \"";
+			else
+				cout << "Market \"";
+			cout << nameCompleter.getString(found.at(i)) << "\"\n";
+		}
+	}
+}
+
 bool Program::promptCaseSensitive()
 {
 	char caseSensitive;
@@ -1012,7 +1783,7 @@ void Program::searchRoadExact()
 	cout << "Name of the road: ";
 	cin.ignore();
 	getline(cin, input);
-	string found = kmpStringMatching(roadNamesString, input, caseSensitiveFlag);
+	string found = exactStringMatching(roadNamesString, input, caseSensitiveFlag);
 
 	if (found=="")
 	{
@@ -1040,7 +1811,7 @@ void Program::searchMarketExact()
 	cout << "Name of the market: ";
 	cin.ignore();
 	getline(cin, input);
-	string found = kmpStringMatching(marketNamesString, input, caseSensitiveFlag);
+	string found = exactStringMatching(marketNamesString, input, caseSensitiveFlag);
 
 
 
@@ -1072,7 +1843,14 @@ void Program::searchRoadApprox()
 
 	priority_queue<ApproxString> pq;
 
-	pq = approximateStringMatching(roadNames, input, caseSensitiveFlag);
+	pq = roadTree.search(input, caseSensitiveFlag, APPROX_MAX_EDITS);
+	if (pq.empty())
+		pq = roadIndex.search(input, caseSensitiveFlag, 10);
+	if (pq.empty())
+	{
+		cout << "No road with this name was found, nor any similar one\n";
+		return;
+	}
 	if (pq.top().getCloseness() == 0)
 	{
 		cout << "Road \"" << pq.top().getString() << "\" found\n";
@@ -1114,7 +1892,14 @@ void Program::searchMarketApprox()
 	getline(cin, input);
 
 	priority_queue<ApproxString> pq;
-	pq = approximateStringMatching(marketNames, input, caseSensitiveFlag);
+	pq = marketTree.search(input, caseSensitiveFlag, APPROX_MAX_EDITS);
+	if (pq.empty())
+		pq = marketIndex.search(input, caseSensitiveFlag, 10);
+	if (pq.empty())
+	{
+		cout << "No market with this name was found, nor any similar one\n";
+		return;
+	}
 	if (pq.top().getCloseness() == 0)
 	{
 		cout << "Market \"" << input <<"\" found\n";
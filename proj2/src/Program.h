@@ -2,20 +2,59 @@
 #define PROGRAM_H_
 
 #include "Graph.h"
-#include "graphviewer.h"
+#include "ViewSession.h"
+#include "Renderer.h"
+#include "CoreGraph.h"
+#include "TurnGraph.h"
+#include "TreeCache.h"
+#include "HubLabels.h"
+#include "Projection.h"
 #include "Purchase.h"
 #include "RoadNode.h"
+#include "StringFunctions.h"
 #include <string>
 #include <map>
 #include <unordered_map>
+#include <iostream>
+
+/**
+ * A route of a truck, which leaves a market, serves some of its clients and ends at the farthest one
+ */
+struct truck_route_t
+{
+	int market;					/// index of the market (in Program::markets), or -1 if the route does not start at a market
+	vector<RoadNode> path;		/// nodes of the route, starting at the market
+	int served;					/// amount of clients served by the route
+	int length;					/// length of the route (in meters)
+	int time;					/// estimated duration of the route, deliveries included (in minutes)
+};
+
+/**
+ * Buffers reused by the route planner, so planning allocates no memory once they have grown to the size
+ * of the graph and of the paths (each thread planning needs its own)
+ */
+struct plan_scratch_t
+{
+	vector<int> stamps;				/// For each vertex, the number of the last path marked on it
+	int stamp;						/// Number of the current path
+	vector<int> clientVertices;		/// Index of the vertex of each client still to serve
+	vector<int> pathVertices;		/// Indexes of the vertices of the current path, from the market
+	vector<RoadNode> clients;		/// Clients still to serve by the routes being planned
+	vector<truck_route_t> routes;	/// Routes of earlier plans no longer used, kept for the memory of their paths
+};
 
 class Program
 {
 private:
-	GraphViewer* gv;					/// Pointer to a GraphViewer instantiation
+	ViewSession* view;					/// GraphViewer window, kept open between displays (NULL without a viewer)
 	Graph<RoadNode> graph;				/// The main graph
+	CoreGraph* core;					/// The main graph with its pass-through vertexes contracted, used for the shortest path trees
+	TurnGraph* turns;					/// The main graph expanded at the junctions with turn rules, used for the shortest path trees instead of core (NULL without rules)
 	vector<road_t> r;					/// A vector which holds information about all roads
 	vector<Purchase> purchases;			/// A vector that holds all the clients/purchases
+	TreeCache trees;					/// Shortest path trees computed so far (from the markets or from any other node)
+	HubLabels labels;					/// Distance oracle over the graph, with the current weights (empty until it is prepared)
+	string labelsFile;					/// Prefix of the files the labels are kept in, between runs (one file per metric)
 
 	string roadNamesString;				/// A string holding all names of the roads, without duplicates
 	string marketNamesString;			/// A string holding all names of the markets, without duplicates
@@ -23,6 +62,13 @@ private:
 	vector<RoadNode> markets;			/// A vector that holds all the nodes that match a market
 	vector<string> marketNames;			/// A vector that holds the names of all markets
 	vector<string> roadNames;			/// A vector that holds the names of all roads
+	NGramIndex roadIndex;				/// Trigram index of the names of all roads, for approximate search
+	NGramIndex marketIndex;				/// Trigram index of the names of all markets, for approximate search
+	BKTree roadTree;					/// BK-tree of the names of all roads, for bounded approximate search
+	BKTree marketTree;					/// BK-tree of the names of all markets, for bounded approximate search
+	AhoCorasick nameMatcher;			/// Automaton over the names of all roads followed by all markets, to find them in a text
+	CompletionTrie nameCompleter;		/// Prefix tree over the names of all roads followed by all markets, ranked by popularity
+	unordered_map<string, int> roadSegments;	/// A map that, for each road, has the amount of edges of the graph belonging to it
 
 	unordered_map<string, string> roadMarkets;					/// A map that, for each road, has the market adjacent to it (or "" if it has no market)
 	unordered_map<string, pair<string, string>> adjacentRoads;	/// A map that, for each market, has a pair with its two adjacent roads
@@ -30,15 +76,18 @@ private:
 	unsigned int xRes;					/// The x resolution of the map
 	unsigned int yRes;					/// The y resolution of the map
 	string mapName;						/// The path and/or name of the map picture
-	pair<float, float> origin;			/// The geographical coordinate of the map's top left corner
-	pair<float, float> xMax;			/// The geographical coordinate of the map's top right corner
-	pair<float, float> yMax;			/// The geographical coordinate of the map's bottom left corner
+	Projection projection;				/// Position of the nodes on the map picture
 
 	bool running;						/// Flag which tells if the main loop is running
 	float avgVelocity;					/// Average velocity value for the trucks (in Km/h)
 	int deliveryTime;					/// Time spent on a single delivery (in min)
-	int lastEdgeID;						/// Last id used for an Edge on GraphViewer
-	int lastNodeID;						/// Last id used for a Node on GraphViewer
+	int departureTime;					/// Time of departure of the trucks (in minutes since midnight)
+	bool timeDependent;					/// True if travel times follow the speed profiles of the roads, false if they use avgVelocity
+	metric_t metric;					/// Metric optimised by the routing algorithms (distance, time or cost)
+	string renderFile;					/// SVG file or tile directory where batch jobs draw their routes ("" for none)
+	int renderZoom;						/// Largest zoom level of the tiles drawn by batch jobs
+	plan_scratch_t planScratch;			/// Buffers of the route planner, for the menu and batch jobs (see Program::planMarketRoutes)
+	vector<double> slowdown;			/// Factor the weights of each edge are multiplied by, in every metric (see Program::changeRoadState)
 
 	/**
 	 * Loads the main graph from three files
@@ -69,13 +118,13 @@ private:
 	 * Displays the statistics of a graph (number of nodes and edges)
 	 * @param g the graph whose statistics will be displayed
 	 */
-	void displayGraphStatistics(Graph<RoadNode> g);
+	void displayGraphStatistics(Graph<RoadNode> &g);
 
 	/**
 	 * Displays a full graph using GraphViewer
 	 * @param g the graph to be displayed
 	 */
-	void displayGraph(Graph<RoadNode> g);
+	void displayGraph(Graph<RoadNode> &g);
 
 	/**
 	 * Displays all markets (id and name)
@@ -110,40 +159,74 @@ private:
 	 * @param paths a vector with paths (each path is a vector of RoadNodes)
 	 * @param clients a vector of the clients to be signalled
 	 */
-	void displaySetOfPaths(vector<vector<RoadNode> > paths, vector<RoadNode> clients);
+	void displaySetOfPaths(const vector<vector<RoadNode> > &paths, const vector<RoadNode> &clients);
 
 	/**
-	 * Clears the graphviewer of all edges and nodes
+	 * Calculates the average amount of time needed to travel a specified distance
+	 * @param length travelled distance
+	 * @param extraTime time spent on the way other than travelling, such as turning (in seconds)
+	 * @return average time to travel specified distance (in minutes)
 	 */
-	void resetGV();
+	int calculateTime(int length, int numberOfClients, double extraTime = 0);
 
 	/**
-	 * Generates the specified amount of purchases
-	 * @param n amount of purchases to generate
+	 * Calculates the time needed to travel an edge, slowed down by the factor set by the user on its road.
+	 * If Program::timeDependent is set the speed profile of the road is used, otherwise the average velocity is used
+	 * @param e the edge
+	 * @param departure time at which the edge is entered (in seconds since midnight)
+	 * @return travel time in seconds
 	 */
-	void generatePurchases(int n);
+	double getTravelTime(const Edge<RoadNode> &e, double departure) const;
 
 	/**
-	 * Calculates the average amount of time needed to travel a specified distance
-	 * @param length travelled distance
-	 * @return average time to travel specified distance (in minutes)
+	 * Checks if the shortest path trees are computed by the time-dependent search (see Graph::timeDependentShortestPathTree),
+	 * which happens when the travel times follow the speed profiles and the metric is time or cost, unless turn rules
+	 * were loaded (the trees with turn states use the weights at Program::departureTime)
+	 * @return true if the trees are time-dependent, false otherwise
 	 */
-	int calculateTime(int length, int numberOfClients);
+	bool isTimeDependent() const;
 
 	/**
-	 * Converts a node's geographical coordinates to a (x, y) coordinate system
-	 * @param n node whose coordinates will be converted
-	 * @return pair with the coordinates x and y (in this order)
+	 * Calculates the cost of travelling an edge
+	 * @param e the edge
+	 * @param seconds time taken to travel the edge
+	 * @return cost in cents of the fuel, tolls (slowed down by the factor set by the user on its road) and driver
 	 */
-	pair<int, int> mapCoordToXY(RoadNode n);
+	double getCost(const Edge<RoadNode> &e, double seconds) const;
 
+	/**
+	 * Calculates the weight of an edge in a metric, from the current parameters and the factor set by the user
+	 * on its road (the travel time is the one at Program::departureTime)
+	 * @param e the edge
+	 * @param m the metric
+	 * @return the weight
+	 */
+	double getWeight(const Edge<RoadNode> &e, metric_t m) const;
 
 	/**
-	 * Gets the Market's index in the markets vector
-	 * @param m market to search for in the markets vector
-	 * @return index of given market or -1 if it doesn't exists
+	 * Calculates the amount of time needed to travel a path, departing at Program::departureTime,
+	 * with the travel time of each edge given by Program::getTravelTime (the time of the turns is
+	 * added if turn rules were loaded)
+	 * @param path the path to travel
+	 * @param length length of the path
+	 * @param numberOfClients number of deliveries made along the path
+	 * @return time to travel the path (in minutes)
 	 */
-	int getIndexOfMarket(RoadNode m);
+	int calculateTime(const vector<RoadNode> &path, int length, int numberOfClients);
+
+	/**
+	 * Recomputes the weights of all edges of the graph from the current parameters (average velocity,
+	 * departure time and speed profiles) and the factors set by the user on each road
+	 */
+	void customizeWeights();
+
+	/**
+	 * Gets the name of a metric and its unit
+	 * @param m the metric
+	 * @return string with the name and unit of the metric
+	 */
+	string getMetricName(metric_t m);
+
 
 	/**
 	 * Gets the market's name based on its index on the markets vector
@@ -160,54 +243,66 @@ private:
 	string getMarketName(RoadNode n);
 
 	/**
-	 * Goes through the markets vector to check the valid state of each market
-	 * @see Program::dfsConnectivity
+	 * Marks as visited every vertex reachable from a vertex through open edges,
+	 * using an explicit stack so large graphs do not overflow the call stack
+	 * @param v vertex where the search starts (usually a market)
 	 */
-	void checkValidMarkets();
+	void dfsConnectivity(Vertex<RoadNode>* v);
+
+	/**
+	 * Allows the user to change parameters such as average velocity, time per delivery and departure time
+	 */
+	void changeParameters();
 
 	/**
-	 * Adds the given market to the address that matches purchaseAddr if purchaseAddr is a purchase
-	 * @param market RoadNode of the market to add to the purchase
-	 * @param purchaseAddr RoadNode of the client's adress
+	 * Allows the user to close, reopen or change the weights of a road, repairing
+	 * the shortest path trees in the cache instead of recomputing them
 	 */
-	void addMarketToPurchase(RoadNode market, RoadNode purchaseAddr);
+	void changeRoadState();
+
+	/*
+	 * Analyzes data about several paths (their distance and duration)
+	 * and displays various alternatives based on possible number of trucks
+	 * @param distTime a vector with pairs holding info about paths. Each
+	 * pair holds the distance of a path and its duration, by this order
+	 */
+	void analyzeData(vector<pair<int, int> > distTime);
 
 	/**
-	 * Tries to find a path from the market to a purchase
-	 * @see Program::addMarketToPurchase
-	 * @param v vertex purchase
-	 * @param market market's address
+	 * Prints the routes of a market, one per line, followed by the amount of clients served
+	 * @param routes the routes
 	 */
-	void dfsConnectivity(Vertex<RoadNode>* v, RoadNode market);
+	void displayRoutes(const vector<truck_route_t> &routes);
 
 	/**
-	 * Allows the user to change parameters such as average velocity and time per delivery
+	 * Reads the parameters, markets and purchases of a batch job, applying them
+	 * @param jobFile file with the job (see Program::runBatch)
+	 * @return true if the job is valid, false otherwise (after printing the reason)
 	 */
-	void changeParameters();
+	bool loadJob(const string &jobFile);
 
 	/**
-	 * Uses Dijkstra's shortest path algorithm to get the shortest way from the market to the client
-	 * And calls setClosestMarketIndex
-	 * @see Purchase::setClosestMarketIndex
+	 * Writes the results of a batch job as JSON
+	 * @param out stream to write to
+	 * @param routes routes of each market (same order as Program::markets)
+	 * @param times time spent on connectivity, assignment and planning (in microseconds)
 	 */
-	void setClosestMarketToAllClients();
+	void writeBatchJSON(ostream &out, const vector<vector<truck_route_t> > &routes, const vector<double> &times);
 
 	/**
-	 * Gets the path for the truck to deliver to all clients
-	 * @param market node that represents both the starting point and the finish
-	 * @param clients vector with all the clients for the delivery
-	 * @param distance pointer used to return the distance between the market and the farthest client
-	 * @return vector containing the trucks path for the delivery
+	 * Writes the routes of a batch job as CSV, one route per line with a header line
+	 * @param out stream to write to
+	 * @param routes routes of each market (same order as Program::markets)
 	 */
-	vector<RoadNode> getTruckPath(RoadNode market, vector<RoadNode> &clients, int &distance);
+	void writeBatchCSV(ostream &out, const vector<vector<truck_route_t> > &routes);
 
-	/*
-	 * Analyzes data about several paths (their distance and duration)
-	 * and displays various alternatives based on possible number of trucks
-	 * @param distTime a vector with pairs holding info about paths. Each
-	 * pair holds the distance of a path and its duration, by this order
+	/**
+	 * Draws the graph with the routes of a batch job, the markets and the purchases, without GraphViewer
+	 * @param file an SVG file (if its name ends in ".svg") or a directory for PNG tiles
+	 * @param routes routes of each market (same order as Program::markets)
+	 * @return true if the file or the tiles were written, false otherwise
 	 */
-	void analyzeData(vector<pair<int, int> > distTime);
+	bool renderRoutes(const string &file, const vector<vector<truck_route_t> > &routes);
 
 	/**
 	 * Distributes from a single market to a single client
@@ -254,6 +349,17 @@ private:
 	 */
 	void searchMarketApprox();
 
+	/**
+	 * Finds every road and market whose name is mentioned in a text typed by the user, such as a client's address
+	 */
+	void searchNamesInText();
+
+	/**
+	 * Completes the beginning of a road or market name typed by the user, showing the most popular matches,
+	 * and asks again so the user can keep refining the name
+	 */
+	void autocompleteName();
+
 	/**
 	 * Prompts the user to ask them if they want to make a case-sensitive search
 	 * @return true if the user wants to use case-sensitiveness or if the user input was unrecognizable, false otherwise
@@ -264,13 +370,166 @@ public:
 	/**
 	 * Creates a Program object
 	 * @param files array containing data files' names
+	 * @param useViewer true to open a GraphViewer window, false to run without display (e.g. in benchmarks)
+	 */
+	Program(char** files, bool useViewer = true);
+
+	/**
+	 * Destroys the program
 	 */
-	Program(char** files);
+	~Program();
 
 	/**
 	 * Starts the application's interface
 	 */
 	void run();
+
+	/**
+	 * Runs a job without user interaction: checks the connectivity of the purchases, assigns each one to
+	 * its closest market and plans the routes of the trucks of every market.
+	 * The job file has one "key;value" pair per line (lines starting with # are ignored):
+	 *   velocity;30            average velocity (Km/h)
+	 *   delivery;2             time per delivery (min)
+	 *   departure;09:00        departure time
+	 *   profiles;True          use the speed profiles of the roads (True/False)
+	 *   metric;distance        routing metric (distance, time or cost)
+	 *   seed;1                 seed of the random purchases
+	 *   purchases;100          amount of random purchases
+	 *   purchase;25507550      a purchase at a node (repeatable, replaces the random purchases)
+	 *   market;409089302;Name  a market at a node (repeatable, replaces the markets loaded, name optional)
+	 *   render;routes.svg      draw the routes as an SVG file, or as PNG tiles if the name does not end in ".svg"
+	 *   zoom;3                 largest zoom level of the tiles (0 to RENDER_MAX_ZOOM)
+	 *   projection;mercator    projection of the map picture (equirectangular or mercator)
+	 *   cache;64               memory for the shortest path trees kept between queries (MB, 1 to TREE_CACHE_MAX_MB)
+	 *   turns;res/turns.txt    turn costs and restrictions to obey (see TurnGraph)
+	 * @param jobFile file with the job
+	 * @param outputFile file for the results, written as CSV if its name ends in ".csv" and as JSON otherwise
+	 * @return true if the job ran, false if the job or the output file were invalid
+	 */
+	bool runBatch(const string &jobFile, const string &outputFile);
+
+	/**
+	 * Loads turn costs and restrictions, which the routes obey from then on (with their time in the ETAs)
+	 * @param file turn file (see TurnGraph)
+	 * @return true if the rules were loaded, false if the file is missing or invalid (after printing the reason)
+	 */
+	bool loadTurns(const string &file);
+
+	/**
+	 * Gets the main graph
+	 * @return reference to Program::graph
+	 */
+	Graph<RoadNode> &getGraph();
+
+	/**
+	 * Gets all markets
+	 * @return reference to Program::markets
+	 */
+	const vector<RoadNode> &getMarkets() const;
+
+	/**
+	 * Gets all purchases
+	 * @return reference to Program::purchases
+	 */
+	const vector<Purchase> &getPurchases() const;
+
+	/**
+	 * Generates the specified amount of purchases
+	 * @param n amount of purchases to generate
+	 */
+	void generatePurchases(int n);
+
+	/**
+	 * Goes through the markets vector to check the valid state of each market
+	 * @see Program::dfsConnectivity
+	 */
+	void checkValidMarkets();
+
+	/**
+	 * Uses Dijkstra's shortest path algorithm to get the shortest way from the market to the client
+	 * And calls setClosestMarketIndex, after clearing the closest market of every purchase
+	 * @see Purchase::setClosestMarketIndex
+	 */
+	void setClosestMarketToAllClients();
+
+	/**
+	 * Gets the path for a truck to the client farthest away from its market, removing from the
+	 * clients vector that client and every other client on the way
+	 * @param tree shortest path tree from the market
+	 * @param clients vector with all the clients for the delivery
+	 * @param distance used to return the distance between the market and the farthest client (INT_INFINITY if unreachable)
+	 * @param path used to return the trucks path for the delivery (empty if the farthest client is unreachable)
+	 * @param scratch buffers of the planner, reused between calls (stamps must be empty or sized to the vertex set)
+	 */
+	void getTruckPath(const sp_tree_t &tree, vector<RoadNode> &clients, int &distance, vector<RoadNode> &path,
+			plan_scratch_t &scratch);
+
+	/**
+	 * Gets the Market's index in the markets vector
+	 * @param m market to search for in the markets vector
+	 * @return index of given market or -1 if it doesn't exists
+	 */
+	int getIndexOfMarket(RoadNode m);
+
+	/**
+	 * Computes the shortest path trees from the markets that are not in the cache (as many as fit in it)
+	 */
+	void updateMarketTrees();
+
+	/**
+	 * Gets the shortest path tree from a node, with the current weights, computing it if it is not in the cache
+	 * (thread-safe, as long as the weights do not change)
+	 * @param source the node
+	 * @return the tree (NULL if the node does not exist)
+	 */
+	shared_ptr<const sp_tree_t> getTree(const RoadNode &source);
+
+	/**
+	 * Gets the cache of shortest path trees
+	 * @return reference to Program::trees
+	 */
+	TreeCache &getTreeCache();
+
+	/**
+	 * Prepares the distance oracle, if it is empty: maps its file for the current metric, or builds the labels
+	 * and writes that file if it is missing or was written for another graph
+	 * @return true if the oracle is ready, false if the labels do not fit in memory (see HUB_LABELS_DEFAULT_MB),
+	 * turn rules were loaded or the trees are time-dependent (the labels do not obey them)
+	 */
+	bool prepareHubLabels();
+
+	/**
+	 * Gets the distance oracle (thread-safe once it is prepared, as long as the weights do not change)
+	 * @return reference to Program::labels (empty if it was not prepared, see Program::prepareHubLabels)
+	 */
+	const HubLabels &getHubLabels() const;
+
+	/**
+	 * Gets the contracted graph used to compute shortest path trees
+	 * @return reference to the content of Program::core
+	 */
+	const CoreGraph &getCoreGraph() const;
+
+	/**
+	 * Plans the routes of the trucks of a market, each one serving the farthest remaining client
+	 * and every other client on the way. The routes and the buffers are reused between calls, so once
+	 * they have grown planning allocates no memory. Only the cache of shortest path trees is changed (see
+	 * Program::getTree), so several threads may plan at once, each with its own buffers
+	 * @param marketIdx index of the market (in Program::markets)
+	 * @param clients clients to serve (all must be reachable from the market)
+	 * @param routes where the routes are written, in the order they were planned (replacing its contents)
+	 * @param scratch buffers of the planner, reused between calls
+	 */
+	void planMarketRoutes(int marketIdx, const vector<RoadNode> &clients, vector<truck_route_t> &routes,
+			plan_scratch_t &scratch);
+
+	/**
+	 * Gets the shortest route from the source of a tree to a node, without changing the program
+	 * @param tree shortest path tree from the start of the route (a market or any other node)
+	 * @param dest the node
+	 * @return the route, serving only dest (with an empty path if dest is unreachable)
+	 */
+	truck_route_t getRoute(const sp_tree_t &tree, const RoadNode &dest);
 };
 
 
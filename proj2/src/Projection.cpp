@@ -0,0 +1,68 @@
+#include "Projection.h"
+#include <cmath>
+
+#define PI 3.14159265358979323846
+
+Projection::Projection(projection_t type): type(type), width(0), height(0), left(0), top(0), scaleX(0), scaleY(0), outdated(true)
+{
+}
+
+pair<double, double> Projection::projectRaw(float lat, float lon) const
+{
+	if (type == WEB_MERCATOR)
+		return pair<double, double>(lon, log(tan(PI / 4 + lat * PI / 360)) * 180 / PI);
+	return pair<double, double>(lon, lat);
+}
+
+void Projection::updateScale()
+{
+	pair<double, double> topLeft = projectRaw(origin.first, origin.second);
+	pair<double, double> right = projectRaw(xMax.first, xMax.second);
+	pair<double, double> bottom = projectRaw(yMax.first, yMax.second);
+	left = topLeft.first;
+	top = topLeft.second;
+	scaleX = (right.first != left ? width / (right.first - left) : 0);
+	scaleY = (bottom.second != top ? height / (top - bottom.second) : 0);
+	outdated = true;
+}
+
+void Projection::setViewport(pair<float, float> origin, pair<float, float> xMax, pair<float, float> yMax, int width, int height)
+{
+	this->origin = origin;
+	this->xMax = xMax;
+	this->yMax = yMax;
+	this->width = width;
+	this->height = height;
+	updateScale();
+}
+
+void Projection::setType(projection_t type)
+{
+	if (this->type == type)
+		return;
+	this->type = type;
+	updateScale();
+}
+
+projection_t Projection::getType() const
+{
+	return type;
+}
+
+pair<float, float> Projection::project(const RoadNode &n) const
+{
+	pair<double, double> p = projectRaw(n.getDegLat(), n.getDegLong());
+	return pair<float, float>((p.first - left) * scaleX, (top - p.second) * scaleY);
+}
+
+const vector<pair<float, float> > &Projection::getPoints(const Graph<RoadNode> &graph)
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	if (!outdated && points.size() == vs.size())
+		return points;
+	points.resize(vs.size());
+	for (int i = 0; i < vs.size(); i++)
+		points[i] = project(vs[i]->getInfo());
+	outdated = false;
+	return points;
+}
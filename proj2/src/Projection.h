@@ -0,0 +1,98 @@
+#ifndef PROJECTION_H_
+#define PROJECTION_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include <vector>
+
+/**
+ * Map projections, which turn geographical coordinates into flat ones
+ */
+enum projection_t
+{
+	EQUIRECTANGULAR,		/// Longitude and latitude are both linear on the map
+	WEB_MERCATOR,			/// Latitude is stretched towards the poles, as in web maps (and OpenStreetMap exports)
+	NUM_PROJECTIONS			/// Number of projections
+};
+
+/**
+ * Places the nodes of a graph on a map picture (the viewport), given by the geographical coordinates of three of
+ * its corners and its resolution. The scale factors are computed once per viewport, and the position of every
+ * vertex is kept in a flat array (in the order of the vertex set), which is only computed again when it is asked
+ * for after the viewport or the projection changed.
+ */
+class Projection
+{
+private:
+	projection_t type;					/// Projection used
+	pair<float, float> origin;			/// The geographical coordinate of the map's top left corner
+	pair<float, float> xMax;			/// The geographical coordinate of the map's top right corner
+	pair<float, float> yMax;			/// The geographical coordinate of the map's bottom left corner
+	int width;							/// Width of the map (in pixels)
+	int height;							/// Height of the map (in pixels)
+	double left;						/// Projected x coordinate of the left side of the map
+	double top;							/// Projected y coordinate of the top of the map
+	double scaleX;						/// Pixels per unit of projected x coordinate
+	double scaleY;						/// Pixels per unit of projected y coordinate (downwards)
+	vector<pair<float, float> > points;	/// Position of each vertex of the last graph projected (in pixels)
+	bool outdated;						/// True if Projection::points must be computed again
+
+	/**
+	 * Projects a geographical coordinate, before it is scaled to the map
+	 * @param lat latitude (in degrees)
+	 * @param lon longitude (in degrees)
+	 * @return projected x and y coordinates (y grows northwards)
+	 */
+	pair<double, double> projectRaw(float lat, float lon) const;
+
+	/**
+	 * Computes the scale factors of the current viewport and projection
+	 */
+	void updateScale();
+
+public:
+	/**
+	 * Creates a projection with an empty viewport
+	 * @param type projection used
+	 */
+	Projection(projection_t type = EQUIRECTANGULAR);
+
+	/**
+	 * Sets the viewport (the vertices are projected again when they are next asked for)
+	 * @param origin geographical coordinate of the top left corner
+	 * @param xMax geographical coordinate of the top right corner
+	 * @param yMax geographical coordinate of the bottom left corner
+	 * @param width width of the map (in pixels)
+	 * @param height height of the map (in pixels)
+	 */
+	void setViewport(pair<float, float> origin, pair<float, float> xMax, pair<float, float> yMax, int width, int height);
+
+	/**
+	 * Sets the projection (the vertices are projected again when they are next asked for)
+	 * @param type projection used
+	 */
+	void setType(projection_t type);
+
+	/**
+	 * Gets the projection used
+	 * @return value of Projection::type
+	 */
+	projection_t getType() const;
+
+	/**
+	 * Places a single node on the map
+	 * @param n the node
+	 * @return x and y coordinates (in pixels, from the top left corner)
+	 */
+	pair<float, float> project(const RoadNode &n) const;
+
+	/**
+	 * Gets the position of every vertex of a graph on the map, projecting them if the viewport or the
+	 * projection changed since the last call (or the graph has another amount of vertices)
+	 * @param graph the graph
+	 * @return x and y coordinates of each vertex (same order as the vertex set, in pixels)
+	 */
+	const vector<pair<float, float> > &getPoints(const Graph<RoadNode> &graph);
+};
+
+#endif /* PROJECTION_H_ */
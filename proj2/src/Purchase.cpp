@@ -23,6 +23,11 @@ void Purchase::addValidMarket(RoadNode &market)
 	validMarkets.push_back(market);
 }
 
+void Purchase::clearValidMarkets()
+{
+	validMarkets.clear();
+}
+
 int Purchase::getClosestMarketIndex() const
 {
 	return closestMarket.first;
@@ -45,6 +50,11 @@ bool Purchase::setClosestMarketIndex(int index, int distance)
 		return false;
 }
 
+void Purchase::clearClosestMarket()
+{
+	closestMarket = pair<int, int>(-1, INT_MAX);
+}
+
 bool operator==(const Purchase &p1, const Purchase &p2)
 {
 	return (p1.getAddr() == p2.getAddr());
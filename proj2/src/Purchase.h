@@ -43,6 +43,11 @@ public:
 	 */
 	void addValidMarket(RoadNode &market);
 
+	/**
+	 * Removes all markets from the validMarkets vector
+	 */
+	void clearValidMarkets();
+
 	/**
 	 * Gets the index of closest market
 	 * @return first member of the pair closestMarket
@@ -62,6 +67,11 @@ public:
 	 * @return true if potential market is indeed closer than previous one. Returns false otherwise
 	 */
 	bool setClosestMarketIndex(int index, int distance);
+
+	/**
+	 * Forgets the closest market, before the distances are computed again (e.g. in another metric)
+	 */
+	void clearClosestMarket();
 };
 /**
  * Compares two purchases given that: two purchases are the same if the address is the same.
@@ -0,0 +1,547 @@
+#include "Renderer.h"
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cerrno>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#else
+#include <direct.h>
+#endif
+
+#define RENDER_ROUTE_RADIUS 1		//routes are 2 * radius + 1 pixels wide
+#define RENDER_MARKER_RADIUS 3		//radius of the dots of the markers (in pixels)
+
+//RGB colors of each render_color_t
+const unsigned char renderPalette[NUM_RENDER_COLORS][3] = { { 255, 255, 255 }, { 120, 120, 120 }, { 220, 30, 30 },
+	{ 30, 160, 50 }, { 30, 90, 220 }, { 240, 140, 0 }, { 140, 50, 180 }, { 0, 160, 160 }, { 220, 0, 140 }, { 130, 80, 30 } };
+
+/**
+ * Bits of a deflate stream, which are packed starting at the least significant bit of each byte
+ */
+struct bit_writer_t
+{
+	vector<unsigned char> bytes;	/// complete bytes
+	unsigned int bits;				/// bits not yet in a complete byte
+	int count;						/// amount of bits in bit_writer_t::bits
+};
+
+/**
+ * Appends bits to a deflate stream, least significant first
+ */
+static void writeBits(bit_writer_t &w, unsigned int value, int count)
+{
+	w.bits |= value << w.count;
+	w.count += count;
+	while (w.count >= 8)
+	{
+		w.bytes.push_back(w.bits & 0xFF);
+		w.bits >>= 8;
+		w.count -= 8;
+	}
+}
+
+/**
+ * Appends a Huffman code to a deflate stream, most significant bit first
+ */
+static void writeCode(bit_writer_t &w, unsigned int code, int length)
+{
+	for (int i = length - 1; i >= 0; i--)
+		writeBits(w, (code >> i) & 1, 1);
+}
+
+/**
+ * Appends a literal/length symbol with the fixed Huffman codes of deflate
+ */
+static void writeSymbol(bit_writer_t &w, int symbol)
+{
+	if (symbol < 144)
+		writeCode(w, 0x30 + symbol, 8);
+	else if (symbol < 256)
+		writeCode(w, 0x190 + symbol - 144, 9);
+	else if (symbol < 280)
+		writeCode(w, symbol - 256, 7);
+	else
+		writeCode(w, 0xC0 + symbol - 280, 8);
+}
+
+/**
+ * Compresses data as a zlib stream with a single fixed Huffman block, whose only matches are runs of
+ * a repeated byte (which is most of a tile)
+ */
+static vector<unsigned char> deflateRuns(const vector<unsigned char> &data)
+{
+	static const int lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+										67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const int lengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+										4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	bit_writer_t w;
+	w.bits = 0;
+	w.count = 0;
+	w.bytes.push_back(0x78);
+	w.bytes.push_back(0x01);
+	writeBits(w, 1, 1);		//last block
+	writeBits(w, 1, 2);		//fixed Huffman codes
+
+	for (int i = 0; i < data.size(); )
+	{
+		int run = 0;
+		if (i > 0)
+			while (run < 258 && i + run < data.size() && data.at(i + run) == data.at(i - 1))
+				run++;
+		if (run < 3)
+		{
+			writeSymbol(w, data.at(i));
+			i++;
+			continue;
+		}
+		int code = 28;
+		while (lengthBase[code] > run)
+			code--;
+		writeSymbol(w, 257 + code);
+		writeBits(w, run - lengthBase[code], lengthExtra[code]);
+		writeCode(w, 0, 5);		//distance 1
+		i += run;
+	}
+	writeSymbol(w, 256);
+	if (w.count > 0)
+		writeBits(w, 0, 8 - w.count);
+
+	unsigned int a = 1, b = 0;
+	for (int i = 0; i < data.size(); i++)
+	{
+		a = (a + data.at(i)) % 65521;
+		b = (b + a) % 65521;
+	}
+	unsigned int adler = (b << 16) | a;
+	for (int i = 3; i >= 0; i--)
+		w.bytes.push_back((adler >> (8 * i)) & 0xFF);
+	return w.bytes;
+}
+
+/**
+ * Computes the table of the CRC-32 of the PNG chunks
+ */
+static vector<unsigned int> crcTable()
+{
+	vector<unsigned int> table(256);
+	for (unsigned int n = 0; n < 256; n++)
+	{
+		unsigned int c = n;
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		table.at(n) = c;
+	}
+	return table;
+}
+
+/**
+ * Writes a PNG chunk (length, type, data and CRC)
+ */
+static void writeChunk(ostream &out, const string &type, const vector<unsigned char> &data)
+{
+	static const vector<unsigned int> table = crcTable();
+	vector<unsigned char> bytes(type.begin(), type.end());
+	bytes.insert(bytes.end(), data.begin(), data.end());
+	unsigned int crc = 0xFFFFFFFF;
+	for (int i = 0; i < bytes.size(); i++)
+		crc = table[(crc ^ bytes.at(i)) & 0xFF] ^ (crc >> 8);
+	crc ^= 0xFFFFFFFF;
+
+	unsigned int length = data.size();
+	for (int i = 3; i >= 0; i--)
+		out.put((length >> (8 * i)) & 0xFF);
+	out.write(reinterpret_cast<const char*>(&bytes[0]), bytes.size());
+	for (int i = 3; i >= 0; i--)
+		out.put((crc >> (8 * i)) & 0xFF);
+}
+
+/**
+ * Creates a directory, if it does not exist yet
+ * @return true if the directory exists, false otherwise
+ */
+static bool makeDir(const string &path)
+{
+#ifdef __linux__
+	int res = mkdir(path.c_str(), 0755);
+#else
+	int res = _mkdir(path.c_str());
+#endif
+	return res == 0 || errno == EEXIST;
+}
+
+/**
+ * Gets the color of a render_color_t as an SVG color
+ */
+static string svgColor(int color)
+{
+	ostringstream ss;
+	ss << "rgb(" << (int) renderPalette[color][0] << "," << (int) renderPalette[color][1] << ","
+			<< (int) renderPalette[color][2] << ")";
+	return ss.str();
+}
+
+/**
+ * Escapes a string for an SVG (XML) file
+ */
+static string svgEscape(const string &s)
+{
+	string res;
+	for (int i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '&')
+			res += "&amp;";
+		else if (s[i] == '<')
+			res += "&lt;";
+		else if (s[i] == '>')
+			res += "&gt;";
+		else if (s[i] == '"')
+			res += "&quot;";
+		else
+			res += s[i];
+	}
+	return res;
+}
+
+Renderer::Renderer(Graph<RoadNode> &graph, const vector<pair<float, float> > &points, int width, int height):
+	graph(graph), points(points), width(max(width, 1)), height(max(height, 1)) {}
+
+LevelOfDetail Renderer::simplify() const
+{
+	vector<bool> pinned(points.size(), false);
+	for (int i = 0; i < markers.size(); i++)
+		pinned.at(markers.at(i).vertex) = true;
+	return LevelOfDetail(graph, points, pinned);
+}
+
+void Renderer::buildGrid(render_layer_t &layer) const
+{
+	const vector<render_segment_t> &segments = layer.segments;
+	layer.cellSize = sqrt(static_cast<float>(width) * height * RENDER_SEGMENTS_PER_CELL / max<size_t>(segments.size(), 1));
+	layer.cellSize = max(layer.cellSize, 1.0f);
+	layer.gridWidth = static_cast<int>(ceil(width / layer.cellSize));
+	layer.gridHeight = static_cast<int>(ceil(height / layer.cellSize));
+
+	//counting sort of the segments by cell (nodes outside of the map fall on the border cells)
+	layer.cellStart.assign(layer.gridWidth * layer.gridHeight + 1, 0);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		vector<int> next;
+		if (pass == 1)
+		{
+			for (int c = 1; c < layer.cellStart.size(); c++)
+				layer.cellStart.at(c) += layer.cellStart.at(c - 1);
+			layer.cellSegments.resize(layer.cellStart.back());
+			next.assign(layer.cellStart.begin(), layer.cellStart.end() - 1);
+		}
+		for (int s = 0; s < segments.size(); s++)
+		{
+			const render_segment_t &seg = segments.at(s);
+			int cx1 = min(max(static_cast<int>(min(seg.x1, seg.x2) / layer.cellSize), 0), layer.gridWidth - 1);
+			int cx2 = min(max(static_cast<int>(max(seg.x1, seg.x2) / layer.cellSize), 0), layer.gridWidth - 1);
+			int cy1 = min(max(static_cast<int>(min(seg.y1, seg.y2) / layer.cellSize), 0), layer.gridHeight - 1);
+			int cy2 = min(max(static_cast<int>(max(seg.y1, seg.y2) / layer.cellSize), 0), layer.gridHeight - 1);
+			for (int cy = cy1; cy <= cy2; cy++)
+				for (int cx = cx1; cx <= cx2; cx++)
+				{
+					if (pass == 0)
+						layer.cellStart.at(cy * layer.gridWidth + cx + 1)++;
+					else
+						layer.cellSegments.at(next.at(cy * layer.gridWidth + cx)++) = s;
+				}
+		}
+	}
+}
+
+void Renderer::addRoute(const vector<RoadNode> &path, int color)
+{
+	render_route_t route;
+	route.color = color;
+	for (int i = 0; i < path.size(); i++)
+	{
+		Vertex<RoadNode>* v = graph.getVertex(path.at(i));
+		if (v != NULL)
+			route.vertices.push_back(v->getIndex());
+	}
+	routes.push_back(route);
+}
+
+void Renderer::addMarker(const RoadNode &node, int color, const string &label)
+{
+	Vertex<RoadNode>* v = graph.getVertex(node);
+	if (v == NULL)
+		return;
+	render_marker_t marker;
+	marker.vertex = v->getIndex();
+	marker.color = color;
+	marker.label = label;
+	markers.push_back(marker);
+}
+
+void Renderer::drawLine(vector<unsigned char> &pixels, float x1, float y1, float x2, float y2, int radius, unsigned char color)
+{
+	//Liang-Barsky clipping to the tile, widened by the radius of the line
+	float lo = -radius, hi = RENDER_TILE_SIZE - 1 + radius;
+	float dx = x2 - x1, dy = y2 - y1, t0 = 0, t1 = 1;
+	float p[] = { -dx, dx, -dy, dy };
+	float q[] = { x1 - lo, hi - x1, y1 - lo, hi - y1 };
+	for (int k = 0; k < 4; k++)
+	{
+		if (p[k] == 0)
+		{
+			if (q[k] < 0)
+				return;
+			continue;
+		}
+		float t = q[k] / p[k];
+		if (p[k] < 0)
+		{
+			if (t > t1)
+				return;
+			t0 = max(t0, t);
+		}
+		else
+		{
+			if (t < t0)
+				return;
+			t1 = min(t1, t);
+		}
+	}
+
+	float ax = x1 + t0 * dx, ay = y1 + t0 * dy, bx = x1 + t1 * dx, by = y1 + t1 * dy;
+	int steps = max(1, static_cast<int>(ceil(max(fabs(bx - ax), fabs(by - ay)))));
+	for (int i = 0; i <= steps; i++)
+	{
+		int x = static_cast<int>(floor(ax + (bx - ax) * i / steps + 0.5f));
+		int y = static_cast<int>(floor(ay + (by - ay) * i / steps + 0.5f));
+		for (int py = max(y - radius, 0); py <= min(y + radius, RENDER_TILE_SIZE - 1); py++)
+			for (int px = max(x - radius, 0); px <= min(x + radius, RENDER_TILE_SIZE - 1); px++)
+				pixels[py * RENDER_TILE_SIZE + px] = color;
+	}
+}
+
+void Renderer::drawDot(vector<unsigned char> &pixels, float x, float y, int radius, unsigned char color)
+{
+	int cx = static_cast<int>(floor(x + 0.5f)), cy = static_cast<int>(floor(y + 0.5f));
+	for (int py = max(cy - radius, 0); py <= min(cy + radius, RENDER_TILE_SIZE - 1); py++)
+		for (int px = max(cx - radius, 0); px <= min(cx + radius, RENDER_TILE_SIZE - 1); px++)
+			if ((px - cx) * (px - cx) + (py - cy) * (py - cy) <= radius * radius + radius)
+				pixels[py * RENDER_TILE_SIZE + px] = color;
+}
+
+void Renderer::renderTile(const render_layer_t &layer, int zoom, int tx, int ty, vector<unsigned char> &pixels,
+		vector<int> &stamps, int &stamp) const
+{
+	float scale = static_cast<float>(RENDER_TILE_SIZE << zoom) / max(width, height);
+	float ox = static_cast<float>(tx) * RENDER_TILE_SIZE, oy = static_cast<float>(ty) * RENDER_TILE_SIZE;
+	fill(pixels.begin(), pixels.end(), RENDER_EMPTY);
+
+	//cells overlapping the tile, widened by the largest radius drawn
+	float margin = (RENDER_MARKER_RADIUS + 1) / scale;
+	float x1 = ox / scale - margin, x2 = (ox + RENDER_TILE_SIZE) / scale + margin;
+	float y1 = oy / scale - margin, y2 = (oy + RENDER_TILE_SIZE) / scale + margin;
+	int cx1 = min(max(static_cast<int>(floor(x1 / layer.cellSize)), 0), layer.gridWidth - 1);
+	int cx2 = min(max(static_cast<int>(floor(x2 / layer.cellSize)), 0), layer.gridWidth - 1);
+	int cy1 = min(max(static_cast<int>(floor(y1 / layer.cellSize)), 0), layer.gridHeight - 1);
+	int cy2 = min(max(static_cast<int>(floor(y2 / layer.cellSize)), 0), layer.gridHeight - 1);
+
+	stamp++;
+	for (int cy = cy1; cy <= cy2; cy++)
+		for (int cx = cx1; cx <= cx2; cx++)
+		{
+			int cell = cy * layer.gridWidth + cx;
+			for (int i = layer.cellStart.at(cell); i < layer.cellStart.at(cell + 1); i++)
+			{
+				int s = layer.cellSegments[i];
+				if (stamps[s] == stamp)
+					continue;
+				stamps[s] = stamp;
+				const render_segment_t &seg = layer.segments[s];
+				drawLine(pixels, seg.x1 * scale - ox, seg.y1 * scale - oy, seg.x2 * scale - ox, seg.y2 * scale - oy, 0, RENDER_ROAD);
+			}
+		}
+
+	for (int r = 0; r < routes.size(); r++)
+	{
+		const vector<int> &vertices = routes.at(r).vertices;
+		for (int i = 1; i < vertices.size(); i++)
+		{
+			const pair<float, float> &a = points.at(vertices.at(i - 1));
+			const pair<float, float> &b = points.at(vertices.at(i));
+			if (max(a.first, b.first) < x1 || min(a.first, b.first) > x2 ||
+				max(a.second, b.second) < y1 || min(a.second, b.second) > y2)
+				continue;
+			drawLine(pixels, a.first * scale - ox, a.second * scale - oy, b.first * scale - ox, b.second * scale - oy,
+					RENDER_ROUTE_RADIUS, routes.at(r).color);
+		}
+	}
+
+	for (int i = 0; i < markers.size(); i++)
+	{
+		const pair<float, float> &p = points.at(markers.at(i).vertex);
+		if (p.first >= x1 && p.first <= x2 && p.second >= y1 && p.second <= y2)
+			drawDot(pixels, p.first * scale - ox, p.second * scale - oy, RENDER_MARKER_RADIUS, markers.at(i).color);
+	}
+}
+
+bool Renderer::writePNG(const string &file, const vector<unsigned char> &pixels)
+{
+	ofstream out(file.c_str(), ios::binary);
+	if (!out.is_open())
+		return false;
+	const unsigned char signature[] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	//8 bit palette, no interlacing
+	vector<unsigned char> header;
+	for (int d = 0; d < 2; d++)
+		for (int i = 3; i >= 0; i--)
+			header.push_back((RENDER_TILE_SIZE >> (8 * i)) & 0xFF);
+	header.push_back(8);
+	header.push_back(3);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writeChunk(out, "IHDR", header);
+
+	vector<unsigned char> palette(&renderPalette[0][0], &renderPalette[0][0] + NUM_RENDER_COLORS * 3);
+	writeChunk(out, "PLTE", palette);
+	writeChunk(out, "tRNS", vector<unsigned char>(1, 0));	//only the background is transparent
+
+	//each row starts with its filter type (none)
+	vector<unsigned char> raw;
+	raw.reserve(RENDER_TILE_SIZE * (RENDER_TILE_SIZE + 1));
+	for (int y = 0; y < RENDER_TILE_SIZE; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), pixels.begin() + y * RENDER_TILE_SIZE, pixels.begin() + (y + 1) * RENDER_TILE_SIZE);
+	}
+	writeChunk(out, "IDAT", deflateRuns(raw));
+	writeChunk(out, "IEND", vector<unsigned char>());
+	return out.good();
+}
+
+bool Renderer::writeSVG(const string &file, const string &background) const
+{
+	ofstream out(file.c_str());
+	if (!out.is_open())
+		return false;
+	out << fixed;
+	out.precision(1);
+	out << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" ";
+	out << "width=\"" << width << "\" height=\"" << height << "\" viewBox=\"0 0 " << width << " " << height << "\">\n";
+	if (background != "")
+		out << "<image xlink:href=\"" << svgEscape(background) << "\" width=\"" << width << "\" height=\"" << height << "\"/>\n";
+
+	//each chain of roads between junctions is a polyline
+	LevelOfDetail lod = simplify();
+	const vector<lod_chain_t> &chains = lod.getChains();
+	const vector<int> &vertices = lod.getChainVertices();
+	out << "<path fill=\"none\" stroke=\"" << svgColor(RENDER_ROAD) << "\" stroke-width=\"1\" d=\"";
+	for (int c = 0; c < chains.size(); c++)
+	{
+		for (int i = 0; i < chains.at(c).count; i++)
+		{
+			const pair<float, float> &p = points.at(vertices.at(chains.at(c).first + i));
+			out << (i == 0 ? "M" : "L") << p.first << " " << p.second;
+		}
+		out << (c % 8 == 7 ? "\n" : "");
+	}
+	out << "\"/>\n";
+
+	for (int r = 0; r < routes.size(); r++)
+	{
+		out << "<polyline fill=\"none\" stroke=\"" << svgColor(routes.at(r).color) << "\" stroke-width=\"";
+		out << 2 * RENDER_ROUTE_RADIUS + 1 << "\" points=\"";
+		for (int i = 0; i < routes.at(r).vertices.size(); i++)
+		{
+			const pair<float, float> &p = points.at(routes.at(r).vertices.at(i));
+			out << (i > 0 ? " " : "") << p.first << "," << p.second;
+		}
+		out << "\"/>\n";
+	}
+
+	for (int i = 0; i < markers.size(); i++)
+	{
+		const pair<float, float> &p = points.at(markers.at(i).vertex);
+		out << "<circle cx=\"" << p.first << "\" cy=\"" << p.second << "\" r=\"" << RENDER_MARKER_RADIUS;
+		out << "\" fill=\"" << svgColor(markers.at(i).color) << "\"><title>" << svgEscape(markers.at(i).label);
+		out << "</title></circle>\n";
+	}
+	out << "</svg>\n";
+	return out.good();
+}
+
+int Renderer::writeTiles(const string &dir, int maxZoom, int threads) const
+{
+	if (!makeDir(dir))
+		return -1;
+	if (threads <= 0)
+		threads = max(1u, thread::hardware_concurrency());
+	LevelOfDetail lod = simplify();
+	int written = 0;
+	for (int z = 0; z <= maxZoom; z++)
+	{
+		//the directories are created beforehand, so the threads only write files
+		vector<pair<int, int> > tiles;
+		ostringstream zoomDir;
+		zoomDir << dir << "/" << z;
+		if (!makeDir(zoomDir.str()))
+			return -1;
+		float scale = static_cast<float>(RENDER_TILE_SIZE << z) / max(width, height);
+		int columns = max(1, static_cast<int>(ceil(width * scale / RENDER_TILE_SIZE)));
+		int rows = max(1, static_cast<int>(ceil(height * scale / RENDER_TILE_SIZE)));
+		for (int x = 0; x < columns; x++)
+		{
+			ostringstream columnDir;
+			columnDir << zoomDir.str() << "/" << x;
+			if (!makeDir(columnDir.str()))
+				return -1;
+			for (int y = 0; y < rows; y++)
+				tiles.push_back(pair<int, int>(x, y));
+		}
+
+		render_layer_t layer;
+		lod_level_t level = lod.getLevel(scale);
+		for (int e = 0; e < level.edges.size(); e++)
+		{
+			for (int i = level.edges.at(e).first + 1; i < level.edges.at(e).first + level.edges.at(e).count; i++)
+			{
+				render_segment_t seg = { level.points.at(i - 1).first, level.points.at(i - 1).second,
+											level.points.at(i).first, level.points.at(i).second };
+				layer.segments.push_back(seg);
+			}
+		}
+		buildGrid(layer);
+
+		atomic<int> next(0);
+		atomic<bool> failed(false);
+		vector<thread> pool;
+		for (int t = 0; t < threads; t++)
+		{
+			pool.push_back(thread([&]() {
+				vector<unsigned char> pixels(RENDER_TILE_SIZE * RENDER_TILE_SIZE);
+				vector<int> stamps(layer.segments.size(), 0);
+				int stamp = 0;
+				for (int i = next++; i < tiles.size(); i = next++)
+				{
+					renderTile(layer, z, tiles.at(i).first, tiles.at(i).second, pixels, stamps, stamp);
+					ostringstream file;
+					file << zoomDir.str() << "/" << tiles.at(i).first << "/" << tiles.at(i).second << ".png";
+					if (!writePNG(file.str(), pixels))
+						failed = true;
+				}
+			}));
+		}
+		for (int t = 0; t < pool.size(); t++)
+			pool.at(t).join();
+		if (failed)
+			return -1;
+		written += tiles.size();
+	}
+	return written;
+}
@@ -0,0 +1,185 @@
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include "LevelOfDetail.h"
+#include <string>
+#include <vector>
+
+#define RENDER_TILE_SIZE 256		//width and height of the PNG tiles (in pixels)
+#define RENDER_SEGMENTS_PER_CELL 4	//average amount of road segments per cell of the culling grid
+
+/**
+ * Colors used by the renderer (the indexes of the palette of the PNG tiles)
+ */
+enum render_color_t
+{
+	RENDER_EMPTY,			/// Transparent background
+	RENDER_ROAD,			/// Roads of the graph
+	RENDER_MARKET,			/// Markets
+	RENDER_CLIENT,			/// Clients
+	RENDER_ROUTE,			/// First color of the routes (the next ones are RENDER_ROUTE + 1, ...)
+	NUM_RENDER_COLORS = RENDER_ROUTE + 6	/// Number of colors
+};
+
+/**
+ * A straight line of a road (in pixels of the map)
+ */
+struct render_segment_t
+{
+	float x1;				/// x coordinate of the start
+	float y1;				/// y coordinate of the start
+	float x2;				/// x coordinate of the end
+	float y2;				/// y coordinate of the end
+};
+
+/**
+ * The roads drawn at a zoom level, with a uniform grid to find the ones that cross a tile
+ */
+struct render_layer_t
+{
+	vector<render_segment_t> segments;	/// straight lines of the roads
+	float cellSize;						/// width and height of the cells of the grid (in pixels of the map)
+	int gridWidth;						/// amount of columns of the grid
+	int gridHeight;						/// amount of rows of the grid
+	vector<int> cellStart;				/// position in cellSegments of the first segment of each cell (plus the end)
+	vector<int> cellSegments;			/// indexes of the segments crossing each cell, cell after cell
+};
+
+/**
+ * A path drawn over the roads
+ */
+struct render_route_t
+{
+	vector<int> vertices;	/// indexes of the vertices of the path
+	int color;				/// color of the path (a render_color_t)
+};
+
+/**
+ * A node highlighted with a dot
+ */
+struct render_marker_t
+{
+	int vertex;				/// index of the vertex
+	int color;				/// color of the dot (a render_color_t)
+	string label;			/// label of the node (only shown in SVG)
+};
+
+/**
+ * Draws a graph, with routes and markers over it, without GraphViewer: as a single SVG picture or as PNG tiles
+ * at several zoom levels (<dir>/<zoom>/<x>/<y>.png, as used by web maps). At zoom level 0 the whole map fits
+ * a single tile, and each level doubles the scale. The roads are simplified for each zoom level (see
+ * LevelOfDetail), with the markers pinned, and kept in a uniform grid, so a tile only draws the segments of
+ * the cells it overlaps. The tiles are drawn by several threads.
+ */
+class Renderer
+{
+private:
+	Graph<RoadNode> &graph;						/// The graph drawn
+	vector<pair<float, float> > points;			/// Position of each vertex on the map (in pixels of the map)
+	int width;									/// Width of the map (in pixels)
+	int height;									/// Height of the map (in pixels)
+	vector<render_route_t> routes;				/// Routes drawn over the roads
+	vector<render_marker_t> markers;			/// Dots drawn over the routes
+
+	/**
+	 * Simplifies the roads, keeping the markers as they are
+	 * @return the simplified graph
+	 */
+	LevelOfDetail simplify() const;
+
+	/**
+	 * Builds the grid of a layer, from its segments
+	 * @param layer the layer
+	 */
+	void buildGrid(render_layer_t &layer) const;
+
+	/**
+	 * Draws a tile
+	 * @param layer roads of the zoom level of the tile
+	 * @param zoom zoom level of the tile
+	 * @param tx column of the tile
+	 * @param ty row of the tile
+	 * @param pixels RENDER_TILE_SIZE * RENDER_TILE_SIZE palette indexes, row after row (overwritten)
+	 * @param stamps a value per segment of the layer, used to draw each segment once (same for all the tiles of a thread)
+	 * @param stamp value not yet used in stamps (incremented)
+	 */
+	void renderTile(const render_layer_t &layer, int zoom, int tx, int ty, vector<unsigned char> &pixels,
+			vector<int> &stamps, int &stamp) const;
+
+	/**
+	 * Draws a line on a tile, clipped to the tile
+	 * @param pixels pixels of the tile
+	 * @param x1 x coordinate of the start (in pixels of the tile)
+	 * @param y1 y coordinate of the start
+	 * @param x2 x coordinate of the end
+	 * @param y2 y coordinate of the end
+	 * @param radius the line is 2 * radius + 1 pixels wide
+	 * @param color palette index of the line
+	 */
+	static void drawLine(vector<unsigned char> &pixels, float x1, float y1, float x2, float y2, int radius, unsigned char color);
+
+	/**
+	 * Draws a filled circle on a tile, clipped to the tile
+	 * @param pixels pixels of the tile
+	 * @param x x coordinate of the center (in pixels of the tile)
+	 * @param y y coordinate of the center
+	 * @param radius radius of the circle (in pixels)
+	 * @param color palette index of the circle
+	 */
+	static void drawDot(vector<unsigned char> &pixels, float x, float y, int radius, unsigned char color);
+
+	/**
+	 * Writes a tile as a PNG with a palette (compressed with run-length deflate)
+	 * @param file name of the file
+	 * @param pixels pixels of the tile
+	 * @return true if the file was written, false otherwise
+	 */
+	static bool writePNG(const string &file, const vector<unsigned char> &pixels);
+
+public:
+	/**
+	 * Creates a renderer for a graph
+	 * @param graph the graph
+	 * @param points position of each vertex on the map (same order as the vertex set, in pixels of the map)
+	 * @param width width of the map (in pixels)
+	 * @param height height of the map (in pixels)
+	 */
+	Renderer(Graph<RoadNode> &graph, const vector<pair<float, float> > &points, int width, int height);
+
+	/**
+	 * Adds a path to be drawn over the roads
+	 * @param path nodes of the path
+	 * @param color color of the path (a render_color_t)
+	 */
+	void addRoute(const vector<RoadNode> &path, int color);
+
+	/**
+	 * Adds a dot to be drawn over the routes
+	 * @param node the node
+	 * @param color color of the dot (a render_color_t)
+	 * @param label label of the node (only shown in SVG)
+	 */
+	void addMarker(const RoadNode &node, int color, const string &label);
+
+	/**
+	 * Writes the whole map as an SVG picture
+	 * @param file name of the file
+	 * @param background path of a picture drawn behind the graph, as seen from the SVG file ("" for none)
+	 * @return true if the file was written, false otherwise
+	 */
+	bool writeSVG(const string &file, const string &background) const;
+
+	/**
+	 * Writes PNG tiles of the map (with transparent background) at the zoom levels 0 to maxZoom,
+	 * as <dir>/<zoom>/<x>/<y>.png
+	 * @param dir directory of the tiles (created if needed)
+	 * @param maxZoom largest zoom level
+	 * @param threads amount of threads drawing the tiles (0 for one per hardware thread)
+	 * @return amount of tiles written, or -1 if a directory or a tile could not be written
+	 */
+	int writeTiles(const string &dir, int maxZoom, int threads) const;
+};
+
+#endif /* RENDERER_H_ */
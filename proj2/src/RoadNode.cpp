@@ -72,10 +72,14 @@ int RoadNode::getDistanceBetween(const RoadNode &n) const
 	return static_cast<int>(d);
 }
 
-RoadNode& RoadNode::operator=(RoadNode n) const
+RoadNode& RoadNode::operator=(const RoadNode &n)
 {
-	RoadNode res(n.id, n.degLat, n.radLat, n.degLong, n.radLong);
-	return res;
+	id = n.id;
+	degLat = n.degLat;
+	radLat = n.radLat;
+	degLong = n.degLong;
+	radLong = n.radLong;
+	return *this;
 }
 
 bool operator==(const RoadNode n1, const RoadNode n2)
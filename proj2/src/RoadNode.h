@@ -2,6 +2,8 @@
 #define ROADNODE_H_
 
 #include <string>
+#include <functional>
+#include "SpeedProfile.h"
 using namespace std;
 
 class RoadNode
@@ -77,10 +79,10 @@ public:
 
 	/**
 	 * Copy assignment operator overload
-	 * @param n RoadNode to copy into
-	 * @return RoadNode equal to the one received as a parameter
+	 * @param n RoadNode to copy from
+	 * @return reference to this RoadNode, now equal to the one received as a parameter
 	 */
-	RoadNode& operator=(RoadNode n) const;
+	RoadNode& operator=(const RoadNode &n);
 };
 
 /**
@@ -107,11 +109,27 @@ bool operator!=(const RoadNode n1, const RoadNode n2);
  */
 ostream& operator<<(ostream &out, const RoadNode n);
 
+namespace std
+{
+	/**
+	 * Hash of a RoadNode, consistent with operator== (both only use the id)
+	 */
+	template <>
+	struct hash<RoadNode>
+	{
+		size_t operator()(const RoadNode &n) const
+		{
+			return hash<long long>()(n.getID());
+		}
+	};
+}
+
 struct road_t
 {
 	string name;		/// road's name
 	long long id;		/// road's id
 	bool twoWay;		/// true if road is a two-way street, false otherwise
+	road_class_t roadClass;	/// class of the road, used to choose its speed profile
 };
 
 #endif /* ROADNODE_H_ */
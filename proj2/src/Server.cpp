@@ -0,0 +1,374 @@
+#include "Server.h"
+
+#ifdef __linux__
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define SERVER_BLOCK 65536				//bytes read from a socket at once
+#define SERVER_MAX_BUFFER 1048576		//unanswered bytes kept for a client before it is disconnected
+#define SERVER_LATENCY_SAMPLES 4096		//latencies kept per type of request for the percentiles
+
+Server::Server(Program &program, int workers): program(program), workers(workers), listener(-1)
+{
+	if (this->workers <= 0)
+		this->workers = max(1u, thread::hardware_concurrency());
+}
+
+bool Server::listenOn(const string &address)
+{
+	bool tcp = !address.empty() && address.find_first_not_of("0123456789") == string::npos;
+	if (tcp)
+	{
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(atoi(address.c_str()));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		listener = socket(AF_INET, SOCK_STREAM, 0);
+		int yes = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		if (listener < 0 || bind(listener, (sockaddr*) &addr, sizeof(addr)) < 0)
+		{
+			cout << "Could not bind to port " << address << ": " << strerror(errno) << endl;
+			return false;
+		}
+	}
+	else
+	{
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (address.size() >= sizeof(addr.sun_path))
+		{
+			cout << "Socket path " << address << " is too long\n";
+			return false;
+		}
+		strcpy(addr.sun_path, address.c_str());
+		unlink(address.c_str());
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0 || bind(listener, (sockaddr*) &addr, sizeof(addr)) < 0)
+		{
+			cout << "Could not bind to " << address << ": " << strerror(errno) << endl;
+			return false;
+		}
+	}
+	if (listen(listener, SOMAXCONN) < 0)
+	{
+		cout << "Could not listen on " << address << ": " << strerror(errno) << endl;
+		return false;
+	}
+	return true;
+}
+
+bool Server::run(const string &address)
+{
+	if (!listenOn(address) || pipe(wakeup) < 0)
+		return false;
+
+	//the weights do not change from now on, so the workers can share the trees of the cache and the labels
+	program.updateMarketTrees();
+	if (program.prepareHubLabels())
+		cout << "Hub labels: " << program.getHubLabels().getBytes() / 1024 << " KB, " <<
+				program.getHubLabels().getAverageLabelSize() << " hubs per label" <<
+				(program.getHubLabels().isMapped() ? " (mapped)" : "") << endl;
+	else
+		cout << "No hub labels (they do not fit in memory, turn rules were loaded or the weights are time-dependent), " <<
+				"distances are computed with shortest path trees" << endl;
+	for (int i = 0; i < workers; i++)
+		thread(&Server::work, this).detach();
+	cout << "Listening on " << address << " with " << workers << " workers" << endl;
+
+	map<int, string> buffers;	//unanswered data of each client
+	map<int, bool> busy;		//true for the clients whose requests are being answered
+	char block[SERVER_BLOCK];
+	while (true)
+	{
+		//clients being answered are not polled, so the requests of a client are answered in order
+		vector<pollfd> fds(2);
+		fds[0].fd = listener;
+		fds[1].fd = wakeup[0];
+		for (map<int, string>::iterator it = buffers.begin(); it != buffers.end(); it++)
+		{
+			if (!busy[it->first])
+			{
+				fds.push_back(pollfd());
+				fds.back().fd = it->first;
+			}
+		}
+		for (int i = 0; i < fds.size(); i++)
+		{
+			fds.at(i).events = POLLIN;
+			fds.at(i).revents = 0;
+		}
+		if (poll(&fds[0], fds.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cout << "poll() failed: " << strerror(errno) << endl;
+			return false;
+		}
+
+		if (fds.at(0).revents & POLLIN)
+		{
+			int sock = accept(listener, NULL, NULL);
+			if (sock >= 0)
+			{
+				buffers[sock] = "";
+				busy[sock] = false;
+			}
+		}
+		if (fds.at(1).revents & POLLIN)
+		{
+			//a worker answered a client (a negative value means the client asked to quit)
+			int msg;
+			if (read(wakeup[0], &msg, sizeof(msg)) == sizeof(msg))
+			{
+				int sock = (msg < 0 ? -msg - 1 : msg);
+				busy[sock] = false;
+				if (msg < 0)
+				{
+					close(sock);
+					buffers.erase(sock);
+					busy.erase(sock);
+				}
+				else
+					busy[sock] = dispatch(sock, buffers[sock]);
+			}
+		}
+		for (int i = 2; i < fds.size(); i++)
+		{
+			if (fds.at(i).revents == 0)
+				continue;
+			int sock = fds.at(i).fd;
+			int n = recv(sock, block, SERVER_BLOCK, 0);
+			if (n <= 0 || buffers[sock].size() + n > SERVER_MAX_BUFFER)
+			{
+				close(sock);
+				buffers.erase(sock);
+				busy.erase(sock);
+				continue;
+			}
+			buffers[sock].append(block, n);
+			busy[sock] = dispatch(sock, buffers[sock]);
+		}
+	}
+}
+
+bool Server::dispatch(int sock, string &buffer)
+{
+	size_t end = buffer.rfind('\n');
+	if (end == string::npos)
+		return false;
+
+	server_job_t job;
+	job.sock = sock;
+	job.received = chrono::steady_clock::now();
+	istringstream ss(buffer.substr(0, end));
+	string line;
+	while (getline(ss, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		job.lines.push_back(line);
+	}
+	buffer.erase(0, end + 1);
+
+	unique_lock<mutex> lock(jobsMutex);
+	jobs.push_back(job);
+	jobsReady.notify_one();
+	return true;
+}
+
+void Server::work()
+{
+	plan_scratch_t scratch;		//buffers of the route planner, kept by each worker
+	while (true)
+	{
+		server_job_t job;
+		{
+			unique_lock<mutex> lock(jobsMutex);
+			while (jobs.empty())
+				jobsReady.wait(lock);
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		string reply;
+		bool quit = false;
+		for (int i = 0; i < job.lines.size() && !quit; i++)
+		{
+			reply += answer(job.lines.at(i), quit, scratch);
+			istringstream ss(job.lines.at(i));
+			string request;
+			ss >> request;
+			record(request, chrono::duration<double, micro>(chrono::steady_clock::now() - job.received).count());
+		}
+
+		for (int sent = 0; sent < reply.size(); )
+		{
+			int n = send(job.sock, reply.c_str() + sent, reply.size() - sent, MSG_NOSIGNAL);
+			if (n <= 0)
+			{
+				quit = true;
+				break;
+			}
+			sent += n;
+		}
+		int msg = (quit ? -job.sock - 1 : job.sock);
+		write(wakeup[1], &msg, sizeof(msg));
+	}
+}
+
+string Server::answer(const string &line, bool &quit, plan_scratch_t &scratch)
+{
+	Graph<RoadNode> &graph = program.getGraph();
+	istringstream ss(line);
+	ostringstream reply;
+	string request;
+	ss >> request;
+
+	vector<Vertex<RoadNode>* > nodes;
+	long long id;
+	while (ss >> id)
+	{
+		nodes.push_back(graph.getVertex(RoadNode(id, 0, 0, 0, 0)));
+		if (nodes.back() == NULL)
+		{
+			reply << "error unknown node " << id << "\n";
+			return reply.str();
+		}
+	}
+
+	if (request == "route" && nodes.size() == 2)
+	{
+		shared_ptr<const sp_tree_t> tree = program.getTree(nodes.at(0)->getInfo());
+		truck_route_t route = program.getRoute(*tree, nodes.at(1)->getInfo());
+		if (route.path.empty())
+			reply << "error unreachable\n";
+		else
+		{
+			reply << "ok " << static_cast<long long>(tree->dist.at(nodes.at(1)->getIndex()) + 0.5) << " ";
+			reply << route.length << " " << route.time;
+			for (int i = 0; i < route.path.size(); i++)
+				reply << " " << route.path.at(i).getID();
+			reply << "\n";
+		}
+	}
+	else if (request == "distance" && nodes.size() == 2)
+	{
+		double d;
+		if (!program.getHubLabels().empty())
+			d = program.getHubLabels().distance(nodes.at(0)->getIndex(), nodes.at(1)->getIndex());
+		else
+			d = program.getTree(nodes.at(0)->getInfo())->dist.at(nodes.at(1)->getIndex());
+		if (d >= INT_INFINITY)
+			reply << "error unreachable\n";
+		else
+			reply << "ok " << static_cast<long long>(d + 0.5) << "\n";
+	}
+	else if (request == "nearest" && nodes.size() == 1)
+	{
+		const vector<RoadNode> &markets = program.getMarkets();
+		int best = -1;
+		double bestDist = INT_INFINITY;
+		for (int i = 0; i < markets.size(); i++)
+		{
+			double d = program.getTree(markets.at(i))->dist.at(nodes.at(0)->getIndex());
+			if (d < bestDist)
+			{
+				best = i;
+				bestDist = d;
+			}
+		}
+		if (best == -1)
+			reply << "error unreachable\n";
+		else
+			reply << "ok " << markets.at(best).getID() << " " << static_cast<long long>(bestDist + 0.5) << "\n";
+	}
+	else if (request == "plan" && nodes.size() >= 1)
+	{
+		int market = program.getIndexOfMarket(nodes.at(0)->getInfo());
+		if (market == -1)
+			reply << "error " << nodes.at(0)->getInfo().getID() << " is not a market\n";
+		else
+		{
+			vector<RoadNode> clients;
+			for (int i = 1; i < nodes.size(); i++)
+				clients.push_back(nodes.at(i)->getInfo());
+			vector<truck_route_t> routes;
+			program.planMarketRoutes(market, clients, routes, scratch);
+			reply << "ok " << routes.size() << "\n";
+			for (int i = 0; i < routes.size(); i++)
+			{
+				reply << routes.at(i).served << " " << routes.at(i).length << " " << routes.at(i).time;
+				for (int j = 0; j < routes.at(i).path.size(); j++)
+					reply << " " << routes.at(i).path.at(j).getID();
+				reply << "\n";
+			}
+		}
+	}
+	else if (request == "stats" && nodes.empty())
+		reply << getStats();
+	else if (request == "quit" && nodes.empty())
+	{
+		reply << "ok\n";
+		quit = true;
+	}
+	else
+		reply << "error invalid request\n";
+	return reply.str();
+}
+
+void Server::record(const string &request, double latency)
+{
+	unique_lock<mutex> lock(statsMutex);
+	//unknown requests are grouped, so clients cannot make the statistics grow without bound
+	string type = (request == "route" || request == "distance" || request == "nearest" || request == "plan" || request == "stats" ||
+					request == "quit" ? request : "invalid");
+	map<string, request_stats_t>::iterator it = stats.find(type);
+	if (it == stats.end())
+	{
+		request_stats_t s;
+		s.count = 0;
+		s.total = 0;
+		s.max = 0;
+		it = stats.insert(pair<string, request_stats_t>(type, s)).first;
+	}
+	request_stats_t &s = it->second;
+	if (s.recent.size() < SERVER_LATENCY_SAMPLES)
+		s.recent.push_back(latency);
+	else
+		s.recent.at(s.count % SERVER_LATENCY_SAMPLES) = latency;
+	s.count++;
+	s.total += latency;
+	s.max = max(s.max, latency);
+}
+
+string Server::getStats()
+{
+	unique_lock<mutex> lock(statsMutex);
+	ostringstream reply;
+	reply << "ok " << stats.size() << "\n";
+	reply.setf(ios::fixed);
+	reply.precision(1);
+	for (map<string, request_stats_t>::iterator it = stats.begin(); it != stats.end(); it++)
+	{
+		vector<double> sorted = it->second.recent;
+		sort(sorted.begin(), sorted.end());
+		reply << it->first << " " << it->second.count << " " << it->second.total / it->second.count << " ";
+		reply << sorted.at(sorted.size() / 2) << " " << sorted.at(min(sorted.size() - 1, sorted.size() * 99 / 100)) << " ";
+		reply << it->second.max << "\n";
+	}
+	return reply.str();
+}
+
+#endif /* __linux__ */
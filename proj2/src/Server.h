@@ -0,0 +1,126 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include "Program.h"
+
+#ifdef __linux__
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Latency statistics of a type of request (all times in microseconds)
+ */
+struct request_stats_t
+{
+	long long count;		/// amount of requests answered
+	double total;			/// sum of the latencies of all requests
+	double max;				/// largest latency
+	vector<double> recent;	/// latencies of the last requests, used for percentiles (circular buffer)
+};
+
+/**
+ * Requests received together from a client, which are answered together by a worker
+ */
+struct server_job_t
+{
+	int sock;									/// socket of the client
+	vector<string> lines;						/// the requests, without line breaks
+	chrono::steady_clock::time_point received;	/// when the requests were read from the socket
+};
+
+/**
+ * Routing service that loads the graph once and answers requests from many clients, over localhost TCP
+ * or a Unix domain socket. Like the GraphViewer protocol (see connection.cpp), each request is a line with a
+ * command and its arguments, and each reply starts with a line "ok ..." or "error <reason>":
+ *   route <from> <to>            ok <weight> <length> <time> <node> <node> ...
+ *   nearest <node>               ok <market node> <weight>
+ *   distance <from> <to>         ok <weight>
+ *   plan <market> <node> ...     ok <n>, followed by n lines <clients> <length> <time> <node> <node> ...
+ *   stats                        ok <n>, followed by n lines <request> <count> <mean> <p50> <p99> <max> (us)
+ *   quit                         ok, and the connection is closed
+ * Weights use the routing metric of the program, lengths are in meters and times in minutes.
+ * The requests read at once from a client are answered by a single worker with a single reply, so
+ * clients may pipeline them. The shortest path trees are kept in the cache of the program (see Program::getTree),
+ * so route requests from a node that was asked for recently, by any client, do not compute a tree again.
+ * Distance requests are answered by the hub labels of the program (see HubLabels), which are mapped from their
+ * file when the server starts, or built and written to it; if they do not fit in memory, a tree is used instead.
+ */
+class Server
+{
+private:
+	Program &program;						/// The program whose graph, markets and parameters are used
+	int workers;							/// Amount of worker threads
+	int listener;							/// Socket accepting the connections
+	int wakeup[2];							/// Pipe used by the workers to hand the clients back to the main loop
+	deque<server_job_t> jobs;				/// Requests waiting for a worker
+	mutex jobsMutex;						/// Protects Server::jobs
+	condition_variable jobsReady;			/// Signalled when a job is queued
+	map<string, request_stats_t> stats;		/// Latency statistics of each type of request
+	mutex statsMutex;						/// Protects Server::stats
+
+	/**
+	 * Creates the listening socket
+	 * @param address a port (localhost TCP) or the path of a Unix domain socket
+	 * @return true if the socket is listening, false otherwise (after printing the reason)
+	 */
+	bool listenOn(const string &address);
+
+	/**
+	 * Takes the complete lines out of the buffer of a client and queues them as a job
+	 * @param sock socket of the client
+	 * @param buffer data received from the client and not yet answered
+	 * @return true if a job was queued, false if there are no complete lines
+	 */
+	bool dispatch(int sock, string &buffer);
+
+	/**
+	 * Loop of a worker thread, answering the queued jobs
+	 */
+	void work();
+
+	/**
+	 * Answers a single request
+	 * @param line the request
+	 * @param quit set to true if the client asked to close the connection
+	 * @param scratch buffers of the route planner of the worker
+	 * @return the reply, with its line breaks
+	 */
+	string answer(const string &line, bool &quit, plan_scratch_t &scratch);
+
+	/**
+	 * Adds the latency of a request to the statistics
+	 * @param request type of the request
+	 * @param latency time since the request was received (in microseconds)
+	 */
+	void record(const string &request, double latency);
+
+	/**
+	 * Gets the reply to a stats request
+	 * @return the reply, with its line breaks
+	 */
+	string getStats();
+
+public:
+	/**
+	 * Creates a server
+	 * @param program program already loaded, which must not be used by anything else while the server runs
+	 * @param workers amount of worker threads (0 for one per hardware thread)
+	 */
+	Server(Program &program, int workers);
+
+	/**
+	 * Answers requests until the process is terminated
+	 * @param address a port (localhost TCP) or the path of a Unix domain socket
+	 * @return false if the server could not start
+	 */
+	bool run(const string &address);
+};
+
+#endif /* __linux__ */
+
+#endif /* SERVER_H_ */
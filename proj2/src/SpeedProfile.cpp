@@ -0,0 +1,97 @@
+#include "SpeedProfile.h"
+#include <algorithm>
+#include <cmath>
+
+SpeedProfile::SpeedProfile(){}
+
+SpeedProfile::SpeedProfile(float speed)
+{
+	addPoint(0, speed);
+}
+
+void SpeedProfile::addPoint(int time, float speed)
+{
+	pair<int, float> p(time % SECONDS_PER_DAY, 3.6 / speed);
+	vector<pair<int, float> >::iterator it = lower_bound(points.begin(), points.end(), p);
+	if (it != points.end() && it->first == p.first)
+		it->second = p.second;
+	else
+		points.insert(it, p);
+}
+
+float SpeedProfile::getSpeed(double time) const
+{
+	if (points.empty())
+		return 0;
+
+	double t = fmod(time, SECONDS_PER_DAY);
+	if (t < 0)
+		t += SECONDS_PER_DAY;
+
+	//find the breakpoints before and after t, wrapping around midnight
+	int i = upper_bound(points.begin(), points.end(), pair<int, float>(static_cast<int>(t), 1e30)) - points.begin();
+	const pair<int, float> &before = (i == 0 ? points.back() : points.at(i - 1));
+	const pair<int, float> &after = (i == points.size() ? points.front() : points.at(i));
+
+	double span = after.first - before.first;
+	double elapsed = t - before.first;
+	if (span <= 0)
+		span += SECONDS_PER_DAY;
+	if (elapsed < 0)
+		elapsed += SECONDS_PER_DAY;
+
+	double pace = before.second;
+	if (span > 0 && before.first != after.first)
+		pace += (after.second - before.second) * elapsed / span;
+	return static_cast<float>(3.6 / pace);
+}
+
+float SpeedProfile::getFreeFlowSpeed() const
+{
+	float res = 0;
+	for (int i = 0; i < points.size(); i++)
+		res = max(res, static_cast<float>(3.6 / points.at(i).second));
+	return res;
+}
+
+double SpeedProfile::getTravelTime(double length, double departure) const
+{
+	if (points.empty())
+		return 0;
+	return length * 3.6 / getSpeed(departure);
+}
+
+road_class_t classifyRoad(const string &name)
+{
+	string first = name.substr(0, name.find(' '));
+
+	if (first == "Autoestrada" || first == "Via" || first == "Radial" ||
+		first == "Tunel" || first == "Viaduto")
+		return MOTORWAY;
+	if (first == "Avenida" || first == "Estrada" || first == "Alameda" ||
+		first == "Rotunda" || first == "Acesso")
+		return ARTERIAL;
+	return LOCAL;
+}
+
+vector<SpeedProfile> getDefaultSpeedProfiles()
+{
+	//free-flow speed and rush hour speed (in Km/h) for each road class
+	float freeFlow[NUM_ROAD_CLASSES] = { 90, 50, 30 };
+	float rushHour[NUM_ROAD_CLASSES] = { 40, 20, 15 };
+
+	vector<SpeedProfile> res;
+	for (int i = 0; i < NUM_ROAD_CLASSES; i++)
+	{
+		SpeedProfile p;
+		p.addPoint(0, freeFlow[i]);
+		p.addPoint(6 * 3600, freeFlow[i]);
+		p.addPoint(8 * 3600 + 1800, rushHour[i]);		//morning rush hour peaks at 8:30
+		p.addPoint(10 * 3600, freeFlow[i] * 0.8);
+		p.addPoint(16 * 3600, freeFlow[i] * 0.8);
+		p.addPoint(18 * 3600 + 1800, rushHour[i]);		//evening rush hour peaks at 18:30
+		p.addPoint(21 * 3600, freeFlow[i]);
+		res.push_back(p);
+	}
+	return res;
+}
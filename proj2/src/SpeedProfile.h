@@ -0,0 +1,88 @@
+#ifndef SPEEDPROFILE_H_
+#define SPEEDPROFILE_H_
+
+#include <vector>
+#include <string>
+#include <utility>
+using namespace std;
+
+#define SECONDS_PER_DAY 86400
+
+/**
+ * Categories of roads, each one with its own speed profile
+ */
+enum road_class_t
+{
+	MOTORWAY,			/// Motorways, radials, tunnels and viaducts
+	ARTERIAL,			/// Avenues, main roads and roundabouts
+	LOCAL,				/// Streets, alleys, squares and unnamed roads
+	NUM_ROAD_CLASSES	/// Number of road classes
+};
+
+/**
+ * Describes how the travel time of a road varies along the day.
+ * The profile is given by a set of breakpoints (time of the day, speed) and the
+ * pace (the inverse of the speed) is linearly interpolated between them, so the
+ * travel time of an edge of length l departing at t is l * pace(t), a piecewise-linear
+ * function of t. A single profile is meant to be shared by every edge of the same road class.
+ */
+class SpeedProfile
+{
+private:
+	vector<pair<int, float> > points;	/// Breakpoints (second of the day, pace in s/m), sorted by time
+public:
+	/**
+	 * Creates an empty profile (every road is travelled instantly until a breakpoint is added)
+	 */
+	SpeedProfile();
+
+	/**
+	 * Creates a profile with a constant speed along the whole day
+	 * @param speed speed in Km/h
+	 */
+	SpeedProfile(float speed);
+
+	/**
+	 * Adds a breakpoint to the profile, keeping the breakpoints sorted by time
+	 * @param time second of the day of the breakpoint
+	 * @param speed speed at that time in Km/h
+	 */
+	void addPoint(int time, float speed);
+
+	/**
+	 * Gets the speed at a certain time, wrapping around midnight
+	 * @param time time in seconds (may be larger than a day)
+	 * @return the interpolated speed in Km/h
+	 */
+	float getSpeed(double time) const;
+
+	/**
+	 * Gets the highest speed of the profile (the free-flow speed)
+	 * @return speed in Km/h
+	 */
+	float getFreeFlowSpeed() const;
+
+	/**
+	 * Calculates the time needed to travel a certain length
+	 * @param length the length to travel in meters
+	 * @param departure time of departure in seconds
+	 * @return travel time in seconds
+	 */
+	double getTravelTime(double length, double departure) const;
+};
+
+/**
+ * Determines the class of a road based on its name
+ * @param name the name of the road
+ * @return the class of the road
+ */
+road_class_t classifyRoad(const string &name);
+
+/**
+ * Builds the default speed profiles for the city, one per road class
+ * (indexed by road_class_t), with morning and evening rush hours
+ * @return vector with NUM_ROAD_CLASSES profiles
+ */
+vector<SpeedProfile> getDefaultSpeedProfiles();
+
+#endif /* SPEEDPROFILE_H_ */
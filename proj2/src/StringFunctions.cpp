@@ -1,4 +1,49 @@
 #include "StringFunctions.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define GRAM_SIZE 3
+
+/**
+ * Tables to fold the case of a character (or leave it unchanged) with a single lookup,
+ * built once at start-up so they can be shared by concurrent searches
+ */
+static const struct fold_tables_t
+{
+	unsigned char identity[256];
+	unsigned char lower[256];
+
+	fold_tables_t()
+	{
+		for (int c = 0; c < 256; c++)
+		{
+			identity[c] = c;
+			lower[c] = tolower(c);
+		}
+	}
+} foldTables;
+
+/**
+ * Converts a string to lower case
+ * @param s the string
+ * @return the string in lower case
+ */
+static string toLower(const string &s)
+{
+	string res(s);
+	for (unsigned int i = 0; i < res.size(); i++)
+		res[i] = foldTables.lower[static_cast<unsigned char>(res[i])];
+	return res;
+}
 
 ApproxString::ApproxString(string s, int closeness): s(s), closeness(closeness){};
 
@@ -24,6 +69,36 @@ void trim(string &s)
 	s.erase(s.find_last_not_of(' ') + 1);
 }
 
+string escapeJSON(const string &s)
+{
+	static const char hex[] = "0123456789abcdef";
+	string res;
+	for (int i = 0; i < s.size(); i++)
+	{
+		unsigned char c = s[i];
+		if (c == '"' || c == '\\')
+		{
+			res += '\\';
+			res += c;
+		}
+		else if (c == '\n')
+			res += "\\n";
+		else if (c == '\r')
+			res += "\\r";
+		else if (c == '\t')
+			res += "\\t";
+		else if (c < 0x20)
+		{
+			res += "\\u00";
+			res += hex[c >> 4];
+			res += hex[c & 0xF];
+		}
+		else
+			res += c;
+	}
+	return res;
+}
+
 string kmpStringMatching(string &text, string pattern, bool caseSensitive)
 {
 	int size;
@@ -35,7 +110,7 @@ string kmpStringMatching(string &text, string pattern, bool caseSensitive)
 		size=pattern.size();
 	}
 
-	int t[size];
+	vector<int> t(size);
 
 	t[0]=-1;
 	t[1]=0;
@@ -111,7 +186,124 @@ priority_queue<ApproxString> approximateStringMatching(vector<string> &text, str
 	return res;
 }
 
+/**
+ * Compares a candidate occurrence of a pattern with the pattern itself
+ * @param s the candidate occurrence in the text
+ * @param p the pattern, already in lower case if the comparison ignores case
+ * @param m the size of the pattern
+ * @param caseSensitive true to consider case sensitiveness, false to not consider
+ * @return true if the candidate is an occurrence of the pattern
+ */
+static inline bool verifyCandidate(const char* s, const char* p, int m, bool caseSensitive)
+{
+	if (caseSensitive)
+		return memcmp(s, p, m) == 0;
+	for (int i = 0; i < m; i++)
+		if (foldTables.lower[static_cast<unsigned char>(s[i])] != static_cast<unsigned char>(p[i]))
+			return false;
+	return true;
+}
+
+/**
+ * Finds the first occurrence of a pattern in a text. Only the positions whose first and last characters
+ * match the ones of the pattern (in any case, if the comparison ignores case) are compared in full, and
+ * those positions are found 32 (AVX2) or 16 (SSE2) at a time when vector instructions are available
+ * @param s the text
+ * @param n the size of the text
+ * @param p the pattern, already in lower case if the comparison ignores case
+ * @param m the size of the pattern (at least one character)
+ * @param caseSensitive true to consider case sensitiveness, false to not consider
+ * @return position of the first occurrence, or -1 if there is none
+ */
+static int findFirstOccurrence(const char* s, int n, const char* p, int m, bool caseSensitive)
+{
+	char first1 = p[0], first2 = caseSensitive ? p[0] : toupper(static_cast<unsigned char>(p[0]));
+	char last1 = p[m - 1], last2 = caseSensitive ? p[m - 1] : toupper(static_cast<unsigned char>(p[m - 1]));
+	int lastPosition = n - m;
+	int i = 0;
+
+#ifdef __AVX2__
+	__m256i f1 = _mm256_set1_epi8(first1), f2 = _mm256_set1_epi8(first2);
+	__m256i l1 = _mm256_set1_epi8(last1), l2 = _mm256_set1_epi8(last2);
+	for (; i + 31 <= lastPosition; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + m - 1));
+		__m256i matchFirst = _mm256_or_si256(_mm256_cmpeq_epi8(a, f1), _mm256_cmpeq_epi8(a, f2));
+		__m256i matchLast = _mm256_or_si256(_mm256_cmpeq_epi8(b, l1), _mm256_cmpeq_epi8(b, l2));
+		uint32_t candidates = _mm256_movemask_epi8(_mm256_and_si256(matchFirst, matchLast));
+		while (candidates != 0)
+		{
+			int pos = i + __builtin_ctz(candidates);
+			if (verifyCandidate(s + pos, p, m, caseSensitive))
+				return pos;
+			candidates &= candidates - 1;
+		}
+	}
+#elif defined(__SSE2__)
+	__m128i f1 = _mm_set1_epi8(first1), f2 = _mm_set1_epi8(first2);
+	__m128i l1 = _mm_set1_epi8(last1), l2 = _mm_set1_epi8(last2);
+	for (; i + 15 <= lastPosition; i += 16)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+		__m128i matchFirst = _mm_or_si128(_mm_cmpeq_epi8(a, f1), _mm_cmpeq_epi8(a, f2));
+		__m128i matchLast = _mm_or_si128(_mm_cmpeq_epi8(b, l1), _mm_cmpeq_epi8(b, l2));
+		uint32_t candidates = _mm_movemask_epi8(_mm_and_si128(matchFirst, matchLast));
+		while (candidates != 0)
+		{
+			int pos = i + __builtin_ctz(candidates);
+			if (verifyCandidate(s + pos, p, m, caseSensitive))
+				return pos;
+			candidates &= candidates - 1;
+		}
+	}
+#else
+	//without vector instructions, memchr skips quickly to the next occurrence of the first character
+	if (caseSensitive)
+	{
+		while (i <= lastPosition)
+		{
+			const char* c = static_cast<const char*>(memchr(s + i, first1, lastPosition - i + 1));
+			if (c == NULL)
+				return -1;
+			i = c - s;
+			if (s[i + m - 1] == last1 && verifyCandidate(s + i, p, m, true))
+				return i;
+			i++;
+		}
+		return -1;
+	}
+#endif
+
+	for (; i <= lastPosition; i++)
+		if ((s[i] == first1 || s[i] == first2) && (s[i + m - 1] == last1 || s[i + m - 1] == last2) &&
+			verifyCandidate(s + i, p, m, caseSensitive))
+			return i;
+	return -1;
+}
+
+string exactStringMatching(const string &text, const string &pattern, bool caseSensitive)
+{
+	int n = text.size(), m = pattern.size();
+	if (m == 0 || m > n)
+		return "";
+
+	string p = caseSensitive ? pattern : toLower(pattern);
+	int pos = findFirstOccurrence(text.data(), n, p.data(), m, caseSensitive);
+
+	//as in kmpStringMatching, only the first occurrence counts and it must end a name (followed by two spaces)
+	if (pos == -1 || pos + m + 1 >= n || text[pos + m] != ' ' || text[pos + m + 1] != ' ')
+		return "";
+	return text.substr(pos, m);
+}
+
 int levenshtein_distance(const string &t, const string &p, bool caseSensitive)
+{
+	return levenshtein_distance(t, p, caseSensitive, INT_MAX - 1);
+}
+
+int levenshtein_distance_dp(const string &t, const string &p, bool caseSensitive)
 {
 	int textSize = t.size(), patternSize = p.size();
 	int last_diagonal, old_diagonal, substitutionCost;
@@ -119,7 +311,7 @@ int levenshtein_distance(const string &t, const string &p, bool caseSensitive)
 
 
 	int* d = new int[textSize + 1];
-	iota(d + 1, d + textSize + 1, 1);
+	iota(d, d + textSize + 1, 0);
 
 	for (int i = 1; i <= patternSize; i++) {
 		d[0] = i;
@@ -145,5 +337,570 @@ int levenshtein_distance(const string &t, const string &p, bool caseSensitive)
 	return result;
 }
 
+/**
+ * Advances one column of a block of 64 rows of the bit-parallel algorithm by Myers,
+ * in the variant by Hyyro for the edit distance
+ * @param Pv bit-vector of the positive vertical deltas of the block (updated)
+ * @param Mv bit-vector of the negative vertical deltas of the block (updated)
+ * @param Eq bit-vector of the rows whose character matches the current column
+ * @param hin horizontal delta entering the block from the row above (-1, 0 or 1)
+ * @param high the bit of the row whose horizontal delta is returned
+ * @return the horizontal delta leaving the block at the row of the high bit
+ */
+static inline int advanceBlock(uint64_t &Pv, uint64_t &Mv, uint64_t Eq, int hin, uint64_t high)
+{
+	uint64_t hinNeg = (hin < 0 ? 1 : 0);
+	uint64_t Xv = Eq | Mv;
+	Eq |= hinNeg;
+	uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+	uint64_t Ph = Mv | ~(Xh | Pv);
+	uint64_t Mh = Pv & Xh;
+
+	int hout = 0;
+	if (Ph & high)
+		hout = 1;
+	else if (Mh & high)
+		hout = -1;
+
+	Ph = (Ph << 1) | (hin > 0 ? 1 : 0);
+	Mh = (Mh << 1) | hinNeg;
+	Pv = Mh | ~(Xv | Ph);
+	Mv = Ph & Xv;
+	return hout;
+}
+
+int levenshtein_distance(const string &t, const string &p, bool caseSensitive, int maxDistance)
+{
+	//the bit-vectors are built over the shortest string, since the distance is symmetric
+	const string &text = (t.size() >= p.size() ? t : p);
+	const string &pattern = (t.size() >= p.size() ? p : t);
+	int n = text.size(), m = pattern.size();
+
+	if (n - m > maxDistance)
+		return maxDistance + 1;
+	if (m == 0)
+		return n;
+
+	//case is folded once for each character of the pattern, when building its bit-vectors,
+	//and once for each character of the text
+	const unsigned char* fold = (caseSensitive ? foldTables.identity : foldTables.lower);
+
+	if (m <= 64)
+	{
+		//single block: the bit-vectors live on the stack and only the entries of the characters
+		//present in the pattern (marked in a 256 bit mask) are initialized
+		uint64_t peq[256], present[4] = { 0, 0, 0, 0 };
+		for (int i = 0; i < m; i++)
+		{
+			unsigned char c = fold[static_cast<unsigned char>(pattern[i])];
+			if (!(present[c >> 6] & (1ULL << (c & 63))))
+			{
+				present[c >> 6] |= 1ULL << (c & 63);
+				peq[c] = 0;
+			}
+			peq[c] |= 1ULL << i;
+		}
+
+		uint64_t Pv = ~0ULL, Mv = 0, high = 1ULL << (m - 1);
+		int score = m;
+		for (int j = 0; j < n; j++)
+		{
+			unsigned char c = fold[static_cast<unsigned char>(text[j])];
+			uint64_t Eq = (present[c >> 6] & (1ULL << (c & 63))) ? peq[c] : 0;
+			score += advanceBlock(Pv, Mv, Eq, 1, high);
+			if (score - (n - j - 1) > maxDistance)
+				return maxDistance + 1;
+		}
+		return min(score, maxDistance + 1);
+	}
+
+	int blocks = (m + 63) / 64;
+	uint64_t high = 1ULL << ((m - 1) % 64);
+	vector<uint64_t> peq(256 * blocks, 0);
+	for (int i = 0; i < m; i++)
+		peq[fold[static_cast<unsigned char>(pattern[i])] * blocks + i / 64] |= 1ULL << (i % 64);
+
+	vector<uint64_t> Pv(blocks, ~0ULL), Mv(blocks, 0);
+	int score = m;
+	for (int j = 0; j < n; j++)
+	{
+		const uint64_t* eq = &peq[fold[static_cast<unsigned char>(text[j])] * blocks];
+		int h = 1;
+		for (int b = 0; b < blocks; b++)
+			h = advanceBlock(Pv[b], Mv[b], eq[b], h, b == blocks - 1 ? high : 1ULL << 63);
+		score += h;
+
+		//the last row changes by at most one per column, so the final distance is at least this
+		if (score - (n - j - 1) > maxDistance)
+			return maxDistance + 1;
+	}
+	return min(score, maxDistance + 1);
+}
+
+/**
+ * Gets the distinct trigrams of a string, folded to lower case and padded
+ * at both ends so that short strings still have trigrams
+ * @param s the string
+ * @return sorted vector with the distinct trigrams, each one packed in an integer
+ */
+static vector<unsigned int> getGrams(const string &s)
+{
+	string padded(GRAM_SIZE - 1, '\1');
+	for (unsigned int i = 0; i < s.size(); i++)
+		padded += tolower(s[i]);
+	padded.append(GRAM_SIZE - 1, '\1');
+
+	vector<unsigned int> res;
+	for (unsigned int i = 0; i + GRAM_SIZE <= padded.size(); i++)
+	{
+		unsigned int g = 0;
+		for (int j = 0; j < GRAM_SIZE; j++)
+			g = (g << 8) | static_cast<unsigned char>(padded[i + j]);
+		res.push_back(g);
+	}
+	sort(res.begin(), res.end());
+	res.erase(unique(res.begin(), res.end()), res.end());
+	return res;
+}
+
+NGramIndex::NGramIndex(){}
+
+NGramIndex::NGramIndex(const vector<string> &text)
+{
+	for (unsigned int i = 0; i < text.size(); i++)
+		add(text[i]);
+}
+
+void NGramIndex::add(const string &s)
+{
+	vector<unsigned int> grams = getGrams(s);
+	for (unsigned int i = 0; i < grams.size(); i++)
+		postings[grams[i]].push_back(strings.size());
+	gramCount.push_back(grams.size());
+	strings.push_back(s);
+}
+
+int NGramIndex::size() const
+{
+	return strings.size();
+}
+
+priority_queue<ApproxString> NGramIndex::search(const string &pattern, bool caseSensitive, int k) const
+{
+	priority_queue<ApproxString> res;
+	if (k <= 0)
+		return res;
+
+	//trigrams shared by each string and the pattern, all 0 between searches (shared by the indexes of a thread)
+	static thread_local vector<int> counts;
+	if (counts.size() < strings.size())
+		counts.resize(strings.size(), 0);
+
+	//First part: count the trigrams each string shares with the pattern
+	vector<unsigned int> grams = getGrams(pattern);
+	vector<int> touched;
+	for (unsigned int i = 0; i < grams.size(); i++)
+	{
+		unordered_map<unsigned int, vector<int> >::const_iterator it = postings.find(grams[i]);
+		if (it == postings.end())
+			continue;
+		for (unsigned int j = 0; j < it->second.size(); j++)
+		{
+			int id = it->second[j];
+			if (counts[id]++ == 0)
+				touched.push_back(id);
+		}
+	}
+
+	//Second part: sort the candidates by shared trigrams (bucket sort) and reset the counters
+	int patternGrams = grams.size();
+	vector<vector<int> > buckets(patternGrams + 1);
+	for (unsigned int i = 0; i < touched.size(); i++)
+	{
+		buckets[counts[touched[i]]].push_back(touched[i]);
+		counts[touched[i]] = -1;
+	}
+
+	//Third part: verify the candidates, best first, until the trigram count proves that the
+	//remaining ones can't beat the k-th best (each edit destroys at most GRAM_SIZE trigrams)
+	priority_queue<pair<int, int> > best;	//max-heap with the k best (distance, index) found so far
+	for (int c = patternGrams; c > 0; c--)
+	{
+		int bound = (patternGrams - c + GRAM_SIZE - 1) / GRAM_SIZE;
+		if (best.size() == k && bound >= best.top().first)
+			break;
+		for (unsigned int i = 0; i < buckets[c].size(); i++)
+		{
+			int id = buckets[c][i];
+			int grams = max(gramCount[id], patternGrams);
+			if (best.size() == k && (grams - c + GRAM_SIZE - 1) / GRAM_SIZE >= best.top().first)
+				continue;
+			int maxDistance = (best.size() == k ? best.top().first - 1 : max(strings[id].size(), pattern.size()));
+			int d = levenshtein_distance(strings[id], pattern, caseSensitive, maxDistance);
+			if (d > maxDistance)
+				continue;
+			best.push(pair<int, int>(d, id));
+			if (best.size() > k)
+				best.pop();
+		}
+	}
+
+	//Fourth part: strings sharing no trigram can still be at a smaller distance than the
+	//k-th best when the pattern is short, in which case they have to be scanned
+	int bound = (patternGrams + GRAM_SIZE - 1) / GRAM_SIZE;
+	if (best.size() < k || bound < best.top().first)
+	{
+		for (unsigned int id = 0; id < strings.size(); id++)
+		{
+			if (counts[id] != 0)
+				continue;
+			int grams = max(gramCount[id], patternGrams);
+			if (best.size() == k && (grams + GRAM_SIZE - 1) / GRAM_SIZE >= best.top().first)
+				continue;
+			int maxDistance = (best.size() == k ? best.top().first - 1 : max(strings[id].size(), pattern.size()));
+			int d = levenshtein_distance(strings[id], pattern, caseSensitive, maxDistance);
+			if (d > maxDistance)
+				continue;
+			best.push(pair<int, int>(d, id));
+			if (best.size() > k)
+				best.pop();
+		}
+	}
+	for (unsigned int i = 0; i < touched.size(); i++)
+		counts[touched[i]] = 0;
+
+	while (!best.empty())
+	{
+		res.push(ApproxString(strings[best.top().second], best.top().first));
+		best.pop();
+	}
+	return res;
+}
 
+BKTree::BKTree(){}
 
+BKTree::BKTree(const vector<string> &text)
+{
+	for (unsigned int i = 0; i < text.size(); i++)
+		add(text[i]);
+}
+
+void BKTree::add(const string &s)
+{
+	node_t n;
+	n.key = toLower(s);
+	n.ids.push_back(strings.size());
+	strings.push_back(s);
+
+	if (nodes.empty())
+	{
+		nodes.push_back(n);
+		return;
+	}
+
+	int current = 0;
+	while (true)
+	{
+		int d = levenshtein_distance(nodes[current].key, n.key, true);
+		if (d == 0)
+		{
+			nodes[current].ids.push_back(n.ids[0]);
+			return;
+		}
+
+		int next = -1;
+		for (unsigned int i = 0; i < nodes[current].children.size(); i++)
+		{
+			if (nodes[current].children[i].first == d)
+			{
+				next = nodes[current].children[i].second;
+				break;
+			}
+		}
+		if (next == -1)
+		{
+			nodes[current].children.push_back(pair<int, int>(d, nodes.size()));
+			nodes.push_back(n);
+			return;
+		}
+		current = next;
+	}
+}
+
+int BKTree::size() const
+{
+	return strings.size();
+}
+
+priority_queue<ApproxString> BKTree::search(const string &pattern, bool caseSensitive, int maxDistance) const
+{
+	priority_queue<ApproxString> res;
+	if (nodes.empty())
+		return res;
+
+	string p = toLower(pattern);
+	vector<int> stack(1, 0);
+	while (!stack.empty())
+	{
+		const node_t &n = nodes[stack.back()];
+		stack.pop_back();
+
+		int d = levenshtein_distance(n.key, p, true);
+		if (d <= maxDistance)
+		{
+			//the case-sensitive distance is never smaller than the case-insensitive one
+			for (unsigned int i = 0; i < n.ids.size(); i++)
+			{
+				const string &s = strings[n.ids[i]];
+				int cd = caseSensitive ? levenshtein_distance(s, pattern, true, maxDistance) : d;
+				if (cd <= maxDistance)
+					res.push(ApproxString(s, cd));
+			}
+		}
+		for (unsigned int i = 0; i < n.children.size(); i++)
+		{
+			if (abs(n.children[i].first - d) <= maxDistance)
+				stack.push_back(n.children[i].second);
+		}
+	}
+	return res;
+}
+
+/**
+ * Checks if a character is part of a word (letters, digits and any non-ASCII byte, such as accented letters)
+ * @param c the character
+ * @return true if the character is part of a word, false otherwise
+ */
+static bool isWordCharacter(char c)
+{
+	unsigned char u = c;
+	return u >= 128 || isalnum(u);
+}
+
+AhoCorasick::AhoCorasick(): alphabetSize(1), transitions(1, 0), output(1, -1), outputLink(1, -1)
+{
+	fill(symbol, symbol + 256, 0);
+}
+
+AhoCorasick::AhoCorasick(const vector<string> &text): strings(text), nextSame(text.size(), -1), alphabetSize(1)
+{
+	fill(symbol, symbol + 256, 0);
+	for (unsigned int i = 0; i < strings.size(); i++)
+		for (unsigned int j = 0; j < strings[i].size(); j++)
+		{
+			unsigned char c = foldTables.lower[static_cast<unsigned char>(strings[i][j])];
+			if (symbol[c] == 0)
+				symbol[c] = alphabetSize++;
+		}
+
+	//build the trie, with -1 marking the missing transitions
+	transitions.assign(alphabetSize, -1);
+	output.assign(1, -1);
+	for (unsigned int i = 0; i < strings.size(); i++)
+	{
+		if (strings[i].empty())
+			continue;
+
+		int node = 0;
+		for (unsigned int j = 0; j < strings[i].size(); j++)
+		{
+			int s = symbol[foldTables.lower[static_cast<unsigned char>(strings[i][j])]];
+			if (transitions[node * alphabetSize + s] == -1)
+			{
+				transitions[node * alphabetSize + s] = output.size();
+				transitions.resize(transitions.size() + alphabetSize, -1);
+				output.push_back(-1);
+			}
+			node = transitions[node * alphabetSize + s];
+		}
+
+		if (output[node] == -1)
+			output[node] = i;
+		else
+		{
+			int last = output[node];
+			while (nextSame[last] != -1)
+				last = nextSame[last];
+			nextSame[last] = i;
+		}
+	}
+
+	//visit the trie in breadth-first order, so the failure node of every node is already complete,
+	//replacing each missing transition by the transition of the failure node
+	vector<int> failure(output.size(), 0);
+	outputLink.assign(output.size(), -1);
+	vector<int> queue;
+	for (int s = 0; s < alphabetSize; s++)
+	{
+		int &next = transitions[s];
+		if (next == -1)
+			next = 0;
+		else
+			queue.push_back(next);
+	}
+	for (unsigned int q = 0; q < queue.size(); q++)
+	{
+		int node = queue[q];
+		for (int s = 0; s < alphabetSize; s++)
+		{
+			int &next = transitions[node * alphabetSize + s];
+			int fallback = transitions[failure[node] * alphabetSize + s];
+			if (next == -1)
+				next = fallback;
+			else
+			{
+				failure[next] = fallback;
+				outputLink[next] = (output[fallback] != -1 ? fallback : outputLink[fallback]);
+				queue.push_back(next);
+			}
+		}
+	}
+}
+
+int AhoCorasick::size() const
+{
+	return strings.size();
+}
+
+const string &AhoCorasick::getString(int id) const
+{
+	return strings.at(id);
+}
+
+vector<string_match_t> AhoCorasick::search(const string &text, bool caseSensitive) const
+{
+	vector<string_match_t> res;
+	int node = 0;
+	for (unsigned int i = 0; i < text.size(); i++)
+	{
+		node = transitions[node * alphabetSize + symbol[foldTables.lower[static_cast<unsigned char>(text[i])]]];
+		//an occurrence ending in the middle of a word is discarded
+		if (isWordCharacter(text[i]) && i + 1 < text.size() && isWordCharacter(text[i + 1]))
+			continue;
+
+		for (int n = (output[node] != -1 ? node : outputLink[node]); n != -1; n = outputLink[n])
+		{
+			int length = strings[output[n]].size();
+			int position = i + 1 - length;
+			if (isWordCharacter(text[position]) && position > 0 && isWordCharacter(text[position - 1]))
+				continue;
+
+			for (int id = output[n]; id != -1; id = nextSame[id])
+			{
+				if (caseSensitive && text.compare(position, length, strings[id]) != 0)
+					continue;
+				string_match_t m;
+				m.id = id;
+				m.position = position;
+				m.length = length;
+				res.push_back(m);
+			}
+		}
+	}
+	return res;
+}
+
+CompletionTrie::CompletionTrie(): firstBest(1, 0){}
+
+CompletionTrie::CompletionTrie(const vector<string> &text, const vector<int> &weight, int k): strings(text), weights(weight)
+{
+	//sorting the strings puts the ones sharing a prefix next to each other, so each node of a level
+	//covers a contiguous range of the sorted strings
+	vector<string> keys;
+	for (unsigned int i = 0; i < strings.size(); i++)
+		keys.push_back(toLower(strings[i]));
+	vector<int> order(strings.size());
+	iota(order.begin(), order.end(), 0);
+	sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+	//build the nodes level by level, each node being the range [begin, end) of order at depth depth
+	vector<pair<int, int> > ranges(1, pair<int, int>(0, order.size()));
+	vector<int> depths(1, 0);
+	labels.push_back('\0');
+	for (unsigned int node = 0; node < ranges.size(); node++)
+	{
+		int depth = depths[node];
+		int i = ranges[node].first;
+		//strings ending at this node come first in the range and have no child
+		while (i < ranges[node].second && keys[order[i]].size() == depth)
+			i++;
+
+		firstChild.push_back(ranges.size());
+		numChildren.push_back(0);
+		while (i < ranges[node].second)
+		{
+			unsigned char c = keys[order[i]][depth];
+			int j = i;
+			while (j < ranges[node].second && static_cast<unsigned char>(keys[order[j]][depth]) == c)
+				j++;
+			ranges.push_back(pair<int, int>(i, j));
+			depths.push_back(depth + 1);
+			labels.push_back(c);
+			numChildren[node]++;
+			i = j;
+		}
+	}
+
+	//the best completions of a node are the best among its own strings and the best completions of its
+	//children, so they are computed from the deepest nodes up (the reverse of the breadth-first order)
+	vector<vector<int> > nodeBest(ranges.size());
+	for (int node = ranges.size() - 1; node >= 0; node--)
+	{
+		vector<int> &candidates = nodeBest[node];
+		for (int i = ranges[node].first; i < ranges[node].second && keys[order[i]].size() == depths[node]; i++)
+			candidates.push_back(order[i]);
+		for (int c = firstChild[node]; c < firstChild[node] + numChildren[node]; c++)
+			candidates.insert(candidates.end(), nodeBest[c].begin(), nodeBest[c].end());
+		int kept = min(k, static_cast<int>(candidates.size()));
+		partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(),
+				[this](int a, int b) { return better(a, b); });
+		candidates.resize(kept);
+	}
+
+	firstBest.assign(1, 0);
+	for (unsigned int node = 0; node < ranges.size(); node++)
+	{
+		best.insert(best.end(), nodeBest[node].begin(), nodeBest[node].end());
+		firstBest.push_back(best.size());
+	}
+}
+
+bool CompletionTrie::better(int a, int b) const
+{
+	if (weights[a] != weights[b])
+		return weights[a] > weights[b];
+	return strings[a] < strings[b];
+}
+
+int CompletionTrie::size() const
+{
+	return strings.size();
+}
+
+const string &CompletionTrie::getString(int id) const
+{
+	return strings.at(id);
+}
+
+vector<int> CompletionTrie::complete(const string &prefix, int k) const
+{
+	vector<int> res;
+	if (firstChild.empty())
+		return res;
+
+	int node = 0;
+	for (unsigned int i = 0; i < prefix.size(); i++)
+	{
+		unsigned char c = foldTables.lower[static_cast<unsigned char>(prefix[i])];
+		vector<unsigned char>::const_iterator first = labels.begin() + firstChild[node];
+		vector<unsigned char>::const_iterator last = first + numChildren[node];
+		vector<unsigned char>::const_iterator it = lower_bound(first, last, c);
+		if (it == last || *it != c)
+			return res;
+		node = it - labels.begin();
+	}
+
+	int end = min(firstBest[node + 1], firstBest[node] + k);
+	res.assign(best.begin() + firstBest[node], best.begin() + end);
+	return res;
+}
@@ -4,6 +4,8 @@
 #include <string>
 #include <queue>
 #include <numeric>
+#include <vector>
+#include <unordered_map>
 
 using namespace std;
 
@@ -52,6 +54,14 @@ public:
  */
 void trim(string &s);
 
+/**
+ * Escapes a string to be written inside quotes in JSON: quotes and backslashes are preceded by a backslash,
+ * and control characters are written as escape sequences (\n, \r, \t or \u00XX)
+ * @param s the string
+ * @return the escaped string
+ */
+string escapeJSON(const string &s);
+
 /**
  * Checks if a certain pattern can be found in a
  * certain text using the Knuth-Morris-Pratt algorithm
@@ -62,6 +72,18 @@ void trim(string &s);
  */
 string kmpStringMatching(string &text, string pattern, bool caseSensitive);
 
+/**
+ * Same as kmpStringMatching, finding the first occurrence of the pattern in the text and accepting it only if
+ * it is followed by two spaces (the end of a name in a string of names separated by two spaces).
+ * Case is folded once and the candidate positions are filtered by their first and last characters
+ * with SSE2/AVX2 instructions, when available, before being compared in full
+ * @param text the text to analyse
+ * @param pattern the pattern to search for
+ * @param caseSensitive true to consider case sensitiveness, false to not consider
+ * @return string if the pattern was found, empty string otherwise
+ */
+string exactStringMatching(const string &text, const string &pattern, bool caseSensitive);
+
 /**
  * Scans a set of strings, ordering them by resemblance to a certain pattern
  * @param text the set of strings
@@ -72,7 +94,8 @@ string kmpStringMatching(string &text, string pattern, bool caseSensitive);
 priority_queue<ApproxString> approximateStringMatching(vector<string> &text, string pattern, bool caseSensitive);
 
 /**
- * Compares a string with a pattern to determine the amount of operations (deletion, addition or substitution) needed to turn the string into the pattern
+ * Compares a string with a pattern to determine the amount of operations (deletion, addition or substitution) needed to turn the string into the pattern.
+ * Uses the bit-parallel algorithm by Myers, processing 64 rows of the distance matrix at once
  * @param t the string to be tested
  * @param p the pattern to be used as base for comparison
  * @param caseSensitive true to consider case sensitiveness, false to not consider
@@ -80,4 +103,251 @@ priority_queue<ApproxString> approximateStringMatching(vector<string> &text, str
  */
 int levenshtein_distance(const string &t, const string &p, bool caseSensitive);
 
+/**
+ * Same as levenshtein_distance(t, p, caseSensitive), but using the classic dynamic programming
+ * algorithm, one cell at a time. Kept as a reference for tests and benchmarks
+ * @param t the string to be tested
+ * @param p the pattern to be used as base for comparison
+ * @param caseSensitive true to consider case sensitiveness, false to not consider
+ * @return an integer symbolising the amount of operations needed to make both strings similar
+ */
+int levenshtein_distance_dp(const string &t, const string &p, bool caseSensitive);
+
+/**
+ * Same as levenshtein_distance(t, p, caseSensitive), but gives up as soon as the
+ * distance is known to be larger than maxDistance
+ * @param t the string to be tested
+ * @param p the pattern to be used as base for comparison
+ * @param caseSensitive true to consider case sensitiveness, false to not consider
+ * @param maxDistance the largest distance of interest
+ * @return the distance between both strings, or maxDistance + 1 if it is larger than maxDistance
+ */
+int levenshtein_distance(const string &t, const string &p, bool caseSensitive, int maxDistance);
+
+/**
+ * Inverted index of the trigrams of a set of strings, used for approximate search.
+ * Candidates are generated by the number of trigrams they share with the pattern and
+ * only the most promising ones have their edit distance to the pattern computed
+ */
+class NGramIndex
+{
+private:
+	vector<string> strings;								/// the indexed strings
+	vector<int> gramCount;								/// number of distinct trigrams of each string
+	unordered_map<unsigned int, vector<int> > postings;	/// for each trigram, the indexes of the strings that contain it
+
+public:
+	/**
+	 * Creates an empty index
+	 */
+	NGramIndex();
+
+	/**
+	 * Creates an index over a set of strings
+	 * @param text the set of strings
+	 */
+	NGramIndex(const vector<string> &text);
+
+	/**
+	 * Adds a string to the index
+	 * @param s the string
+	 */
+	void add(const string &s);
+
+	/**
+	 * Gets the amount of indexed strings
+	 * @return size of NGramIndex::strings
+	 */
+	int size() const;
+
+	/**
+	 * Finds the indexed strings most similar to a pattern. Strings that share no trigram with the
+	 * pattern are only scanned if they might still be among the k closest. Several threads may search
+	 * the same index at once (the counters of shared trigrams are kept per thread)
+	 * @param pattern the pattern to compare to
+	 * @param caseSensitive true to consider case sensitiveness, false to not consider
+	 * @param k the maximum amount of strings to return
+	 * @return a priority queue with at most k strings, with the most approximate one at the head
+	 */
+	priority_queue<ApproxString> search(const string &pattern, bool caseSensitive, int k) const;
+};
+
+/**
+ * Burkhard-Keller tree over a set of strings, using the (case-insensitive) edit distance
+ * as the metric. It finds every string within a given distance of a pattern while
+ * visiting only a fraction of the tree, thanks to the triangle inequality
+ */
+class BKTree
+{
+private:
+	/**
+	 * Node of the tree, holding all strings equal to each other when case is ignored
+	 */
+	struct node_t
+	{
+		string key;							/// the strings of this node, in lower case
+		vector<int> ids;					/// indexes of the strings of this node in BKTree::strings
+		vector<pair<int, int> > children;	/// distance to each child and its index in BKTree::nodes
+	};
+
+	vector<string> strings;		/// the indexed strings
+	vector<node_t> nodes;		/// the nodes of the tree, the root being the first one
+
+public:
+	/**
+	 * Creates an empty tree
+	 */
+	BKTree();
+
+	/**
+	 * Creates a tree over a set of strings
+	 * @param text the set of strings
+	 */
+	BKTree(const vector<string> &text);
+
+	/**
+	 * Adds a string to the tree
+	 * @param s the string
+	 */
+	void add(const string &s);
+
+	/**
+	 * Gets the amount of indexed strings
+	 * @return size of BKTree::strings
+	 */
+	int size() const;
+
+	/**
+	 * Finds all strings within a certain edit distance of a pattern
+	 * @param pattern the pattern to compare to
+	 * @param caseSensitive true to consider case sensitiveness, false to not consider
+	 * @param maxDistance the largest distance accepted
+	 * @return a priority queue with the strings found, with the most approximate one at the head
+	 */
+	priority_queue<ApproxString> search(const string &pattern, bool caseSensitive, int maxDistance) const;
+};
+
+/**
+ * Occurrence of an indexed string inside a text
+ */
+struct string_match_t
+{
+	int id;			/// index of the string found, in the order it was given to the automaton
+	int position;	/// position of the first character of the occurrence in the text
+	int length;		/// length of the occurrence
+};
+
+/**
+ * Aho-Corasick automaton over a fixed set of strings, finding all of them inside a text in a single pass.
+ * The trie of the strings (with case folded) is turned into a complete automaton, whose transitions are
+ * stored in a flat table indexed by node and symbol, so each character of the text costs a single lookup.
+ * Only the characters present in the strings have their own symbol, every other character shares symbol 0
+ */
+class AhoCorasick
+{
+private:
+	vector<string> strings;		/// the indexed strings
+	vector<int> nextSame;		/// for each string, the next one equal to it when case is ignored (-1 if none)
+	unsigned char symbol[256];	/// symbol of each (folded) character
+	int alphabetSize;			/// number of distinct symbols, including symbol 0
+	vector<int> transitions;	/// next node for each node and symbol (node * alphabetSize + symbol)
+	vector<int> output;			/// first string ending at each node (-1 if none)
+	vector<int> outputLink;		/// closest node along the failure links of each node with an output (-1 if none)
+
+public:
+	/**
+	 * Creates an empty automaton, which finds nothing
+	 */
+	AhoCorasick();
+
+	/**
+	 * Builds the automaton over a set of strings (empty strings are ignored)
+	 * @param text the set of strings
+	 */
+	AhoCorasick(const vector<string> &text);
+
+	/**
+	 * Gets the amount of indexed strings
+	 * @return size of AhoCorasick::strings
+	 */
+	int size() const;
+
+	/**
+	 * Gets an indexed string
+	 * @param id index of the string
+	 * @return the string
+	 */
+	const string &getString(int id) const;
+
+	/**
+	 * Finds every occurrence of the indexed strings in a text that is delimited by word boundaries
+	 * (so "Rua da Boa Vista" does not match inside "Rua da Boa Vistaria")
+	 * @param text the text to search
+	 * @param caseSensitive true to consider case sensitiveness, false to not consider
+	 * @return the occurrences found, ordered by their end position and from the longest to the shortest
+	 */
+	vector<string_match_t> search(const string &text, bool caseSensitive) const;
+};
+
+/**
+ * Prefix tree for autocompletion, where every node holds its best completions, computed when the tree is built.
+ * The tree is stored in flat arrays in breadth-first order, so the children of each node are contiguous and sorted
+ * by character (and searched by binary search), and the best completions of all nodes are stored back to back.
+ * A query costs one step per character of the prefix and does not depend on the amount of strings below it
+ */
+class CompletionTrie
+{
+private:
+	vector<string> strings;		/// the indexed strings
+	vector<int> weights;		/// weight of each string, the larger the better
+	vector<unsigned char> labels;	/// character (in lower case) on the edge leading to each node
+	vector<int> firstChild;		/// index of the first child of each node (children are contiguous)
+	vector<int> numChildren;	/// amount of children of each node
+	vector<int> firstBest;		/// index in CompletionTrie::best of the first completion of each node (plus one entry for the end)
+	vector<int> best;			/// best completions of all nodes, each one sorted from the best to the worst
+
+	/**
+	 * Compares two strings by weight and then by name
+	 * @param a index of the first string
+	 * @param b index of the second string
+	 * @return true if the first string should be completed before the second one
+	 */
+	bool better(int a, int b) const;
+
+public:
+	/**
+	 * Creates an empty tree
+	 */
+	CompletionTrie();
+
+	/**
+	 * Builds the tree over a set of weighted strings
+	 * @param text the set of strings
+	 * @param weight weight of each string (such as its popularity), the larger the better
+	 * @param k maximum amount of completions kept for each prefix
+	 */
+	CompletionTrie(const vector<string> &text, const vector<int> &weight, int k);
+
+	/**
+	 * Gets the amount of indexed strings
+	 * @return size of CompletionTrie::strings
+	 */
+	int size() const;
+
+	/**
+	 * Gets an indexed string
+	 * @param id index of the string
+	 * @return the string
+	 */
+	const string &getString(int id) const;
+
+	/**
+	 * Gets the best completions of a prefix, ignoring case
+	 * @param prefix the prefix typed so far
+	 * @param k maximum amount of completions (at most the value given when the tree was built)
+	 * @return indexes of the strings starting with the prefix, from the best to the worst
+	 */
+	vector<int> complete(const string &prefix, int k) const;
+};
+
 #endif /* STRINGFUNCTIONS_H_ */
@@ -0,0 +1,142 @@
+#include "TreeCache.h"
+
+/**
+ * Gets the memory taken by a tree
+ * @return bytes of the tree and of its arrays
+ */
+static size_t treeBytes(const sp_tree_t &tree)
+{
+	return sizeof(sp_tree_t) + tree.dist.capacity() * sizeof(double) +
+			(tree.pred.capacity() + tree.parent.capacity()) * sizeof(int);
+}
+
+TreeCache::TreeCache(size_t capacity): capacity(capacity), used(0), hits(0), misses(0), evictions(0), generation(0)
+{
+}
+
+void TreeCache::evict()
+{
+	while (used > capacity && entries.size() > 1)
+	{
+		used -= entries.back().bytes;
+		index.erase(entries.back().source);
+		entries.pop_back();
+		evictions++;
+	}
+}
+
+shared_ptr<const sp_tree_t> TreeCache::get(const CoreGraph &core, const Vertex<RoadNode>* source)
+{
+	return get(source, [&]() { return core.computeShortestPathTree(source->getInfo()); });
+}
+
+shared_ptr<const sp_tree_t> TreeCache::get(const TurnGraph &turns, const Vertex<RoadNode>* source)
+{
+	return get(source, [&]() { return turns.computeShortestPathTree(source->getInfo()); });
+}
+
+shared_ptr<const sp_tree_t> TreeCache::get(const Vertex<RoadNode>* source, const function<sp_tree_t()> &compute)
+{
+	int s = source->getIndex();
+	long long computedAt;
+	{
+		unique_lock<mutex> guard(lock);
+		unordered_map<int, list<tree_cache_entry_t>::iterator>::iterator it = index.find(s);
+		if (it != index.end())
+		{
+			hits++;
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->tree;
+		}
+		misses++;
+		computedAt = generation;
+	}
+
+	//the tree is computed without holding the lock, so other threads can use the cache meanwhile
+	//(if another thread computed the same tree in the meantime, its tree is kept)
+	shared_ptr<sp_tree_t> tree = make_shared<sp_tree_t>(compute());
+	unique_lock<mutex> guard(lock);
+	if (computedAt != generation)
+		return tree;
+	unordered_map<int, list<tree_cache_entry_t>::iterator>::iterator it = index.find(s);
+	if (it != index.end())
+	{
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->tree;
+	}
+	tree_cache_entry_t e;
+	e.source = s;
+	e.tree = tree;
+	e.bytes = treeBytes(*tree);
+	entries.push_front(e);
+	index[s] = entries.begin();
+	used += e.bytes;
+	evict();
+	return tree;
+}
+
+int TreeCache::repair(const Graph<RoadNode> &graph, const vector<int> &changed)
+{
+	unique_lock<mutex> guard(lock);
+	generation++;
+	int recomputed = 0;
+	for (list<tree_cache_entry_t>::iterator it = entries.begin(); it != entries.end(); it++)
+	{
+		if (!it->tree.unique())
+			it->tree = make_shared<sp_tree_t>(*it->tree);
+		recomputed += graph.repairShortestPathTree(*it->tree, changed);
+	}
+	return recomputed;
+}
+
+void TreeCache::clear()
+{
+	unique_lock<mutex> guard(lock);
+	generation++;
+	entries.clear();
+	index.clear();
+	used = 0;
+}
+
+void TreeCache::setCapacity(size_t capacity)
+{
+	unique_lock<mutex> guard(lock);
+	this->capacity = capacity;
+	evict();
+}
+
+size_t TreeCache::getCapacity() const
+{
+	unique_lock<mutex> guard(lock);
+	return capacity;
+}
+
+size_t TreeCache::getUsedBytes() const
+{
+	unique_lock<mutex> guard(lock);
+	return used;
+}
+
+int TreeCache::getNumTrees() const
+{
+	unique_lock<mutex> guard(lock);
+	return entries.size();
+}
+
+long long TreeCache::getHits() const
+{
+	unique_lock<mutex> guard(lock);
+	return hits;
+}
+
+long long TreeCache::getMisses() const
+{
+	unique_lock<mutex> guard(lock);
+	return misses;
+}
+
+long long TreeCache::getEvictions() const
+{
+	unique_lock<mutex> guard(lock);
+	return evictions;
+}
@@ -0,0 +1,142 @@
+#ifndef TREECACHE_H_
+#define TREECACHE_H_
+
+#include "Graph.h"
+#include "CoreGraph.h"
+#include "TurnGraph.h"
+#include "RoadNode.h"
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#define TREE_CACHE_DEFAULT_MB 64		//memory used by the shortest path trees of a cache, unless another bound is set
+
+/**
+ * A shortest path tree kept by a TreeCache
+ */
+struct tree_cache_entry_t
+{
+	int source;							/// index of the source vertex of the tree
+	shared_ptr<sp_tree_t> tree;			/// the tree
+	size_t bytes;						/// memory taken by the tree
+};
+
+/**
+ * Shortest path trees computed so far, by source vertex, so that the queries from a source after the first one
+ * are a lookup. The memory taken by the trees is bounded: when it goes over the bound, the least recently used
+ * trees are dropped (the tree just asked for is always kept, even if it alone goes over the bound).
+ * Trees are handed out as shared pointers, so a tree dropped by the cache stays valid for whoever still holds it,
+ * and the cache may be used by several threads at once.
+ */
+class TreeCache
+{
+private:
+	size_t capacity;								/// Bound on the memory of the trees (in bytes)
+	size_t used;									/// Memory taken by the trees
+	list<tree_cache_entry_t> entries;				/// The trees, from the most recently used to the least
+	unordered_map<int, list<tree_cache_entry_t>::iterator> index;	/// Position of the tree of each source in TreeCache::entries
+	long long hits;									/// Trees asked for that were in the cache
+	long long misses;								/// Trees asked for that had to be computed
+	long long evictions;							/// Trees dropped to respect the bound
+	long long generation;							/// Changed whenever the trees are repaired or dropped, so that trees computed meanwhile are not kept
+	mutable mutex lock;								/// Protects all the other members
+
+	/**
+	 * Drops the least recently used trees until the memory is within the bound (keeping at least one tree)
+	 */
+	void evict();
+
+public:
+	/**
+	 * Creates an empty cache
+	 * @param capacity bound on the memory of the trees (in bytes)
+	 */
+	TreeCache(size_t capacity = (size_t)TREE_CACHE_DEFAULT_MB << 20);
+
+	/**
+	 * Gets the shortest path tree from a vertex, computing it if it is not in the cache
+	 * (the cache must hold trees computed in a single way at a time)
+	 * @param source the source vertex
+	 * @param compute computes the tree, without holding the lock
+	 * @return the tree (shared with the cache until it is dropped)
+	 */
+	shared_ptr<const sp_tree_t> get(const Vertex<RoadNode>* source, const function<sp_tree_t()> &compute);
+
+	/**
+	 * Gets the shortest path tree from a vertex, computing it if it is not in the cache
+	 * @param core contracted graph of the graph the vertex belongs to, with the current weights
+	 * @param source the source vertex
+	 * @return the tree (shared with the cache until it is dropped)
+	 */
+	shared_ptr<const sp_tree_t> get(const CoreGraph &core, const Vertex<RoadNode>* source);
+
+	/**
+	 * Gets the shortest path tree from a vertex obeying the turn rules, computing it if it is not in the cache
+	 * (the cache must not hold trees of both kinds at once)
+	 * @param turns expansion of the graph the vertex belongs to, with the current weights
+	 * @param source the source vertex
+	 * @return the tree, followed by the turn states (shared with the cache until it is dropped)
+	 */
+	shared_ptr<const sp_tree_t> get(const TurnGraph &turns, const Vertex<RoadNode>* source);
+
+	/**
+	 * Repairs every tree in the cache after some edges of the graph changed (see Graph::repairShortestPathTree).
+	 * Trees still held outside the cache are copied before they are repaired, so their holders are not affected.
+	 * Trees with turn states cannot be repaired, so the cache must be cleared instead
+	 * @param graph the graph, with the new weights
+	 * @param changed indexes of the edges that changed
+	 * @return amount of vertexes recomputed, over all trees
+	 */
+	int repair(const Graph<RoadNode> &graph, const vector<int> &changed);
+
+	/**
+	 * Drops every tree, after the metric or the vertexes of the graph changed
+	 */
+	void clear();
+
+	/**
+	 * Sets the bound on the memory of the trees, dropping trees if it is now exceeded
+	 * @param capacity the bound (in bytes)
+	 */
+	void setCapacity(size_t capacity);
+
+	/**
+	 * Gets the bound on the memory of the trees
+	 * @return value of TreeCache::capacity
+	 */
+	size_t getCapacity() const;
+
+	/**
+	 * Gets the memory taken by the trees
+	 * @return value of TreeCache::used
+	 */
+	size_t getUsedBytes() const;
+
+	/**
+	 * Gets the amount of trees in the cache
+	 * @return size of TreeCache::entries
+	 */
+	int getNumTrees() const;
+
+	/**
+	 * Gets the amount of trees asked for that were in the cache
+	 * @return value of TreeCache::hits
+	 */
+	long long getHits() const;
+
+	/**
+	 * Gets the amount of trees asked for that had to be computed
+	 * @return value of TreeCache::misses
+	 */
+	long long getMisses() const;
+
+	/**
+	 * Gets the amount of trees dropped to respect the bound
+	 * @return value of TreeCache::evictions
+	 */
+	long long getEvictions() const;
+};
+
+#endif /* TREECACHE_H_ */
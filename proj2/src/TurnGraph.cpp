@@ -0,0 +1,260 @@
+#include "TurnGraph.h"
+#include "Exceptions.h"
+#include "StringFunctions.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+TurnGraph::TurnGraph(Graph<RoadNode> &graph): graph(graph), perSecond(0), numRules(0)
+{
+	expand(vector<turn_rule_t>());
+}
+
+bool TurnGraph::load(const string &file)
+{
+	ifstream turns(file.c_str());
+	if (!turns.is_open())
+		throw new FileNotFound(file);
+
+	vector<turn_rule_t> rules;
+	int lineNumber = 0;
+	string s;
+	while (getline(turns, s))
+	{
+		lineNumber++;
+		trim(s);
+		if (s.empty() || s[0] == '#')
+			continue;
+
+		istringstream ss(s);
+		long long ids[3];
+		char marker;
+		string value;
+		ss >> ids[0] >> marker >> ids[1] >> marker >> ids[2] >> marker;
+		getline(ss, value, ';');
+		trim(value);
+		bool valid = !ss.fail();
+		Vertex<RoadNode>* v[3] = { NULL, NULL, NULL };
+		for (int i = 0; i < 3 && valid; i++)
+		{
+			v[i] = graph.getVertex(RoadNode(ids[i], 0, 0, 0, 0));
+			valid = (v[i] != NULL);
+		}
+
+		turn_rule_t rule;
+		rule.from = -1;
+		rule.to = -1;
+		rule.seconds = 0;
+		rule.only = (value == "only");
+		if (valid)
+		{
+			const ArenaArray<pair<Vertex<RoadNode>*, int> > &in = v[1]->getIncoming();
+			for (int i = 0; i < in.size() && rule.from == -1; i++)
+				if (in.at(i).first == v[0])
+					rule.from = in.at(i).second;
+			const ArenaArray<Edge<RoadNode> > &adj = v[1]->getAdj();
+			for (int i = 0; i < adj.size() && rule.to == -1; i++)
+				if (adj.at(i).getDest() == v[2])
+					rule.to = adj.at(i).getIndex();
+			if (value == "no")
+				rule.seconds = INT_INFINITY;
+			else if (!rule.only)
+			{
+				istringstream vs(value);
+				valid = (vs >> rule.seconds) && rule.seconds >= 0 && rule.seconds < INT_INFINITY;
+			}
+		}
+		if (!valid || rule.from == -1 || rule.to == -1)
+		{
+			cout << "Invalid line " << lineNumber << " of turn file " << file << ": " << s << endl;
+			expand(vector<turn_rule_t>());
+			return false;
+		}
+		rules.push_back(rule);
+	}
+	expand(rules);
+	return true;
+}
+
+void TurnGraph::expand(const vector<turn_rule_t> &rules)
+{
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	int n = vs.size();
+	numRules = rules.size();
+	firstState.assign(n, -1);
+	stateVertex.clear();
+	turnStart.assign(1, 0);
+	turnSeconds.clear();
+	edgeState.assign(graph.getNumEdges(), -1);
+	for (int i = 0; i < n; i++)
+	{
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(i)->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+			edgeState.at(adj.at(j).getIndex()) = adj.at(j).getDest()->getIndex();
+	}
+
+	//each vertex with rules gets a turn state per edge leading to it, which allows every turn until the rules
+	//are applied (the vertex of a rule is where its first edge leads, read before the edges lead to turn states)
+	vector<int> via(rules.size());
+	for (int i = 0; i < rules.size(); i++)
+		via.at(i) = edgeState.at(rules.at(i).from);
+	for (int i = 0; i < rules.size(); i++)
+	{
+		int v = via.at(i);
+		if (firstState.at(v) != -1)
+			continue;
+		firstState.at(v) = n + stateVertex.size();
+		const ArenaArray<pair<Vertex<RoadNode>*, int> > &in = vs.at(v)->getIncoming();
+		int degree = vs.at(v)->getAdj().size();
+		for (int k = 0; k < in.size(); k++)
+		{
+			edgeState.at(in.at(k).second) = firstState.at(v) + k;
+			stateVertex.push_back(v);
+			turnStart.push_back(turnStart.back() + degree);
+		}
+	}
+	turnSeconds.assign(turnStart.back(), 0);
+
+	//"only" rules forbid, after their first edge, every turn not named by an "only" rule
+	vector<bool> hasOnly(stateVertex.size(), false), allowed(turnSeconds.size(), false);
+	for (int i = 0; i < rules.size(); i++)
+	{
+		const turn_rule_t &rule = rules.at(i);
+		int state = edgeState.at(rule.from) - n;
+		const ArenaArray<Edge<RoadNode> > &adj = vs.at(via.at(i))->getAdj();
+		int pos = turnStart.at(state);
+		while (adj.at(pos - turnStart.at(state)).getIndex() != rule.to)
+			pos++;
+		if (rule.only)
+		{
+			hasOnly.at(state) = true;
+			allowed.at(pos) = true;
+		}
+		else
+			turnSeconds.at(pos) = rule.seconds;
+	}
+	for (int s = 0; s < stateVertex.size(); s++)
+	{
+		if (!hasOnly.at(s))
+			continue;
+		for (int pos = turnStart.at(s); pos < turnStart.at(s + 1); pos++)
+			if (!allowed.at(pos))
+				turnSeconds.at(pos) = INT_INFINITY;
+	}
+}
+
+void TurnGraph::customize(double perSecond)
+{
+	this->perSecond = perSecond;
+}
+
+int TurnGraph::getNumRules() const
+{
+	return numRules;
+}
+
+int TurnGraph::getNumStates() const
+{
+	return stateVertex.size();
+}
+
+double TurnGraph::getTurnTime(const Vertex<RoadNode>* from, const Vertex<RoadNode>* via, const Vertex<RoadNode>* to) const
+{
+	int first = firstState.at(via->getIndex());
+	if (first == -1)
+		return 0;
+	const ArenaArray<pair<Vertex<RoadNode>*, int> > &in = via->getIncoming();
+	const ArenaArray<Edge<RoadNode> > &adj = via->getAdj();
+	for (int k = 0; k < in.size(); k++)
+	{
+		if (in.at(k).first != from)
+			continue;
+		int state = first + k - graph.getNumVertex();
+		for (int j = 0; j < adj.size(); j++)
+			if (adj.at(j).getDest() == to)
+				return turnSeconds.at(turnStart.at(state) + j);
+	}
+	return 0;
+}
+
+double TurnGraph::getPathTurnTime(const vector<RoadNode> &path) const
+{
+	double res = 0;
+	for (int i = 1; i + 1 < path.size(); i++)
+	{
+		const Vertex<RoadNode>* via = graph.getVertex(path.at(i));
+		if (firstState.at(via->getIndex()) == -1)
+			continue;
+		double t = getTurnTime(graph.getVertex(path.at(i - 1)), via, graph.getVertex(path.at(i + 1)));
+		if (t < INT_INFINITY)
+			res += t;
+	}
+	return res;
+}
+
+sp_tree_t TurnGraph::computeShortestPathTree(const RoadNode &s) const
+{
+	typedef pair<double, int> entry;
+	const vector<Vertex<RoadNode>* > &vs = graph.getVertexSet();
+	int n = vs.size(), states = n + stateVertex.size();
+	sp_tree_t tree;
+	tree.metric = graph.getMetric();
+	tree.dist.assign(states, INT_INFINITY);
+	tree.pred.assign(states, -1);
+	tree.parent.assign(states, -1);
+	Vertex<RoadNode>* source = graph.getVertex(s);
+	tree.source = (source == NULL ? -1 : source->getIndex());
+	if (tree.source == -1)
+		return tree;
+	tree.dist[tree.source] = 0;
+
+	//Dijkstra's algorithm over the states: the source and the vertices without rules allow every turn, while
+	//a turn state allows the turns of its vertex from its edge, adding their time
+	vector<entry> pq(1, entry(0, tree.source));
+	while (!pq.empty())
+	{
+		pop_heap(pq.begin(), pq.end(), greater<entry>());
+		entry top = pq.back();
+		pq.pop_back();
+		int u = top.second;
+		if (top.first > tree.dist[u])
+			continue;
+
+		int v = (u < n ? u : stateVertex[u - n]);
+		const ArenaArray<Edge<RoadNode> > &adj = vs[v]->getAdj();
+		for (int j = 0; j < adj.size(); j++)
+		{
+			double w = graph.getEdgeWeight(adj[j]);
+			if (u >= n)
+			{
+				float turn = turnSeconds[turnStart[u - n] + j];
+				if (turn >= INT_INFINITY)
+					continue;
+				w += turn * perSecond;
+			}
+			int t = edgeState[adj[j].getIndex()];
+			double d = top.first + w;
+			if (d < tree.dist[t])
+			{
+				tree.dist[t] = d;
+				tree.pred[t] = adj[j].getIndex();
+				tree.parent[t] = u;
+				pq.push_back(entry(d, t));
+				push_heap(pq.begin(), pq.end(), greater<entry>());
+			}
+		}
+	}
+
+	//each vertex with rules is reached by its best turn state (the source stays where it is)
+	for (int i = 0; i < stateVertex.size(); i++)
+	{
+		int v = stateVertex[i];
+		if (tree.dist[n + i] < tree.dist[v])
+		{
+			tree.dist[v] = tree.dist[n + i];
+			tree.pred[v] = tree.pred[n + i];
+			tree.parent[v] = tree.parent[n + i];
+		}
+	}
+	return tree;
+}
@@ -0,0 +1,110 @@
+#ifndef TURNGRAPH_H_
+#define TURNGRAPH_H_
+
+#include "Graph.h"
+#include "RoadNode.h"
+#include <string>
+#include <vector>
+
+/**
+ * A rule of a turn file: the cost of going from one edge into another through a vertex, or a restriction on it
+ */
+struct turn_rule_t
+{
+	int from;				/// index of the edge arriving at the vertex
+	int to;					/// index of the edge leaving the vertex
+	double seconds;			/// time taken by the turn (INT_INFINITY if it is forbidden)
+	bool only;				/// true if this is the only turn allowed from the arriving edge (with others of the same kind)
+};
+
+/**
+ * Edge-based routing over a graph, for turn costs and turn restrictions. Going through a vertex may cost
+ * a different time, or be forbidden, depending on the edge the vertex is entered by, so the state of a search
+ * is an edge (the line graph) rather than a vertex. Since most vertices have no turn rules, only the vertices
+ * that do are expanded: each gets one state per edge leading to it (turn states, numbered after the vertices),
+ * with the time of each turn into each edge leaving it, while every other vertex stays a single state.
+ *
+ * Shortest path trees are computed over these states, as sp_tree_t with one entry per vertex followed by one per
+ * turn state, plus the state each one was reached from (sp_tree_t::parent), since the path to a vertex may go
+ * through another vertex by a state that is not its best one. The entry of each vertex is its best state, so
+ * the tree is read by vertex like any other (and its paths by Graph::getTreePath).
+ *
+ * A turn file has one rule per line, "from;via;to;value", with the ids of three nodes such that there are edges
+ * from->via and via->to. The value is the time of the turn in seconds, "no" if it is forbidden or "only" if
+ * it is the only turn allowed after from->via (U-turns are rules with from equal to to).
+ */
+class TurnGraph
+{
+private:
+	Graph<RoadNode> &graph;				/// The graph expanded
+	double perSecond;					/// Weight of a second of turning, in the metric of the graph (see TurnGraph::customize)
+	int numRules;						/// Amount of rules loaded
+	vector<int> firstState;				/// Index of the first turn state of each vertex (-1 for vertices without turn rules)
+	vector<int> stateVertex;			/// Vertex of each turn state (the first is state graph.getNumVertex())
+	vector<int> turnStart;				/// Position in TurnGraph::turnSeconds of the turns of each turn state (plus the end)
+	vector<float> turnSeconds;			/// Time of each turn, from each turn state into each edge leaving its vertex, in the order of Vertex::adj (INT_INFINITY if forbidden)
+	vector<int> edgeState;				/// State reached by each edge: its destination, or the turn state of the edge at it
+
+	/**
+	 * Lays out the turn states and their turns, from the rules of a file
+	 * @param rules the rules
+	 */
+	void expand(const vector<turn_rule_t> &rules);
+
+	/**
+	 * Gets the time of turning from an edge into another
+	 * @param from vertex the first edge starts at
+	 * @param via vertex where the turn is
+	 * @param to vertex the second edge leads to
+	 * @return time of the turn, in seconds (0 if there is no rule, INT_INFINITY if it is forbidden)
+	 */
+	double getTurnTime(const Vertex<RoadNode>* from, const Vertex<RoadNode>* via, const Vertex<RoadNode>* to) const;
+
+public:
+	/**
+	 * Creates an expansion of a graph with no turn rules
+	 * @param graph the graph (its vertices and edges must not change while the expansion is used)
+	 */
+	TurnGraph(Graph<RoadNode> &graph);
+
+	/**
+	 * Loads the turn rules from a file, replacing the ones loaded before
+	 * @param file name of the file (see TurnGraph)
+	 * @return true if the rules were loaded, false if a line is invalid (after printing it; no rules are left)
+	 */
+	bool load(const string &file);
+
+	/**
+	 * Sets the weight of the turns in the current metric of the graph, which the other weights come from
+	 * @param perSecond weight of a second of turning (0 for distances, 1 for times)
+	 */
+	void customize(double perSecond);
+
+	/**
+	 * Gets the amount of rules loaded
+	 * @return value of TurnGraph::numRules
+	 */
+	int getNumRules() const;
+
+	/**
+	 * Gets the amount of turn states
+	 * @return the amount of states added to the vertices of the graph
+	 */
+	int getNumStates() const;
+
+	/**
+	 * Gets the time spent turning along a path
+	 * @param path the nodes of the path
+	 * @return sum of the times of its turns, in seconds (forbidden turns count as 0)
+	 */
+	double getPathTurnTime(const vector<RoadNode> &path) const;
+
+	/**
+	 * Computes the shortest paths from a vertex to all the others, obeying the turn rules and adding their weights
+	 * @param s content of the source vertex (which may be left by any edge)
+	 * @return the tree, with the vertices followed by the turn states
+	 */
+	sp_tree_t computeShortestPathTree(const RoadNode &s) const;
+};
+
+#endif /* TURNGRAPH_H_ */
@@ -0,0 +1,157 @@
+#include "ViewSession.h"
+#include <unordered_set>
+
+#ifdef __linux__
+#include <signal.h>
+#endif
+
+ViewSession::ViewSession(int width, int height, const string &background): nextEdgeID(0)
+{
+	gv = new GraphViewer(width, height, false);
+	while(!gv->setBackground(background));
+	while(!gv->createWindow(width, height));
+	gv->beginBatch();
+	gv->defineVertexColor("blue");
+	gv->defineVertexSize(5);
+	gv->defineEdgeColor("black");
+	gv->defineEdgeCurved(false);
+	gv->endBatch();
+}
+
+ViewSession::~ViewSession()
+{
+	gv->closeWindow();
+	delete(gv);
+#ifdef __linux__
+	close(GraphViewer::port -1);
+	kill(GraphViewer::procId, SIGTERM);
+#else
+	system("taskkill /im java.exe /f");
+#endif
+}
+
+long long ViewSession::edgeKey(int from, int to)
+{
+	return (static_cast<long long>(from) << 32) | static_cast<unsigned int>(to);
+}
+
+void ViewSession::clear()
+{
+	nodes.clear();
+	edges.clear();
+}
+
+void ViewSession::addNode(int id, int x, int y, const string &color, const string &label)
+{
+	view_node_t &n = nodes[id];
+	n.x = x;
+	n.y = y;
+	n.color = color;
+	n.label = label;
+}
+
+void ViewSession::addEdge(int from, int to, int weight)
+{
+	view_edge_t &e = edges[edgeKey(from, to)];
+	e.id = -1;
+	e.from = from;
+	e.to = to;
+	e.weight = weight;
+}
+
+bool ViewSession::show()
+{
+	bool changed = false;
+	gv->beginBatch();
+
+	//GraphViewer cannot move a node, so a node that moved is removed (with its edges) and added again
+	unordered_set<int> moved;
+	for (unordered_map<int, view_node_t>::iterator it = drawnNodes.begin(); it != drawnNodes.end(); it++)
+	{
+		unordered_map<int, view_node_t>::iterator n = nodes.find(it->first);
+		if (n != nodes.end() && (n->second.x != it->second.x || n->second.y != it->second.y))
+			moved.insert(it->first);
+	}
+
+	for (unordered_map<long long, view_edge_t>::iterator it = drawnEdges.begin(); it != drawnEdges.end(); )
+	{
+		if (edges.find(it->first) == edges.end() || moved.count(it->second.from) || moved.count(it->second.to))
+		{
+			gv->removeEdge(it->second.id);
+			it = drawnEdges.erase(it);
+			changed = true;
+		}
+		else
+			it++;
+	}
+	for (unordered_map<int, view_node_t>::iterator it = drawnNodes.begin(); it != drawnNodes.end(); )
+	{
+		if (nodes.find(it->first) == nodes.end() || moved.count(it->first))
+		{
+			gv->removeNode(it->first);
+			it = drawnNodes.erase(it);
+			changed = true;
+		}
+		else
+			it++;
+	}
+
+	for (unordered_map<int, view_node_t>::iterator it = nodes.begin(); it != nodes.end(); it++)
+	{
+		const view_node_t &n = it->second;
+		unordered_map<int, view_node_t>::iterator d = drawnNodes.find(it->first);
+		if (d == drawnNodes.end())
+		{
+			gv->addNode(it->first, n.x, n.y);
+			if (n.color != "")
+				gv->setVertexColor(it->first, n.color);
+			if (n.label != "")
+				gv->setVertexLabel(it->first, n.label);
+			drawnNodes[it->first] = n;
+			changed = true;
+			continue;
+		}
+		if (d->second.color != n.color)
+		{
+			if (n.color == "")
+				gv->clearVertexColor(it->first);
+			else
+				gv->setVertexColor(it->first, n.color);
+			changed = true;
+		}
+		if (d->second.label != n.label)
+		{
+			if (n.label == "")
+				gv->clearVertexLabel(it->first);
+			else
+				gv->setVertexLabel(it->first, n.label);
+			changed = true;
+		}
+		d->second = n;
+	}
+
+	for (unordered_map<long long, view_edge_t>::iterator it = edges.begin(); it != edges.end(); it++)
+	{
+		const view_edge_t &e = it->second;
+		unordered_map<long long, view_edge_t>::iterator d = drawnEdges.find(it->first);
+		if (d == drawnEdges.end())
+		{
+			view_edge_t drawn = e;
+			drawn.id = nextEdgeID++;
+			gv->addEdge(drawn.id, e.from, e.to, EdgeType::DIRECTED);
+			gv->setEdgeWeight(drawn.id, e.weight);
+			drawnEdges[it->first] = drawn;
+			changed = true;
+		}
+		else if (d->second.weight != e.weight)
+		{
+			gv->setEdgeWeight(d->second.id, e.weight);
+			d->second.weight = e.weight;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		gv->rearrange();
+	return gv->endBatch();
+}
@@ -0,0 +1,99 @@
+#ifndef VIEWSESSION_H_
+#define VIEWSESSION_H_
+
+#include "graphviewer.h"
+#include <string>
+#include <unordered_map>
+
+/**
+ * A node drawn (or to be drawn) on GraphViewer
+ */
+struct view_node_t
+{
+	int x;					/// x coordinate (in pixels of the background)
+	int y;					/// y coordinate (in pixels of the background)
+	string color;			/// color of the node, or "" for the default color
+	string label;			/// label of the node, or "" for no label
+};
+
+/**
+ * A directed edge drawn (or to be drawn) on GraphViewer
+ */
+struct view_edge_t
+{
+	int id;					/// id of the edge on GraphViewer (only meaningful for drawn edges)
+	int from;				/// id of the source node
+	int to;					/// id of the destination node
+	int weight;				/// weight shown on the edge
+};
+
+/**
+ * A GraphViewer window that stays open for the whole run of the program. Each display describes the nodes and
+ * edges it wants to show (with ids that are stable between displays, such as the indexes of the vertices) and
+ * the session only sends the differences to what is already drawn, so no window or Java process is restarted.
+ * Example: v.clear(); v.addNode(0, 10, 10, RED, "A"); v.addNode(1, 20, 20); v.addEdge(0, 1, 5); v.show();
+ */
+class ViewSession
+{
+private:
+	GraphViewer* gv;								/// The window
+	unordered_map<int, view_node_t> drawnNodes;		/// Nodes on the window, by id
+	unordered_map<long long, view_edge_t> drawnEdges;	/// Edges on the window, by ViewSession::edgeKey
+	unordered_map<int, view_node_t> nodes;			/// Nodes of the next display, by id
+	unordered_map<long long, view_edge_t> edges;	/// Edges of the next display, by ViewSession::edgeKey
+	int nextEdgeID;									/// Id given to the next edge added to the window
+
+	/**
+	 * Gets the key of an edge, which identifies it by its end nodes
+	 * @param from id of the source node
+	 * @param to id of the destination node
+	 * @return the key of the edge
+	 */
+	static long long edgeKey(int from, int to);
+
+public:
+	/**
+	 * Starts GraphViewer and opens its window, which stays open until the session is deleted
+	 * @param width width of the window (and of the background)
+	 * @param height height of the window (and of the background)
+	 * @param background path of the background picture
+	 */
+	ViewSession(int width, int height, const string &background);
+
+	/**
+	 * Closes the window and terminates GraphViewer
+	 */
+	~ViewSession();
+
+	/**
+	 * Starts describing a new display, with no nodes or edges (the window is only changed by ViewSession::show)
+	 */
+	void clear();
+
+	/**
+	 * Adds a node to the next display, or changes it if it was already added
+	 * @param id id of the node, which must identify the same place in all displays
+	 * @param x x coordinate of the node
+	 * @param y y coordinate of the node
+	 * @param color color of the node, or "" for the default color
+	 * @param label label of the node, or "" for no label
+	 */
+	void addNode(int id, int x, int y, const string &color = "", const string &label = "");
+
+	/**
+	 * Adds a directed edge to the next display, or changes its weight if it was already added
+	 * (only one edge is shown between each ordered pair of nodes)
+	 * @param from id of the source node, added with ViewSession::addNode
+	 * @param to id of the destination node, added with ViewSession::addNode
+	 * @param weight weight shown on the edge
+	 */
+	void addEdge(int from, int to, int weight);
+
+	/**
+	 * Updates the window to show the nodes and edges added since the last call to ViewSession::clear
+	 * @return true if every change was made, false otherwise
+	 */
+	bool show();
+};
+
+#endif /* VIEWSESSION_H_ */
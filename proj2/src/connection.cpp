@@ -1,5 +1,12 @@
 #include "connection.h"
 
+#define CON_BLOCK 65536        /* bytes sent or received at once */
+#define CON_MAX_PENDING 2048   /* queued messages allowed to wait for their reply */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 void myerror(string msg) {
   printf("%s\n", msg.c_str());
   exit(-1);
@@ -54,21 +61,98 @@ Connection::Connection(short port) {
 }
 
 bool Connection::sendMsg(string msg) {
-  int res = send(sock, msg.c_str(), msg.size(), 0);
-  if (res < 0) 
+  if (!pending.empty()) {
+    vector<string> f = collectReplies();
+    failed.insert(failed.end(), f.begin(), f.end());
+  }
+  if (!sendAll(msg))
     myerror("Unable to send");
   string answer = readLine();
   return answer == "ok";
 }
 
 string Connection::readLine() {
-  string msg;  
-  char ch;
-  while (true) {
-    recv(sock, &ch, 1, 0);
-    if (ch == '\n')
-      break;
-    msg.push_back(ch);
-  }
+  size_t end;
+  while ((end = inBuffer.find('\n')) == string::npos)
+    if (!receive(true)) {
+      string msg = inBuffer;
+      inBuffer.clear();
+      return msg;
+    }
+  string msg = inBuffer.substr(0, end);
+  inBuffer.erase(0, end + 1);
   return msg;
 }
+
+void Connection::queueMsg(string msg) {
+  outBuffer += msg;
+  pending.push_back(msg);
+  if (outBuffer.size() >= CON_BLOCK)
+    flush();
+  /* Never let too many replies wait, or the other side may block writing
+     them while we block writing more messages */
+  if (pending.size() > CON_MAX_PENDING) {
+    flush();
+    while (pending.size() > CON_MAX_PENDING / 2 && receive(true))
+      matchReplies();
+  }
+}
+
+bool Connection::flush() {
+  bool res = sendAll(outBuffer);
+  outBuffer.clear();
+  while (receive(false))
+    ;
+  matchReplies();
+  return res;
+}
+
+vector<string> Connection::collectReplies() {
+  flush();
+  while (!pending.empty() && receive(true))
+    matchReplies();
+  /* replies that never arrived (closed connection) count as failures */
+  failed.insert(failed.end(), pending.begin(), pending.end());
+  pending.clear();
+  vector<string> res;
+  res.swap(failed);
+  return res;
+}
+
+bool Connection::sendAll(const string &data) {
+  for (size_t sent = 0; sent < data.size(); ) {
+    int res = send(sock, data.c_str() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (res <= 0)
+      return false;
+    sent += res;
+  }
+  return true;
+}
+
+bool Connection::receive(bool wait) {
+  if (!wait) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(sock, &fds);
+    struct timeval timeout = { 0, 0 };
+    if (select(sock + 1, &fds, NULL, NULL, &timeout) <= 0)
+      return false;
+  }
+  char block[CON_BLOCK];
+  int res = recv(sock, block, CON_BLOCK, 0);
+  if (res <= 0)
+    return false;
+  inBuffer.append(block, res);
+  return true;
+}
+
+void Connection::matchReplies() {
+  size_t start = 0, end;
+  while (!pending.empty() && (end = inBuffer.find('\n', start)) != string::npos) {
+    if (inBuffer.compare(start, end - start, "ok") != 0)
+      failed.push_back(pending.front());
+    pending.pop_front();
+    start = end + 1;
+  }
+  inBuffer.erase(0, start);
+}
@@ -10,11 +10,14 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netdb.h>
+#include <sys/select.h>
 #else
 #include <winsock2.h>
 #endif
 
 #include <string>
+#include <vector>
+#include <deque>
 #include <iostream>
 
 using namespace std;
@@ -25,12 +28,27 @@ class Connection {
 
   bool sendMsg(string msg);
   string readLine();
+
+  // Pipelined messages: they are sent in blocks without waiting for each reply,
+  // and the replies are matched to them (in order) as they arrive
+  void queueMsg(string msg);
+  bool flush();
+  // Waits for the replies of all queued messages, returning the ones not answered "ok"
+  vector<string> collectReplies();
  private: 
 #ifdef __linux__
   int sock;
 #else
   SOCKET sock;
 #endif
+  string outBuffer;        // queued messages not sent yet
+  string inBuffer;         // received data not read yet
+  deque<string> pending;   // queued messages whose reply was not read yet
+  vector<string> failed;   // queued messages whose reply was not "ok"
+
+  bool sendAll(const string &data);
+  bool receive(bool wait);
+  void matchReplies();
 };
 
 #endif
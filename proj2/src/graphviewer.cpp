@@ -17,6 +17,7 @@ GraphViewer::GraphViewer(int width, int height, bool dynamic, int port_n) {
 }
 
 void GraphViewer::initialize(int width, int height, bool dynamic, int port_n) {
+	this->batching = false;
 	this->width = width;
 	this->height = height;
 	this->isDynamic = dynamic;
@@ -83,14 +84,14 @@ bool GraphViewer::createWindow(int width, int height) {
 	char buff[200];
 	sprintf(buff, "createWindow %d %d\n", width, height);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::closeWindow() {
 	char buff[200];
 	sprintf(buff, "closeWindow\n");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::addNode(int id) {
@@ -106,7 +107,7 @@ bool GraphViewer::addNode(int id) {
 	char buff[200];
 	sprintf(buff, "addNode1 %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::addNode(int id, int x, int y) {
@@ -119,212 +120,234 @@ bool GraphViewer::addNode(int id, int x, int y) {
 	char buff[200];
 	sprintf(buff, "addNode3 %d %d %d\n", id, x, y);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::addEdge(int id, int v1, int v2, int edgeType) {
 	char buff[200];
 	sprintf(buff, "addEdge %d %d %d %d\n", id, v1, v2, edgeType);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeLabel(int k, string label) {
 	char buff[200];
 	sprintf(buff, "setEdgeLabel %d %s\n", k, label.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearEdgeLabel(int id) {
 	char buff[200];
 	sprintf(buff, "clearEdgeLabel %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setVertexLabel(int k, string label) {
 	char buff[200];
 	sprintf(buff, "setVertexLabel %d %s\n", k, label.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearVertexLabel(int id) {
 	char buff[200];
 	sprintf(buff, "clearVertexLabel %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineEdgeColor(string color) {
 	char buff[200];
 	sprintf(buff, "defineEdgeColor %s\n", color.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::resetEdgeColor() {
 	char buff[200];
 	sprintf(buff, "resetEdgeColor\n");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::removeNode(int id) {
 	char buff[200];
 	sprintf(buff, "removeNode %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::removeEdge(int id) {
 	char buff[200];
 	sprintf(buff, "removeEdge %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeColor(int k, string color) {
 	char buff[200];
 	sprintf(buff, "setEdgeColor %d %s\n", k, color.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearEdgeColor(int id) {
 	char buff[200];
 	sprintf(buff, "clearEdgeColor %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineEdgeDashed(bool dashed) {
 	char buff[200];
 	sprintf(buff, "defineEdgeDashed %s\n", dashed? "true" : "false");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeDashed(int k, bool dashed) {
 	char buff[200];
 	sprintf(buff, "setEdgeDashed %d %s\n", k, dashed? "true" : "false");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineEdgeCurved(bool curved) {
 	char buff[200];
 	sprintf(buff, "defineEdgeCurved %s\n", curved? "true" : "false");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeThickness(int k, int thickness) {
 	char buff[200];
 	sprintf(buff, "setEdgeThickness %d %d\n", k, thickness);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineVertexColor(string color) {
 	char buff[200];
 	sprintf(buff, "defineVertexColor %s\n", color.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::resetVertexColor() {
 	char buff[200];
 	sprintf(buff, "resetVertexColor\n");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setVertexColor(int k, string color) {
 	char buff[200];
 	sprintf(buff, "setVertexColor %d %s\n", k, color.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearVertexColor(int id) {
 	char buff[200];
 	sprintf(buff, "clearVertexColor %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineVertexIcon(string filepath) {
 	char buff[200];
 	sprintf(buff, "defineVertexIcon %s\n", filepath.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::resetVertexIcon() {
 	char buff[200];
 	sprintf(buff, "resetVertexIcon\n");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setVertexIcon(int k, string filepath) {
 	char buff[200];
 	sprintf(buff, "setVertexIcon %d %s\n", k, filepath.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearVertexIcon(int id) {
 	char buff[200];
 	sprintf(buff, "clearVertexIcon %d\n", id);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::defineVertexSize(int size) {
 	char buff[200];
 	sprintf(buff, "defineVertexSize %d\n", size);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setVertexSize(int k, int size) {
 	char buff[200];
 	sprintf(buff, "setVertexSize %d %d\n", k, size);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setBackground(string path) {
 	char buff[200];
 	sprintf(buff, "setBackground %s\n", path.c_str());
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::clearBackground() {
 	char buff[200];
 	sprintf(buff, "clearBackground\n");
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeWeight(int id, int weight) {
 	char buff[200];
 	sprintf(buff, "setEdgeWeight %d %d\n", id, weight);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::setEdgeFlow(int id, int flow) {
 	char buff[200];
 	sprintf(buff, "setEdgeFlow %d %d\n", id, flow);
 	string str(buff);
-	return con->sendMsg(str);
+	return dispatch(str);
 }
 
 bool GraphViewer::rearrange() {
-	return con->sendMsg("rearrange\n");
+	return dispatch("rearrange\n");
+}
+
+void GraphViewer::beginBatch() {
+	batching = true;
+}
+
+bool GraphViewer::endBatch() {
+	batching = false;
+	vector<string> failed = con->collectReplies();
+	for (int i = 0; i < GV_BATCH_RETRIES && !failed.empty(); i++) {
+		for (size_t j = 0; j < failed.size(); j++)
+			con->queueMsg(failed[j]);
+		failed = con->collectReplies();
+	}
+	return failed.empty();
+}
+
+bool GraphViewer::dispatch(string str) {
+	if (!batching)
+		return con->sendMsg(str);
+	con->queueMsg(str);
+	return true;
 }
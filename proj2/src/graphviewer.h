@@ -29,6 +29,8 @@
 #define LIGHT_GRAY "LIGHT_GRAY"
 #define MAGENTA "MAGENTA"
 
+#define GV_BATCH_RETRIES 3	//times the commands of a batch that failed are sent again
+
 /**
  * Classe que guarda o grafo e o representa. Todas as suas funções retornam um booleano a indicar
  * se a sua execução decorreu ou não com sucesso.
@@ -368,6 +370,22 @@ public:
 	 */
 	bool rearrange();
 
+	/**
+	 * Função que inicia um lote de comandos. A partir daqui, as funções de desenho não esperam pela
+	 * resposta a cada comando: os comandos são enviados em blocos e as respostas lidas à medida que chegam,
+	 * pelo que as funções retornam sempre true. O sucesso dos comandos é verificado em endBatch().
+	 * Exemplo: gv->beginBatch(); gv->addNode(0, 10, 10); gv->addNode(1, 20, 20); gv->endBatch();
+	 */
+	void beginBatch();
+
+	/**
+	 * Função que termina um lote de comandos, esperando pelas respostas a todos eles e enviando de novo
+	 * os que falharam (até GV_BATCH_RETRIES vezes).
+	 *
+	 * @return true se todos os comandos do lote foram executados com sucesso, false caso contrário.
+	 */
+	bool endBatch();
+
 #ifdef __linux__
 	static pid_t procId;
 #endif
@@ -375,9 +393,12 @@ public:
 private:
 	int width, height;
 	bool isDynamic;
+	bool batching;
 
 	Connection *con;
 
+	bool dispatch(string str);
+
 	void initialize(int, int, bool, int);
 };
 
@@ -2,43 +2,88 @@
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <string>
 #include "Program.h"
+#include "Server.h"
 #include "Exceptions.h"
 
 using namespace std;
 
 #define NO_ARGS 1
 #define ARGS 6
+#define BATCH_NO_ARGS 4
+#define BATCH_ARGS 9
+#define SERVE_NO_ARGS 3			//the number of workers is optional, in both forms
+#define SERVE_ARGS 8
 
 int main(int argc, char** argv)
 {
-	if (argc != ARGS && argc != NO_ARGS)
+	//"--turns file" may be given anywhere, and is taken out before the other arguments are counted
+	string turnsFile = "";
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (string(argv[i]) != "--turns")
+			continue;
+		turnsFile = argv[i + 1];
+		for (int j = i; j + 2 < argc; j++)
+			argv[j] = argv[j + 2];
+		argc -= 2;
+		break;
+	}
+
+	bool batch = (argc > 1 && string(argv[1]) == "--batch");
+	bool serve = (argc > 1 && string(argv[1]) == "--serve");
+	bool workersGiven = serve && (argc == SERVE_NO_ARGS + 1 || argc == SERVE_ARGS + 1);
+	if ((!batch && !serve && argc != ARGS && argc != NO_ARGS) || (batch && argc != BATCH_ARGS && argc != BATCH_NO_ARGS) ||
+		(serve && argc - workersGiven != SERVE_ARGS && argc - workersGiven != SERVE_NO_ARGS))
 	{
 		cout << "Invalid number of arguments!\n";
 		cout << "Usage: proj2 nodes_file road_info_file road_file markets_file map_file\n";
 		cout << "       or simply proj1 to use the default files in ./res\n";
+		cout << "       proj2 --batch job_file output_file [nodes_file road_info_file road_file markets_file map_file]\n";
+		cout << "       to run a job without user interaction or GraphViewer (output_file is CSV if it ends in .csv, JSON otherwise)\n";
+		cout << "       proj2 --serve port|socket_path [workers] [nodes_file road_info_file road_file markets_file map_file]\n";
+		cout << "       to answer routing requests from other programs (see Server.h)\n";
+		cout << "Any of them may also take --turns turns_file, with turn costs and restrictions for the routes (see TurnGraph.h)\n";
 		return 1;
 	}
 
 	srand(time(NULL));
 
 	Program* p;
+	char* filenames[] = { "", "res/nodes.txt", "res/road_info.txt",
+							"res/roads.txt", "res/markets.txt", "res/map.txt" };
 
 	try
 	{
-		if (argc == ARGS)
+		if (batch)
+			p = new Program(argc == BATCH_ARGS ? argv + 3 : filenames, false);
+		else if (serve)
+			p = new Program(argc - workersGiven == SERVE_ARGS ? argv + 2 + workersGiven : filenames, false);
+		else if (argc == ARGS)
 			p = new Program(argv);
 		else
-		{
-			char* filenames[] = { "", "res/nodes.txt", "res/road_info.txt",
-									"res/roads.txt", "res/markets.txt", "res/map.txt" };
 			p = new Program(filenames);
-		}
 	}
-	catch(FileNotFound &ex)
+	catch(FileNotFound* ex)
+	{
+		cout << "File " << ex->filename << " not found, terminating...\n";
+		return 1;
+	}
+	if (turnsFile != "" && !p->loadTurns(turnsFile))
+		return 1;
+
+	if (batch)
+		return p->runBatch(argv[2], argv[3]) ? 0 : 1;
+	if (serve)
 	{
-		cout << "File " << ex.filename << " not found, terminating...\n";
+#ifdef __linux__
+		Server server(*p, workersGiven ? atoi(argv[3]) : 0);
+		return server.run(argv[2]) ? 0 : 1;
+#else
+		cout << "The server is only available on Linux\n";
 		return 1;
+#endif
 	}
 
 	try